@@ -1,12 +1,14 @@
 #include "application.h"
 #include "builtin_plugins/load_builtin_plugins.h"
+#include "codegen_report.h"
+#include "gui/circuit_cost.h"
 #include "gui/composite_node/composite_node_plugin.h"
 #include "gui/configuration_widget.h"
 #include "gui/control_node_widgets/load_control_plugins.h"
 #include "gui/factory_widget.h"
 #include "helpers/layout_builder.h"
 #include "patch_browser.h"
-#include "plugin_system/package_loader.h"
+#include "plugin_system/node_widget_factory_builder.h"
 #include "voice_mode_selector.h"
 
 namespace Gammou
@@ -16,6 +18,7 @@ namespace Gammou
         const configuration& config,
         synthesizer& synth,
         std::unique_ptr<View::widget>&& additional_toolbox)
+    :   _synthesizer{synth}
     {
         _factory = node_widget_factory_builder{synth.get_llvm_context()}
             .load_packages(config.packages_path)
@@ -30,6 +33,34 @@ namespace Gammou
 
         //  Prepare synthesizer to use plugins
         synth.add_library_module(_factory->module());
+
+        //  Describe the master circuit nodes using their plugins properties
+        synth.set_master_node_info_provider(
+            [this](const DSPJIT::compile_node_class& node)
+            {
+                master_branches::node_info info{};
+                const auto& widgets = _configuration_widget->master_circuit_editor().node_widgets();
+                const auto it = widgets.find(&node);
+                if (it == widgets.end())
+                    return info;
+
+                const auto cost = estimate_node_cost(*_factory, *it->second);
+                info.cycles = cost.cycles;
+                info.stateless = (cost.state_bytes == 0u);
+
+                const auto *plugin_node = dynamic_cast<const plugin_node_widget*>(it->second);
+                if (plugin_node != nullptr) {
+                    if (auto *plugin = _factory->get_plugin(plugin_node->id()))
+                        info.silence_inputs = plugin->silence_inputs();
+                }
+
+                return info;
+            });
+    }
+
+    application::~application()
+    {
+        _synthesizer.set_master_node_info_provider({});
     }
 
     nlohmann::json application::serialize()
@@ -43,6 +74,20 @@ namespace Gammou
         _voice_mode_selector->sync();
     }
 
+    nlohmann::json application::codegen_report()
+    {
+        return {
+            {"master", make_codegen_report(
+                *_factory,
+                _configuration_widget->master_circuit_editor(),
+                _synthesizer.get_master_circuit_controller())},
+            {"polyphonic", make_codegen_report(
+                *_factory,
+                _configuration_widget->polyphonic_circuit_editor(),
+                _synthesizer.get_polyphonic_circuit_controller())}
+        };
+    }
+
     View::widget& application::main_gui() noexcept
     {
         return *_main_gui;
@@ -20,6 +20,7 @@ namespace Gammou {
             const configuration& config,
             synthesizer& synth,
             std::unique_ptr<View::widget>&& additional_toolbox = {});
+        ~application();
 
         /**
          * \brief Serialize application state to json object
@@ -31,6 +32,12 @@ namespace Gammou {
          */
         void deserialize(const nlohmann::json& json);
 
+        /**
+         * \brief Build the code generation report of the master and polyphonic circuits
+         * \see make_codegen_report
+         */
+        nlohmann::json codegen_report();
+
         /**
          * \brief Get a reference on the gui main widget
          */
@@ -45,6 +52,7 @@ namespace Gammou {
             synthesizer& synth,
             std::unique_ptr<View::widget>&& additional_toolbox);
 
+        synthesizer& _synthesizer;
         std::unique_ptr<node_widget_factory> _factory{};
         configuration_widget *_configuration_widget{nullptr};
         voice_mode_selector *_voice_mode_selector{nullptr};
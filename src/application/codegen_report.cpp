@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <map>
+#include <unordered_set>
+
+#include "codegen_report.h"
+#include "gui/composite_node/composite_node_widget.h"
+
+namespace Gammou {
+
+    static nlohmann::json remark_to_json(const optimization_remark& remark)
+    {
+        return {
+            {"kind", remark_kind_name(remark.type)},
+            {"pass", remark.pass},
+            {"name", remark.name},
+            {"function", remark.function},
+            {"message", remark.message}
+        };
+    }
+
+    static bool remark_involves(const optimization_remark& remark, const std::vector<function_statistics>& functions)
+    {
+        return std::any_of(
+            remark.symbols.begin(), remark.symbols.end(),
+            [&functions](const std::string& symbol)
+            {
+                return std::any_of(
+                    functions.begin(), functions.end(),
+                    [&symbol](const function_statistics& stat) { return stat.name == symbol; });
+            });
+    }
+
+    class codegen_report_builder {
+    public:
+        codegen_report_builder(node_widget_factory& factory, const std::vector<optimization_remark>& remarks)
+        :   _factory{factory}, _remarks{remarks}
+        {}
+
+        nlohmann::json nodes_report(const circuit_editor& editor)
+        {
+            auto nodes = nlohmann::json::array();
+
+            for (const auto& pair : editor.node_widgets()) {
+                const auto *widget = pair.second;
+
+                if (widget->is_internal())
+                    continue;
+
+                nodes.push_back(_node_report(*widget));
+            }
+
+            return nodes;
+        }
+
+        /**
+         *  The statistics are the ones of the plugin module functions, which are shared by all the
+         *  instances of the plugin : each used plugin is reported once, with its instance count.
+         */
+        nlohmann::json plugins_report()
+        {
+            auto plugins = nlohmann::json::array();
+
+            for (const auto& pair : _plugin_instance_counts) {
+                auto *plugin = _factory.get_plugin(pair.first);
+                if (plugin == nullptr)
+                    continue;
+
+                const auto& functions = plugin->statistics();
+                auto functions_report = nlohmann::json::array();
+                std::size_t instruction_count = 0u;
+                std::size_t code_bytes = 0u;
+
+                for (const auto& stat : functions) {
+                    functions_report.push_back({
+                        {"name", stat.name},
+                        {"instruction-count", stat.instruction_count},
+                        {"code-bytes", stat.code_bytes}});
+                    instruction_count += stat.instruction_count;
+                    code_bytes += stat.code_bytes;
+                }
+
+                auto remarks_report = nlohmann::json::array();
+                for (auto i = 0u; i < _remarks.size(); ++i) {
+                    if (remark_involves(_remarks[i], functions)) {
+                        remarks_report.push_back(remark_to_json(_remarks[i]));
+                        _attributed_remarks.insert(i);
+                    }
+                }
+
+                _total_instruction_count += instruction_count;
+                _total_code_bytes += code_bytes;
+
+                plugins.push_back({
+                    {"plugin-uid", pair.first},
+                    {"name", plugin->name()},
+                    {"instance-count", pair.second},
+                    {"plugin-instruction-count", instruction_count},
+                    {"plugin-code-bytes", code_bytes},
+                    {"functions", std::move(functions_report)},
+                    {"remarks", std::move(remarks_report)}});
+            }
+
+            return plugins;
+        }
+
+        nlohmann::json unattributed_remarks() const
+        {
+            auto remarks = nlohmann::json::array();
+
+            for (auto i = 0u; i < _remarks.size(); ++i) {
+                if (_attributed_remarks.count(i) == 0u)
+                    remarks.push_back(remark_to_json(_remarks[i]));
+            }
+
+            return remarks;
+        }
+
+        auto total_instruction_count() const noexcept { return _total_instruction_count; }
+        auto total_code_bytes() const noexcept { return _total_code_bytes; }
+
+    private:
+        nlohmann::json _node_report(const node_widget& widget)
+        {
+            nlohmann::json report{{"name", widget.name()}};
+            const auto *plugin_node = dynamic_cast<const plugin_node_widget*>(&widget);
+
+            if (plugin_node == nullptr)
+                return report;
+
+            report["plugin-uid"] = plugin_node->id();
+
+            if (const auto *composite = dynamic_cast<const composite_node_widget*>(plugin_node))
+                report["nodes"] = nodes_report(composite->internal_editor());
+            else
+                _plugin_instance_counts[plugin_node->id()]++;
+
+            return report;
+        }
+
+        node_widget_factory& _factory;
+        const std::vector<optimization_remark>& _remarks;
+        std::map<node_widget_factory::plugin_id, std::size_t> _plugin_instance_counts{};
+        std::unordered_set<std::size_t> _attributed_remarks{};
+        std::size_t _total_instruction_count{0u};
+        std::size_t _total_code_bytes{0u};
+    };
+
+    nlohmann::json make_codegen_report(
+        node_widget_factory& factory,
+        const circuit_editor& editor,
+        const synthesizer::circuit_controller& controller)
+    {
+        const auto& remarks = controller.get_optimization_remarks();
+        codegen_report_builder builder{factory, remarks};
+
+        auto nodes = builder.nodes_report(editor);
+        auto plugins = builder.plugins_report();
+        const auto missed_count =
+            std::count_if(
+                remarks.begin(), remarks.end(),
+                [](const optimization_remark& remark) { return remark.type == optimization_remark::kind::MISSED; });
+
+        return {
+            {"nodes", std::move(nodes)},
+            {"plugins", std::move(plugins)},
+            {"unattributed-remarks", builder.unattributed_remarks()},
+            {"summary", {
+                {"plugin-instruction-count", builder.total_instruction_count()},
+                {"plugin-code-bytes", builder.total_code_bytes()},
+                {"remark-count", remarks.size()},
+                {"missed-remark-count", missed_count}}}
+        };
+    }
+
+}
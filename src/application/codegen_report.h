@@ -0,0 +1,30 @@
+#ifndef GAMMOU_CODEGEN_REPORT_H_
+#define GAMMOU_CODEGEN_REPORT_H_
+
+#include <nlohmann/json.hpp>
+
+#include "gui/circuit_editor.h"
+#include "plugin_system/node_widget_factory.h"
+#include "synthesizer/synthesizer.h"
+
+namespace Gammou {
+
+    /**
+     * \brief Build a code generation report of a circuit.
+     *  The nodes are listed with their plugin, composite nodes with their internal nodes.
+     *  For each plugin used by the circuit : its instance count, the IR instruction count and native
+     *  code size of its module functions, and the optimization remarks involving these functions
+     *  during the last circuit compilation. The functions are shared by the plugin instances and
+     *  measured in the plugin module, before being linked and optimized in the circuit program :
+     *  the sizes are per plugin, not per node, and are not summed per instance.
+     * \note Remarks are only available if the codegen report was enabled on the synthesizer
+     *  \see synthesizer::enable_codegen_report
+     */
+    nlohmann::json make_codegen_report(
+        node_widget_factory& factory,
+        const circuit_editor& editor,
+        const synthesizer::circuit_controller& controller);
+
+}
+
+#endif /* GAMMOU_CODEGEN_REPORT_H_ */
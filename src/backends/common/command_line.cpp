@@ -0,0 +1,34 @@
+
+#include <DSPJIT/log.h>
+
+#include "command_line.h"
+
+namespace Gammou {
+
+    std::optional<int> parse_command_line(cxxopts::Options& parser, int argc, char **argv, const options_reader& reader)
+    {
+        parser.add_options()
+            ("h,help", "Print help")
+        ;
+
+        try {
+            const auto parsed_arguments = parser.parse(argc, argv);
+
+            if (parsed_arguments.count("help") > 0) {
+                LOG_INFO("%s\n", parser.help().c_str());
+                return 0;
+            }
+
+            reader(parsed_arguments);
+            return std::nullopt;
+        }
+        catch (std::exception& error)
+        {
+            LOG_WARNING("%s\n", error.what());
+        }
+
+        LOG_INFO("%s\n", parser.help().c_str());
+        return 1;
+    }
+
+}
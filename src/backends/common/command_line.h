@@ -0,0 +1,26 @@
+#ifndef GAMMOU_COMMAND_LINE_H_
+#define GAMMOU_COMMAND_LINE_H_
+
+#include <cxxopts.hpp>
+#include <functional>
+#include <optional>
+
+namespace Gammou {
+
+    /**
+     *  @brief Read the parsed arguments into the tool options
+     *  @throw std::exception if the arguments are not valid
+     */
+    using options_reader = std::function<void(const cxxopts::ParseResult&)>;
+
+    /**
+     *  @brief Add the help option to the parser, parse the command line and read the options.
+     *  The usage is printed when it is requested or when the arguments are not valid.
+     *  @return std::nullopt if the tool must run, otherwise its exit code :
+     *      0 when only the usage was requested, 1 when the arguments are not valid
+     */
+    std::optional<int> parse_command_line(cxxopts::Options& parser, int argc, char **argv, const options_reader& reader);
+
+}
+
+#endif
@@ -8,6 +8,7 @@ namespace Gammou
     struct application_options
     {
         bool no_gui{false};
+        std::optional<std::filesystem::path> log_file{};   //<< Where the real time logs are written, stdout by default
         Gammou::desktop_application::configuration configuration;
     };
 
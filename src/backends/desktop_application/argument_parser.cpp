@@ -1,8 +1,8 @@
 
 #include <cxxopts.hpp>
 #include <string>
-#include <DSPJIT/log.h>
 
+#include "backends/common/command_line.h"
 #include "backends/common/default_configuration.h"
 #include "argument_parser.h"
 
@@ -12,6 +12,12 @@ namespace Gammou
     static constexpr auto patch_opt_key = "patch";
     static constexpr auto package_path_opt = "packages-path";
     static constexpr auto patch_path_opt_key = "patchs-path";
+    static constexpr auto voice_memory_cap_opt_key = "voice-memory-cap";
+    static constexpr auto max_voices_opt_key = "max-voices";
+    static constexpr auto calibrate_opt_key = "calibrate";
+    static constexpr auto log_file_opt_key = "log-file";
+    static constexpr auto master_threads_opt_key = "master-threads";
+    static constexpr auto pipelined_opt_key = "pipelined";
 
     static void fill_options(const cxxopts::ParseResult& parsed_arguments, application_options& options)
     {
@@ -33,9 +39,30 @@ namespace Gammou
         else
             options.configuration.application_config.patchs_path =
                 Gammou::default_configuration::get_patch_path();
+
+        if (parsed_arguments.count(voice_memory_cap_opt_key) > 0)
+            options.configuration.synthesizer_config.voice_memory_cap =
+                parsed_arguments[voice_memory_cap_opt_key].as<std::size_t>() * 1024u * 1024u;
+
+        if (parsed_arguments.count(max_voices_opt_key) > 0)
+            options.configuration.synthesizer_config.max_voices =
+                parsed_arguments[max_voices_opt_key].as<std::size_t>();
+
+        if (parsed_arguments.count(master_threads_opt_key) > 0)
+            options.configuration.synthesizer_config.master_branches_config.worker_count =
+                parsed_arguments[master_threads_opt_key].as<std::size_t>();
+
+        if (parsed_arguments.count(pipelined_opt_key) > 0)
+            options.configuration.synthesizer_config.pipelined_processing = true;
+
+        if (parsed_arguments.count(calibrate_opt_key) > 0)
+            options.configuration.calibrate = true;
+
+        if (parsed_arguments.count(log_file_opt_key) > 0)
+            options.log_file = parsed_arguments[log_file_opt_key].as<std::string>();
     }
 
-    bool parse_options(int argc, char **argv, application_options& options)
+    std::optional<int> parse_options(int argc, char **argv, application_options& options)
     {
         // Parse command line options
         cxxopts::Options parser("Gammou", "Gammou command line interface");
@@ -45,24 +72,19 @@ namespace Gammou
             (patch_opt_key, "Load a patch", cxxopts::value<std::string>())
             (package_path_opt, "Packages directory path", cxxopts::value<std::string>())
             (patch_path_opt_key, "Patchs directory path", cxxopts::value<std::string>())
-            ("h,help", "Print help")
+            (voice_memory_cap_opt_key, "Maximum voice states memory (MB)", cxxopts::value<std::size_t>())
+            (max_voices_opt_key, "Maximum number of voices played at the same time", cxxopts::value<std::size_t>())
+            (master_threads_opt_key, "Threads processing the master circuit branches in addition to the audio thread, 0 (default) to disable", cxxopts::value<std::size_t>())
+            (pipelined_opt_key, "Process the voices and the master circuit on two threads, with one block of latency, midi and parameters being applied per block")
+            (calibrate_opt_key, "Suggest a voice count for the initial patch on this machine")
+            (log_file_opt_key, "Write the sound processing logs to this file", cxxopts::value<std::string>())
         ;
 
-        try {
-            const auto parsed_arguments = parser.parse(argc, argv);
-            if (!parsed_arguments.count("help"))
+        return parse_command_line(parser, argc, argv,
+            [&options](const cxxopts::ParseResult& parsed_arguments)
             {
                 fill_options(parsed_arguments, options);
-                return true;
-            }
-        }
-        catch (std::exception& error)
-        {
-            LOG_WARNING("%s\n", error.what());
-        }
-
-        LOG_INFO("%s\n", parser.help().c_str());
-        return false;
+            });
     }
 
 }
\ No newline at end of file
@@ -1,11 +1,16 @@
 #ifndef GAMMOU_ARGUMENT_PARSER_H_
 #define GAMMOU_ARGUMENT_PARSER_H_
 
+#include <optional>
+
 #include "application_options.h"
 
 namespace Gammou
 {
-    bool parse_options(int argc, char **argv, application_options& options);
+    /**
+     *  \return std::nullopt if the application must run, otherwise its exit code
+     */
+    std::optional<int> parse_options(int argc, char **argv, application_options& options);
 }
 
 #endif /* GAMMOU_ARGUMENT_PARSER_H_ */
\ No newline at end of file
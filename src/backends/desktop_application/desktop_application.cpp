@@ -10,9 +10,45 @@
 #include "helpers/layout_builder.h"
 #include "plugin_system/package_loader.h"
 #include "synthesizer/midi_parser.h"
+#include "utils/denormals.h"
+#include "utils/rt_check.h"
 
 namespace Gammou {
 
+    /**
+     *  \brief Show the voice budget set by the load governor.
+     *  The synthesizer notifications are collected when the label is drawn, on the gui thread :
+     *  the control changes are dispatched and the load governor actions are reported at the display frame rate.
+     */
+    class synthesizer_monitor_label : public View::label {
+    public:
+        synthesizer_monitor_label(synthesizer& synth)
+        :   View::label{"Voice budget: " + std::to_string(synth.get_voice_count())},
+            _synthesizer{synth}
+        {
+        }
+
+        void draw(NVGcontext *vg) override
+        {
+            _synthesizer.dispatch_control_changes();
+            _synthesizer.poll_load_governor_actions(
+                [this](const load_governor::action& action)
+                {
+                    LOG_INFO("[desktop application] Load governor : %s to %zu voices (load %.0f%%)\n",
+                        load_governor_action_name(action.kind), action.voice_budget, action.load * 100.f);
+                    set_text("Voice budget: " + std::to_string(action.voice_budget));
+                });
+
+            View::label::draw(vg);
+
+            //  Keep collecting while displayed
+            invalidate();
+        }
+
+    private:
+        synthesizer& _synthesizer;
+    };
+
     desktop_application::desktop_application(
         const configuration& config)
     : _synthesizer{_llvm_context, config.synthesizer_config}
@@ -27,7 +63,7 @@ namespace Gammou {
             builder.horizontal<false>(
                 builder.header(_make_midi_device_widget()),
                 builder.header(_make_audio_device_widget()),
-                builder.header(_make_debug_toolbox())
+                builder.header(_make_debug_toolbox(config.application_config.patchs_path))
             );
 
         // initialize application
@@ -59,6 +95,9 @@ namespace Gammou {
             }
         }
 
+        if (config.calibrate)
+            _synthesizer.calibrate_voice_count();
+
         //  display
         _display = View::create_application_display(_application->main_gui(), 1);
     }
@@ -155,6 +194,9 @@ namespace Gammou {
             [](void *output_buffer, void *input_buffer, unsigned int sample_count,
                 double stream_time, RtAudioStreamStatus status, void *user_data)
             {
+                scoped_denormals_flush denormals_flush{};
+                realtime_scope rt_scope{};
+
                 auto& synth = *(synthesizer*)(user_data);
                 synth.update_program(); //  avoid to update for every samples
                 synth.process_buffer(sample_count, nullptr, static_cast<float*>(output_buffer));
@@ -292,7 +334,7 @@ namespace Gammou {
         return midi_settings_widget;
     }
 
-    std::unique_ptr<View::widget> desktop_application::_make_debug_toolbox()
+    std::unique_ptr<View::widget> desktop_application::_make_debug_toolbox(const std::filesystem::path& patch_path)
     {
         // Enable/disable ir dump on logs
         auto dump_ir_box = std::make_unique<View::checkbox>();
@@ -304,11 +346,56 @@ namespace Gammou {
                 _synthesizer.enable_ir_dump(checked);
             });
 
+        // Enable/disable optimization remarks collection
+        auto codegen_report_box = std::make_unique<View::checkbox>();
+        codegen_report_box->set_callback(
+            [this](bool checked)
+            {
+                LOG_INFO("[desktop application] %s codegen report\n",
+                    checked ? "enable" : "disable");
+                _synthesizer.enable_codegen_report(checked);
+            });
+
+        // Export the codegen report of the last compiled circuits, relative to the patch directory
+        auto report_name_input = std::make_unique<View::text_input>();
+        auto export_report_button = std::make_unique<View::text_push_button>("Export codegen report");
+        report_name_input->set_text("codegen_report.json");
+        export_report_button->set_callback(
+            [this, input = report_name_input.get(), patch_path]
+            {
+                const auto report_path = patch_path / input->get_text();
+                std::ofstream stream{report_path, std::ios_base::out};
+
+                if (stream.good()) {
+                    stream << _application->codegen_report().dump(4);
+                    LOG_INFO("[desktop application] Codegen report written to '%s'\n",
+                        report_path.generic_string().c_str());
+                }
+                else {
+                    LOG_ERROR("[desktop application] Unable to write codegen report to '%s'\n",
+                        report_path.generic_string().c_str());
+                }
+            });
+
+        // Sound processing memory statistics
+        const auto& memory_stats = _synthesizer.get_dsp_memory_statistics();
+        const auto memory_text =
+            "Dsp memory: " + std::to_string(memory_stats.used / 1024u) + "/" +
+            std::to_string(memory_stats.capacity / 1024u) + " KB (" +
+            memory_backing_name(memory_stats.memory_backing) + ")";
+
         View::layout_builder builder{};
         return builder.vertical(
+            std::make_unique<View::label>(memory_text),
+            std::make_unique<synthesizer_monitor_label>(_synthesizer),
             builder.horizontal(
                 std::move(dump_ir_box),
                 std::make_unique<View::label>("Enable ir dump")),
+            builder.horizontal(
+                std::move(codegen_report_box),
+                std::make_unique<View::label>("Enable codegen report")),
+            std::move(report_name_input),
+            std::move(export_report_button),
             builder.empty_space());
     }
 
@@ -23,6 +23,7 @@ namespace Gammou {
             synthesizer::configuration synthesizer_config{};
             application::configuration application_config{};
             std::optional<std::filesystem::path> initial_path{};
+            bool calibrate{false};  //<< Suggest a voice count for the initial patch
         };
 
         desktop_application(
@@ -48,7 +49,7 @@ namespace Gammou {
         // toolbox construction
         std::unique_ptr<View::widget> _make_audio_device_widget();
         std::unique_ptr<View::widget> _make_midi_device_widget();
-        std::unique_ptr<View::widget> _make_debug_toolbox();
+        std::unique_ptr<View::widget> _make_debug_toolbox(const std::filesystem::path& patch_path);
 
         /*
          *  Members
@@ -5,9 +5,23 @@
 #include <DSPJIT/log.h>
 #include "application_options.h"
 #include "argument_parser.h"
+#include "utils/rt_log.h"
 
 static int run_desktop_application(const Gammou::application_options& options)
 {
+    auto& logger = Gammou::realtime_logger::instance();
+    try {
+        if (options.log_file.has_value())
+            logger.start(options.log_file.value());
+    }
+    catch (const std::exception& error)
+    {
+        LOG_ERROR("%s\n", error.what());
+    }
+
+    //  Does nothing if already started
+    logger.start();
+
     Gammou::desktop_application app{options.configuration};
 
     if (options.no_gui) {
@@ -27,8 +41,8 @@ static int run_desktop_application(const Gammou::application_options& options)
 int main(int argc, char **argv)
 {
     Gammou::application_options options;
-    if (Gammou::parse_options(argc, argv, options))
-        return run_desktop_application(options);
+    if (const auto exit_code = Gammou::parse_options(argc, argv, options))
+        return exit_code.value();
     else
-        return 1;
+        return run_desktop_application(options);
 }
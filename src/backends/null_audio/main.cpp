@@ -0,0 +1,263 @@
+
+#include <cxxopts.hpp>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include <DSPJIT/log.h>
+#include "backends/common/command_line.h"
+#include "backends/common/default_configuration.h"
+#include "builtin_plugins/load_core_plugins.h"
+#include "midi_script_player.h"
+#include "null_audio_driver.h"
+#include "plugin_system/headless_patch.h"
+#include "plugin_system/package_loader.h"
+#include "utils/denormals.h"
+#include "utils/rt_check.h"
+#include "utils/rt_log.h"
+
+namespace Gammou
+{
+    static constexpr auto patch_opt_key = "patch";
+    static constexpr auto midi_opt_key = "midi";
+    static constexpr auto loop_midi_opt_key = "loop-midi";
+    static constexpr auto duration_opt_key = "duration";
+    static constexpr auto sample_rate_opt_key = "sample-rate";
+    static constexpr auto buffer_size_opt_key = "buffer-size";
+    static constexpr auto jitter_opt_key = "jitter";
+    static constexpr auto seed_opt_key = "seed";
+    static constexpr auto report_opt_key = "report";
+    static constexpr auto max_deadline_misses_opt_key = "max-deadline-misses";
+    static constexpr auto package_path_opt = "packages-path";
+    static constexpr auto voice_count_opt_key = "voice-count";
+    static constexpr auto master_threads_opt_key = "master-threads";
+    static constexpr auto pipelined_opt_key = "pipelined";
+    static constexpr auto no_load_governor_opt_key = "no-load-governor";
+    static constexpr auto log_file_opt_key = "log-file";
+
+    struct null_audio_options
+    {
+        std::filesystem::path patch_path{};
+        std::optional<std::filesystem::path> midi_path{};
+        bool loop_midi{false};
+        float duration{10.f};                                           //<< Seconds
+        std::optional<std::filesystem::path> report_path{};
+        std::optional<std::size_t> max_deadline_misses{};
+        std::filesystem::path packages_path{};
+        std::optional<std::filesystem::path> log_file{};
+        synthesizer::configuration synthesizer_config{};
+        null_audio_driver::settings driver_settings{};
+    };
+
+    static void fill_options(const cxxopts::ParseResult& parsed_arguments, null_audio_options& options)
+    {
+        if (parsed_arguments.count(patch_opt_key) == 0u)
+            throw std::invalid_argument("The patch option is required");
+
+        options.patch_path = parsed_arguments[patch_opt_key].as<std::string>();
+        if (parsed_arguments.count(midi_opt_key) > 0)
+            options.midi_path = parsed_arguments[midi_opt_key].as<std::string>();
+        options.loop_midi = parsed_arguments.count(loop_midi_opt_key) > 0;
+        options.duration = parsed_arguments[duration_opt_key].as<float>();
+
+        if (parsed_arguments.count(report_opt_key) > 0)
+            options.report_path = parsed_arguments[report_opt_key].as<std::string>();
+        if (parsed_arguments.count(max_deadline_misses_opt_key) > 0)
+            options.max_deadline_misses = parsed_arguments[max_deadline_misses_opt_key].as<std::size_t>();
+
+        if (parsed_arguments.count(package_path_opt) > 0)
+            options.packages_path = parsed_arguments[package_path_opt].as<std::string>();
+        else
+            options.packages_path = default_configuration::get_packages_directory_path();
+
+        auto& driver_settings = options.driver_settings;
+        driver_settings.sample_rate = static_cast<float>(parsed_arguments[sample_rate_opt_key].as<unsigned int>());
+        driver_settings.buffer_size = parsed_arguments[buffer_size_opt_key].as<std::size_t>();
+        driver_settings.max_jitter = std::chrono::microseconds{parsed_arguments[jitter_opt_key].as<unsigned int>()};
+        driver_settings.jitter_seed = parsed_arguments[seed_opt_key].as<unsigned int>();
+
+        auto& synth_config = options.synthesizer_config;
+        synth_config.sample_rate = driver_settings.sample_rate;
+
+        if (parsed_arguments.count(voice_count_opt_key) > 0)
+            synth_config.voice_count = parsed_arguments[voice_count_opt_key].as<unsigned int>();
+        if (parsed_arguments.count(master_threads_opt_key) > 0)
+            synth_config.master_branches_config.worker_count = parsed_arguments[master_threads_opt_key].as<std::size_t>();
+        if (parsed_arguments.count(pipelined_opt_key) > 0)
+            synth_config.pipelined_processing = true;
+        if (parsed_arguments.count(no_load_governor_opt_key) > 0)
+            synth_config.enable_load_governor = false;
+
+        if (parsed_arguments.count(log_file_opt_key) > 0)
+            options.log_file = parsed_arguments[log_file_opt_key].as<std::string>();
+    }
+
+    static std::optional<int> parse_options(int argc, char **argv, null_audio_options& options)
+    {
+        cxxopts::Options parser("gammou_null_audio", "Play a patch on a simulated audio device and report the missed deadlines");
+
+        parser.add_options()
+            (patch_opt_key, "Patch to be played", cxxopts::value<std::string>())
+            (midi_opt_key, "Standard midi file injected into the synthesizer", cxxopts::value<std::string>())
+            (loop_midi_opt_key, "Replay the midi file until the end of the test")
+            (duration_opt_key, "Test duration (s)", cxxopts::value<float>()->default_value("10"))
+            (sample_rate_opt_key, "Sample rate (Hz)", cxxopts::value<unsigned int>()->default_value("48000"))
+            (buffer_size_opt_key, "Samples per callback, in [32, 4096]", cxxopts::value<std::size_t>()->default_value("512"))
+            (jitter_opt_key, "Maximum random delay of the callbacks start (us)", cxxopts::value<unsigned int>()->default_value("0"))
+            (seed_opt_key, "Seed of the jitter random generator", cxxopts::value<unsigned int>()->default_value("0"))
+            (report_opt_key, "Write the statistics to this json file", cxxopts::value<std::string>())
+            (max_deadline_misses_opt_key, "Exit with an error code when more deadlines are missed", cxxopts::value<std::size_t>())
+            (package_path_opt, "Packages directory path", cxxopts::value<std::string>())
+            (voice_count_opt_key, "Maximum number of voices", cxxopts::value<unsigned int>())
+            (master_threads_opt_key, "Threads processing the master circuit branches in addition to the audio thread, 0 (default) to disable", cxxopts::value<std::size_t>())
+            (pipelined_opt_key, "Process the voices and the master circuit on two threads, with one block of latency, midi and parameters being applied per block")
+            (no_load_governor_opt_key, "Do not adapt the voice count to the load")
+            (log_file_opt_key, "Write the sound processing logs to this file", cxxopts::value<std::string>())
+        ;
+
+        return parse_command_line(parser, argc, argv,
+            [&options](const cxxopts::ParseResult& parsed_arguments)
+            {
+                fill_options(parsed_arguments, options);
+            });
+    }
+
+    static nlohmann::json make_report(
+        const null_audio_options& options,
+        const null_audio_driver::statistics& stats,
+        std::size_t played_event_count)
+    {
+        const auto to_us = [](std::chrono::nanoseconds d) { return static_cast<double>(d.count()) * 1e-3; };
+
+        auto histogram = nlohmann::json::array();
+        for (auto i = 0u; i < stats.duration_histogram.size(); ++i) {
+            histogram.push_back({
+                {"load-percent", i * null_audio_driver::statistics::histogram_bucket_width},
+                {"count", stats.duration_histogram[i]}});
+        }
+
+        return {
+            {"patch", options.patch_path.generic_string()},
+            {"sample-rate", options.driver_settings.sample_rate},
+            {"buffer-size", options.driver_settings.buffer_size},
+            {"jitter-us", options.driver_settings.max_jitter.count()},
+            {"period-us", to_us(stats.period)},
+            {"callback-count", stats.callback_count},
+            {"deadline-misses", stats.deadline_miss_count},
+            {"xruns", stats.xrun_count},
+            {"average-callback-us", to_us(stats.average_callback_duration())},
+            {"peak-callback-us", to_us(stats.max_callback_duration)},
+            {"max-start-delay-us", to_us(stats.max_start_delay)},
+            {"midi-events", played_event_count},
+            {"callback-histogram", std::move(histogram)}
+        };
+    }
+
+    static int run_null_audio(const null_audio_options& options)
+    {
+        auto& logger = realtime_logger::instance();
+        if (options.log_file.has_value())
+            logger.start(options.log_file.value());
+        logger.start();
+
+        llvm::LLVMContext llvm_context;
+        synthesizer synth{llvm_context, options.synthesizer_config};
+
+        //  Check the driver settings before the packages are loaded
+        const auto& driver_settings = options.driver_settings;
+        null_audio_driver driver{driver_settings, synth.get_output_count()};
+
+        auto factory = package_loader{llvm_context}
+            .load_packages(options.packages_path)
+            .build();
+        load_core_plugins(synth, *factory);
+        synth.add_library_module(factory->module());
+
+        headless_patch patch{synth, *factory};
+
+        nlohmann::json json;
+        std::ifstream stream{options.patch_path, std::ios_base::in};
+        if (!stream.good())
+            throw std::invalid_argument("Unable to open the patch file '" + options.patch_path.generic_string() + "'");
+        stream >> json;
+        patch.deserialize(json);
+
+        std::vector<midi_file_event> events{};
+        if (options.midi_path.has_value()) {
+            events = load_midi_file(options.midi_path.value());
+            LOG_INFO("[gammou null audio] Loaded %zu midi events from '%s'\n",
+                events.size(), options.midi_path->generic_string().c_str());
+        }
+
+        midi_script_player midi_player{events, driver_settings.sample_rate, options.loop_midi};
+
+        synth.set_sample_rate(driver_settings.sample_rate);
+        driver.start(
+            [&synth, &midi_player](float *output, std::size_t frame_count)
+            {
+                scoped_denormals_flush denormals_flush{};
+                realtime_scope rt_scope{};
+
+                synth.update_program();
+                midi_player.process(synth, frame_count, output);
+            });
+
+        //  The control plane runs as in the desktop application, concurrently with the audio callbacks
+        const auto end = std::chrono::steady_clock::now() + std::chrono::duration<float>(options.duration);
+        while (std::chrono::steady_clock::now() < end) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{33});
+            synth.dispatch_control_changes();
+            synth.poll_load_governor_actions(
+                [](const load_governor::action& action)
+                {
+                    LOG_INFO("[gammou null audio] Load governor : %s to %zu voices (load %.0f%%)\n",
+                        load_governor_action_name(action.kind), action.voice_budget, action.load * 100.f);
+                });
+        }
+
+        driver.stop();
+
+        const auto& stats = driver.get_statistics();
+        const auto to_us = [](std::chrono::nanoseconds d) { return static_cast<double>(d.count()) * 1e-3; };
+        const auto period_us = to_us(stats.period);
+
+        LOG_INFO("[gammou null audio] %zu callbacks of %zu samples at %.0f Hz, period %.1f us\n",
+            stats.callback_count, driver_settings.buffer_size, driver_settings.sample_rate, period_us);
+        LOG_INFO("[gammou null audio] Callback cost : average %.1f us (%.1f%%), peak %.1f us (%.1f%%)\n",
+            to_us(stats.average_callback_duration()), 100. * to_us(stats.average_callback_duration()) / period_us,
+            to_us(stats.max_callback_duration), 100. * to_us(stats.max_callback_duration) / period_us);
+        LOG_INFO("[gammou null audio] Deadline misses : %zu, xruns : %zu, max start delay %.1f us\n",
+            stats.deadline_miss_count, stats.xrun_count, to_us(stats.max_start_delay));
+
+        if (options.report_path.has_value()) {
+            std::ofstream report_stream{options.report_path.value(), std::ios_base::out};
+            if (!report_stream.good())
+                throw std::runtime_error("Unable to write the report to '" + options.report_path->generic_string() + "'");
+            report_stream << make_report(options, stats, midi_player.played_event_count()).dump(4);
+        }
+
+        if (options.max_deadline_misses.has_value() && stats.deadline_miss_count > options.max_deadline_misses.value()) {
+            LOG_ERROR("[gammou null audio] More than %zu deadlines were missed\n", options.max_deadline_misses.value());
+            return 2;
+        }
+
+        return 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Gammou::null_audio_options options;
+    if (const auto exit_code = Gammou::parse_options(argc, argv, options))
+        return exit_code.value();
+
+    try {
+        return Gammou::run_null_audio(options);
+    }
+    catch (const std::exception& error)
+    {
+        LOG_ERROR("[gammou null audio] %s\n", error.what());
+        return 1;
+    }
+}
@@ -0,0 +1,52 @@
+#include <algorithm>
+#include <cmath>
+
+#include "midi_script_player.h"
+#include "synthesizer/midi_parser.h"
+
+namespace Gammou {
+
+    midi_script_player::midi_script_player(const std::vector<midi_file_event>& events, float sample_rate, bool loop)
+    :   _loop{loop && !events.empty()}
+    {
+        _events.reserve(events.size());
+
+        for (const auto& event : events) {
+            const auto frame = static_cast<std::size_t>(std::llround(std::max(event.time, 0.) * sample_rate));
+            _events.push_back({frame, event.data, event.size});
+        }
+
+        //  A loop iteration ends right after the last event
+        _sequence_length = _events.empty() ? 0u : _events.back().frame + 1u;
+    }
+
+    void midi_script_player::process(synthesizer& synth, std::size_t frame_count, float *output)
+    {
+        const auto channel_count = synth.get_output_count();
+
+        for (std::size_t offset = 0u; offset < frame_count;) {
+            for (; _next_event < _events.size() && _events[_next_event].frame <= _position; ++_next_event) {
+                const auto& event = _events[_next_event];
+                execute_midi_msg(synth, event.data.data(), event.size);
+                _played_event_count++;
+            }
+
+            if (_loop && _next_event == _events.size() && _position >= _sequence_length) {
+                _position = 0u;
+                _next_event = 0u;
+                continue;
+            }
+
+            auto chunk_size = frame_count - offset;
+            if (_next_event < _events.size())
+                chunk_size = std::min(chunk_size, _events[_next_event].frame - _position);
+            else if (_loop)
+                chunk_size = std::min(chunk_size, _sequence_length - _position);
+
+            synth.process_buffer(chunk_size, nullptr, output + offset * channel_count);
+            offset += chunk_size;
+            _position += chunk_size;
+        }
+    }
+
+}
@@ -0,0 +1,48 @@
+#ifndef GAMMOU_MIDI_SCRIPT_PLAYER_H_
+#define GAMMOU_MIDI_SCRIPT_PLAYER_H_
+
+#include <vector>
+
+#include "synthesizer/synthesizer.h"
+#include "utils/midi_file.h"
+
+namespace Gammou {
+
+    /**
+     * \class midi_script_player
+     * \brief Inject a scripted midi sequence into a synthesizer from the audio callback.
+     *
+     *  The events are sample accurate : the processed buffers are split in chunks at the event offsets.
+     *  When looping, the sequence is replayed as soon as its last event was played.
+     */
+    class midi_script_player {
+    public:
+        midi_script_player(const std::vector<midi_file_event>& events, float sample_rate, bool loop);
+
+        /**
+         *  \brief Process frame_count frames into the interleaved output buffer, executing the events on time
+         *  \note Must be called from the sound processing thread
+         */
+        void process(synthesizer& synth, std::size_t frame_count, float *output);
+
+        std::size_t played_event_count() const noexcept { return _played_event_count; }
+
+    private:
+        struct scheduled_event
+        {
+            std::size_t frame;      //<< Offset from the beginning of the sequence
+            std::array<uint8_t, 3u> data;
+            uint8_t size;
+        };
+
+        std::vector<scheduled_event> _events{};
+        const bool _loop;
+        std::size_t _sequence_length{0u};       //<< In frames, a loop iteration duration
+        std::size_t _position{0u};              //<< In the current loop iteration
+        std::size_t _next_event{0u};
+        std::size_t _played_event_count{0u};
+    };
+
+}
+
+#endif /* GAMMOU_MIDI_SCRIPT_PLAYER_H_ */
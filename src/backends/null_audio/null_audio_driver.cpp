@@ -0,0 +1,135 @@
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "null_audio_driver.h"
+
+namespace Gammou {
+
+    std::chrono::nanoseconds null_audio_driver::statistics::average_callback_duration() const noexcept
+    {
+        if (callback_count == 0u)
+            return std::chrono::nanoseconds{0};
+        return total_duration / static_cast<std::chrono::nanoseconds::rep>(callback_count);
+    }
+
+    static const null_audio_driver::settings& check_settings(const null_audio_driver::settings& s)
+    {
+        if (!(s.sample_rate > 0.f))
+            throw std::invalid_argument("null_audio_driver : invalid sample rate");
+        if (s.buffer_size < null_audio_driver::min_buffer_size || s.buffer_size > null_audio_driver::max_buffer_size)
+            throw std::invalid_argument(
+                "null_audio_driver : the buffer size must be in [" + std::to_string(null_audio_driver::min_buffer_size) +
+                ", " + std::to_string(null_audio_driver::max_buffer_size) + "]");
+        if (s.max_jitter.count() < 0 || s.spin_duration.count() < 0)
+            throw std::invalid_argument("null_audio_driver : negative durations are not valid");
+        return s;
+    }
+
+    null_audio_driver::null_audio_driver(const settings& s, unsigned int channel_count)
+    :   _settings{check_settings(s)},
+        _channel_count{channel_count},
+        _period{std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::duration<double>(static_cast<double>(s.buffer_size) / s.sample_rate))}
+    {
+    }
+
+    null_audio_driver::~null_audio_driver()
+    {
+        stop();
+    }
+
+    void null_audio_driver::start(callback cb)
+    {
+        stop();
+
+        _statistics = statistics{};
+        _statistics.period = _period;
+        _running = true;
+        _thread = std::thread{
+            [this, cb = std::move(cb)]()
+            {
+                _run(cb);
+            }};
+    }
+
+    void null_audio_driver::stop()
+    {
+        _running = false;
+        if (_thread.joinable())
+            _thread.join();
+    }
+
+    bool null_audio_driver::is_running() const noexcept
+    {
+        return _running.load(std::memory_order_relaxed);
+    }
+
+    void null_audio_driver::_run(const callback& cb)
+    {
+        using clock = std::chrono::steady_clock;
+
+        std::vector<float> buffer(_settings.buffer_size * _channel_count);
+        std::mt19937 random_generator{_settings.jitter_seed};
+        std::uniform_int_distribution<std::chrono::nanoseconds::rep> jitter_distribution{
+            0, std::chrono::duration_cast<std::chrono::nanoseconds>(_settings.max_jitter).count()};
+
+        auto period_start = clock::now();
+
+        while (_running.load(std::memory_order_relaxed)) {
+            _wait_until(period_start + std::chrono::nanoseconds{jitter_distribution(random_generator)});
+
+            const auto start = clock::now();
+            cb(buffer.data(), _settings.buffer_size);
+            const auto end = clock::now();
+
+            const auto deadline = period_start + _period;
+            _record_callback(start - period_start, end - start, end > deadline);
+            period_start = deadline;
+
+            //  The next period is already over : the buffers which could not be delivered are dropped
+            if (end > period_start + _period) {
+                const auto dropped_period_count = (end - period_start) / _period;
+                _statistics.xrun_count += dropped_period_count;
+                period_start += dropped_period_count * _period;
+            }
+        }
+    }
+
+    void null_audio_driver::_record_callback(
+        std::chrono::nanoseconds start_delay, std::chrono::nanoseconds duration, bool deadline_missed)
+    {
+        auto& stats = _statistics;
+
+        stats.callback_count++;
+        stats.total_duration += duration;
+        stats.max_callback_duration = std::max(stats.max_callback_duration, duration);
+        stats.max_start_delay = std::max(stats.max_start_delay, start_delay);
+
+        if (deadline_missed)
+            stats.deadline_miss_count++;
+
+        const auto load_percent = static_cast<std::size_t>(100 * duration.count() / _period.count());
+        const auto bucket = std::min(
+            load_percent / statistics::histogram_bucket_width,
+            statistics::histogram_bucket_count - 1u);
+        stats.duration_histogram[bucket]++;
+    }
+
+    void null_audio_driver::_wait_until(std::chrono::steady_clock::time_point time) const
+    {
+        using clock = std::chrono::steady_clock;
+
+        //  The sleep wake up is not precise enough : the end of the wait is spent spinning
+        const auto sleep_end = time - _settings.spin_duration;
+        if (clock::now() < sleep_end)
+            std::this_thread::sleep_until(sleep_end);
+
+        while (clock::now() < time)
+            ;
+    }
+
+}
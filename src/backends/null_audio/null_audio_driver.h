@@ -0,0 +1,97 @@
+#ifndef GAMMOU_NULL_AUDIO_DRIVER_H_
+#define GAMMOU_NULL_AUDIO_DRIVER_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+namespace Gammou {
+
+    /**
+     * \class null_audio_driver
+     * \brief A simulated audio device, which calls the audio callback on a precise timer without sound hardware.
+     *
+     *  A callback is started every buffer period, possibly delayed by a random jitter, and must return before
+     *  the end of its period, when a real device would play the buffer. The driver reports the deadline misses,
+     *  the callback durations and the xruns : as a real driver, it drops the periods it could not deliver
+     *  in time when it falls more than a period behind.
+     */
+    class null_audio_driver {
+    public:
+        static constexpr std::size_t min_buffer_size = 32u;
+        static constexpr std::size_t max_buffer_size = 4096u;
+
+        /**
+         *  \brief Process frame_count frames into the interleaved output buffer
+         */
+        using callback = std::function<void(float *output, std::size_t frame_count)>;
+
+        struct settings
+        {
+            float sample_rate{48000.f};
+            std::size_t buffer_size{512u};                      //<< In [min_buffer_size, max_buffer_size]
+            std::chrono::microseconds max_jitter{0};            //<< Callbacks start up to max_jitter late
+            std::chrono::microseconds spin_duration{200};       //<< Busy wait before each callback, for a precise start
+            unsigned int jitter_seed{0u};
+        };
+
+        struct statistics
+        {
+            //  The callback durations, in percent of the buffer period : 10% wide buckets,
+            //  the last one counting the callbacks longer than twice the period
+            static constexpr unsigned int histogram_bucket_width = 10u;
+            static constexpr std::size_t histogram_bucket_count = 21u;
+
+            std::size_t callback_count{0u};
+            std::size_t deadline_miss_count{0u};                //<< Callbacks which returned after the end of their period
+            std::size_t xrun_count{0u};                         //<< Periods dropped because the driver fell behind
+            std::chrono::nanoseconds period{0};
+            std::chrono::nanoseconds total_duration{0};         //<< Time spent in the callbacks
+            std::chrono::nanoseconds max_callback_duration{0};
+            std::chrono::nanoseconds max_start_delay{0};        //<< Latest callback start, jitter included
+            std::array<std::size_t, histogram_bucket_count> duration_histogram{};
+
+            std::chrono::nanoseconds average_callback_duration() const noexcept;
+        };
+
+        /**
+         *  \throw std::invalid_argument if the sample rate or the buffer size is not valid
+         */
+        null_audio_driver(const settings& s, unsigned int channel_count);
+        ~null_audio_driver();
+
+        null_audio_driver(const null_audio_driver&) = delete;
+        null_audio_driver& operator=(const null_audio_driver&) = delete;
+
+        /**
+         *  \brief Start calling the callback from a new thread, the statistics are reset
+         */
+        void start(callback cb);
+        void stop();
+        bool is_running() const noexcept;
+
+        /**
+         *  \note Must not be called while the driver is running
+         */
+        const statistics& get_statistics() const noexcept { return _statistics; }
+        const settings& get_settings() const noexcept { return _settings; }
+
+    private:
+        void _run(const callback& cb);
+        void _record_callback(std::chrono::nanoseconds start_delay, std::chrono::nanoseconds duration, bool deadline_missed);
+        void _wait_until(std::chrono::steady_clock::time_point time) const;
+
+        const settings _settings;
+        const unsigned int _channel_count;
+        const std::chrono::nanoseconds _period;
+
+        std::thread _thread{};
+        std::atomic<bool> _running{false};
+        statistics _statistics{};
+    };
+
+}
+
+#endif /* GAMMOU_NULL_AUDIO_DRIVER_H_ */
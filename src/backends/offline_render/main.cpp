@@ -0,0 +1,166 @@
+
+#include <cxxopts.hpp>
+#include <fstream>
+#include <optional>
+#include <string>
+
+#include <DSPJIT/log.h>
+#include "backends/common/command_line.h"
+#include "backends/common/default_configuration.h"
+#include "builtin_plugins/load_core_plugins.h"
+#include "offline_renderer.h"
+#include "plugin_system/headless_patch.h"
+#include "plugin_system/package_loader.h"
+#include "utils/rt_log.h"
+
+namespace Gammou
+{
+    static constexpr auto patch_opt_key = "patch";
+    static constexpr auto midi_opt_key = "midi";
+    static constexpr auto output_opt_key = "output";
+    static constexpr auto sample_rate_opt_key = "sample-rate";
+    static constexpr auto block_size_opt_key = "block-size";
+    static constexpr auto tail_opt_key = "tail";
+    static constexpr auto package_path_opt = "packages-path";
+    static constexpr auto voice_count_opt_key = "voice-count";
+    static constexpr auto master_threads_opt_key = "master-threads";
+    static constexpr auto pipelined_opt_key = "pipelined";
+    static constexpr auto log_file_opt_key = "log-file";
+
+    struct render_options
+    {
+        std::filesystem::path patch_path{};
+        std::filesystem::path midi_path{};
+        std::filesystem::path output_path{};
+        std::filesystem::path packages_path{};
+        std::optional<std::filesystem::path> log_file{};
+        synthesizer::configuration synthesizer_config{};
+        offline_renderer::settings render_settings{};
+    };
+
+    static void fill_options(const cxxopts::ParseResult& parsed_arguments, render_options& options)
+    {
+        if (parsed_arguments.count(patch_opt_key) == 0u ||
+            parsed_arguments.count(midi_opt_key) == 0u ||
+            parsed_arguments.count(output_opt_key) == 0u)
+            throw std::invalid_argument("The patch, midi and output options are required");
+
+        options.patch_path = parsed_arguments[patch_opt_key].as<std::string>();
+        options.midi_path = parsed_arguments[midi_opt_key].as<std::string>();
+        options.output_path = parsed_arguments[output_opt_key].as<std::string>();
+
+        if (parsed_arguments.count(package_path_opt) > 0)
+            options.packages_path = parsed_arguments[package_path_opt].as<std::string>();
+        else
+            options.packages_path = default_configuration::get_packages_directory_path();
+
+        auto& synth_config = options.synthesizer_config;
+        synth_config.sample_rate = static_cast<float>(parsed_arguments[sample_rate_opt_key].as<unsigned int>());
+
+        //  Rendering must not depend on the machine load
+        synth_config.enable_load_governor = false;
+
+        if (parsed_arguments.count(voice_count_opt_key) > 0)
+            synth_config.voice_count = parsed_arguments[voice_count_opt_key].as<unsigned int>();
+        if (parsed_arguments.count(master_threads_opt_key) > 0)
+            synth_config.master_branches_config.worker_count = parsed_arguments[master_threads_opt_key].as<std::size_t>();
+        if (parsed_arguments.count(pipelined_opt_key) > 0)
+            synth_config.pipelined_processing = true;
+
+        options.render_settings.block_size = parsed_arguments[block_size_opt_key].as<std::size_t>();
+        options.render_settings.tail_duration = parsed_arguments[tail_opt_key].as<float>();
+
+        if (parsed_arguments.count(log_file_opt_key) > 0)
+            options.log_file = parsed_arguments[log_file_opt_key].as<std::string>();
+    }
+
+    static std::optional<int> parse_options(int argc, char **argv, render_options& options)
+    {
+        cxxopts::Options parser("gammou_render", "Render a patch playing a midi file to a wav file, without audio device");
+
+        parser.add_options()
+            (patch_opt_key, "Patch to be rendered", cxxopts::value<std::string>())
+            (midi_opt_key, "Standard midi file to be played", cxxopts::value<std::string>())
+            (output_opt_key, "Output wav file (32 bits float)", cxxopts::value<std::string>())
+            (sample_rate_opt_key, "Sample rate (Hz)", cxxopts::value<unsigned int>()->default_value("48000"))
+            (block_size_opt_key, "Samples per callback", cxxopts::value<std::size_t>()->default_value("512"))
+            (tail_opt_key, "Duration rendered after the last midi event (s)", cxxopts::value<float>()->default_value("2"))
+            (package_path_opt, "Packages directory path", cxxopts::value<std::string>())
+            (voice_count_opt_key, "Maximum number of voices", cxxopts::value<unsigned int>())
+            (master_threads_opt_key, "Threads processing the master circuit branches in addition to the rendering thread, 0 (default) to disable", cxxopts::value<std::size_t>())
+            (pipelined_opt_key, "Process the voices and the master circuit on two threads, midi and parameters being applied per block")
+            (log_file_opt_key, "Write the sound processing logs to this file", cxxopts::value<std::string>())
+        ;
+
+        return parse_command_line(parser, argc, argv,
+            [&options](const cxxopts::ParseResult& parsed_arguments)
+            {
+                fill_options(parsed_arguments, options);
+            });
+    }
+
+    static int run_render(const render_options& options)
+    {
+        auto& logger = realtime_logger::instance();
+        if (options.log_file.has_value())
+            logger.start(options.log_file.value());
+        logger.start();
+
+        llvm::LLVMContext llvm_context;
+        synthesizer synth{llvm_context, options.synthesizer_config};
+
+        auto factory = package_loader{llvm_context}
+            .load_packages(options.packages_path)
+            .build();
+        load_core_plugins(synth, *factory);
+        synth.add_library_module(factory->module());
+
+        headless_patch patch{synth, *factory};
+
+        nlohmann::json json;
+        std::ifstream stream{options.patch_path, std::ios_base::in};
+        if (!stream.good())
+            throw std::invalid_argument("Unable to open the patch file '" + options.patch_path.generic_string() + "'");
+        stream >> json;
+        patch.deserialize(json);
+
+        const auto events = load_midi_file(options.midi_path);
+        LOG_INFO("[gammou render] Loaded %zu midi events from '%s'\n", events.size(), options.midi_path.generic_string().c_str());
+
+        const auto sample_rate = options.synthesizer_config.sample_rate;
+        wav_writer output{options.output_path, static_cast<unsigned int>(sample_rate), synth.get_output_count()};
+        offline_renderer renderer{synth, sample_rate, options.render_settings};
+
+        const auto stats = renderer.render(events, output);
+        output.close();
+
+        const auto to_us = [](std::chrono::nanoseconds d) { return static_cast<double>(d.count()) * 1e-3; };
+        const auto deadline_us = to_us(stats.callback_deadline);
+
+        LOG_INFO("[gammou render] Rendered %.3f s to '%s'\n",
+            static_cast<double>(stats.frame_count) / sample_rate, options.output_path.generic_string().c_str());
+        LOG_INFO("[gammou render] Real time factor : %.2f\n", stats.realtime_factor(sample_rate));
+        LOG_INFO("[gammou render] Callback cost : average %.1f us (%.1f%%), peak %.1f us (%.1f%%), deadline %.1f us, %zu callbacks\n",
+            to_us(stats.average_callback_duration()), 100. * to_us(stats.average_callback_duration()) / deadline_us,
+            to_us(stats.max_callback_duration), 100. * to_us(stats.max_callback_duration) / deadline_us,
+            deadline_us, stats.callback_count);
+
+        return 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Gammou::render_options options;
+    if (const auto exit_code = Gammou::parse_options(argc, argv, options))
+        return exit_code.value();
+
+    try {
+        return Gammou::run_render(options);
+    }
+    catch (const std::exception& error)
+    {
+        LOG_ERROR("[gammou render] %s\n", error.what());
+        return 1;
+    }
+}
@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <cmath>
+
+#include "offline_renderer.h"
+#include "synthesizer/midi_parser.h"
+#include "utils/denormals.h"
+#include "utils/rt_check.h"
+
+namespace Gammou {
+
+    double offline_renderer::statistics::realtime_factor(float sample_rate) const noexcept
+    {
+        const auto seconds = std::chrono::duration<double>(total_duration).count();
+        return seconds > 0. ? static_cast<double>(frame_count) / sample_rate / seconds : 0.;
+    }
+
+    std::chrono::nanoseconds offline_renderer::statistics::average_callback_duration() const noexcept
+    {
+        if (callback_count == 0u)
+            return std::chrono::nanoseconds{0};
+        return total_duration / static_cast<std::chrono::nanoseconds::rep>(callback_count);
+    }
+
+    offline_renderer::offline_renderer(synthesizer& synth, float sample_rate, const settings& s)
+    :   _synthesizer{synth},
+        _sample_rate{sample_rate},
+        _settings{s}
+    {
+        _synthesizer.set_sample_rate(sample_rate);
+    }
+
+    offline_renderer::statistics offline_renderer::render(const std::vector<midi_file_event>& events, wav_writer& output)
+    {
+        using clock = std::chrono::steady_clock;
+
+        const auto block_size = std::max<std::size_t>(_settings.block_size, 1u);
+        const auto channel_count = _synthesizer.get_output_count();
+        const auto to_frame =
+            [this](double time)
+            {
+                return static_cast<std::size_t>(std::llround(std::max(time, 0.) * _sample_rate));
+            };
+
+        const auto end_time = (events.empty() ? 0. : events.back().time) + _settings.tail_duration;
+        const auto frame_count = to_frame(end_time);
+
+        //  The first latency samples are not written, so that the output is aligned with the events
+        const auto latency = _synthesizer.get_latency();
+        const auto processed_frame_count = frame_count + latency;
+
+        std::vector<float> buffer(block_size * channel_count);
+        statistics stats{};
+        stats.callback_deadline = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::duration<double>(static_cast<double>(block_size) / _sample_rate));
+
+        auto next_event = events.begin();
+        std::size_t skipped_frame_count = 0u;
+
+        for (std::size_t position = 0u; position < processed_frame_count; position += block_size) {
+            const auto callback_size = std::min(block_size, processed_frame_count - position);
+            const auto start = clock::now();
+
+            {
+                scoped_denormals_flush denormals_flush{};
+                realtime_scope rt_scope{};
+
+                _synthesizer.update_program();
+
+                //  Split the callback at the events offsets
+                for (std::size_t offset = 0u; offset < callback_size;) {
+                    for (; next_event != events.end() && to_frame(next_event->time) <= position + offset; ++next_event)
+                        execute_midi_msg(_synthesizer, next_event->data.data(), next_event->size);
+
+                    const auto next_event_offset =
+                        next_event != events.end() ?
+                            std::min(to_frame(next_event->time) - position, callback_size) : callback_size;
+                    const auto chunk_size = next_event_offset - offset;
+
+                    _synthesizer.process_buffer(chunk_size, nullptr, buffer.data() + offset * channel_count);
+                    offset += chunk_size;
+                }
+            }
+
+            const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+            stats.total_duration += duration;
+            stats.max_callback_duration = std::max(stats.max_callback_duration, duration);
+            stats.callback_count++;
+
+            //  Latency compensation
+            const auto skip = std::min(callback_size, latency - skipped_frame_count);
+            skipped_frame_count += skip;
+            output.write(buffer.data() + skip * channel_count, callback_size - skip);
+        }
+
+        stats.frame_count = frame_count;
+        return stats;
+    }
+
+}
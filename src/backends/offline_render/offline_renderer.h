@@ -0,0 +1,60 @@
+#ifndef GAMMOU_OFFLINE_RENDERER_H_
+#define GAMMOU_OFFLINE_RENDERER_H_
+
+#include <chrono>
+#include <vector>
+
+#include "synthesizer/synthesizer.h"
+#include "utils/midi_file.h"
+#include "utils/wav_writer.h"
+
+namespace Gammou {
+
+    /**
+     * \class offline_renderer
+     * \brief Play a midi sequence through a synthesizer as fast as possible, as a host would do with
+     *  fixed size callbacks, and write the output to a wav file.
+     *
+     *  The midi events are sample accurate : a callback is split in chunks at the event offsets.
+     *  The latency of the pipelined processing is compensated.
+     */
+    class offline_renderer {
+    public:
+        struct settings
+        {
+            std::size_t block_size{512u};       //<< Samples per callback
+            float tail_duration{2.f};           //<< Rendered duration after the last midi event (s)
+        };
+
+        struct statistics
+        {
+            std::size_t frame_count{0u};
+            std::size_t callback_count{0u};
+            std::chrono::nanoseconds total_duration{0};         //<< Time spent in the callbacks
+            std::chrono::nanoseconds max_callback_duration{0};
+            std::chrono::nanoseconds callback_deadline{0};      //<< Duration of the audio rendered by one callback
+
+            /**
+             *  \brief Rendered audio duration over processing time
+             */
+            double realtime_factor(float sample_rate) const noexcept;
+            std::chrono::nanoseconds average_callback_duration() const noexcept;
+        };
+
+        offline_renderer(synthesizer& synth, float sample_rate, const settings& s);
+
+        /**
+         *  \brief Render the events, followed by the tail duration
+         *  \throw std::runtime_error if the output could not be written
+         */
+        statistics render(const std::vector<midi_file_event>& events, wav_writer& output);
+
+    private:
+        synthesizer& _synthesizer;
+        const float _sample_rate;
+        const settings _settings;
+    };
+
+}
+
+#endif /* GAMMOU_OFFLINE_RENDERER_H_ */
@@ -0,0 +1,100 @@
+
+#include <csignal>
+#include <cxxopts.hpp>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include <DSPJIT/log.h>
+#include "backends/common/command_line.h"
+#include "backends/common/default_configuration.h"
+#include "render_daemon.h"
+
+namespace Gammou
+{
+    static constexpr auto spool_opt_key = "spool";
+    static constexpr auto workers_opt_key = "workers";
+    static constexpr auto poll_interval_opt_key = "poll-interval";
+    static constexpr auto package_path_opt = "packages-path";
+    static constexpr auto voice_count_opt_key = "voice-count";
+    static constexpr auto pipelined_opt_key = "pipelined";
+
+    static std::atomic<bool> daemon_running{true};
+
+    static void stop_daemon(int)
+    {
+        daemon_running.store(false);
+    }
+
+    static void fill_options(const cxxopts::ParseResult& parsed_arguments, render_daemon::configuration& config)
+    {
+        if (parsed_arguments.count(spool_opt_key) == 0u)
+            throw std::invalid_argument("The spool option is required");
+
+        config.spool_path = parsed_arguments[spool_opt_key].as<std::string>();
+        config.poll_interval = std::chrono::milliseconds{parsed_arguments[poll_interval_opt_key].as<unsigned int>()};
+
+        if (parsed_arguments.count(workers_opt_key) > 0)
+            config.worker_count = parsed_arguments[workers_opt_key].as<std::size_t>();
+        else
+            config.worker_count = std::max(1u, std::thread::hardware_concurrency());
+
+        auto& worker_config = config.worker_config;
+        if (parsed_arguments.count(package_path_opt) > 0)
+            worker_config.packages_path = parsed_arguments[package_path_opt].as<std::string>();
+        else
+            worker_config.packages_path = default_configuration::get_packages_directory_path();
+
+        //  Each worker renders on a single thread : the worker processes already use the cores
+        auto& synth_config = worker_config.synthesizer_config;
+        synth_config.enable_load_governor = false;
+        synth_config.master_branches_config.worker_count = 0u;
+
+        if (parsed_arguments.count(voice_count_opt_key) > 0)
+            synth_config.voice_count = parsed_arguments[voice_count_opt_key].as<unsigned int>();
+        if (parsed_arguments.count(pipelined_opt_key) > 0)
+            synth_config.pipelined_processing = true;
+    }
+
+    static std::optional<int> parse_options(int argc, char **argv, render_daemon::configuration& config)
+    {
+        cxxopts::Options parser("gammou_render_daemon", "Render the jobs submitted to a spool directory with a pool of worker processes");
+
+        parser.add_options()
+            (spool_opt_key, "Spool directory, jobs are submitted to its incoming subdirectory", cxxopts::value<std::string>())
+            (workers_opt_key, "Number of worker processes", cxxopts::value<std::size_t>())
+            (poll_interval_opt_key, "Delay between two scans of the incoming jobs (ms)", cxxopts::value<unsigned int>()->default_value("200"))
+            (package_path_opt, "Packages directory path", cxxopts::value<std::string>())
+            (voice_count_opt_key, "Maximum number of voices", cxxopts::value<unsigned int>())
+            (pipelined_opt_key, "Process the voices and the master circuit on two threads, midi and parameters being applied per block")
+        ;
+
+        return parse_command_line(parser, argc, argv,
+            [&config](const cxxopts::ParseResult& parsed_arguments)
+            {
+                fill_options(parsed_arguments, config);
+            });
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Gammou::render_daemon::configuration config;
+    if (const auto exit_code = Gammou::parse_options(argc, argv, config))
+        return exit_code.value();
+
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, Gammou::stop_daemon);
+    std::signal(SIGTERM, Gammou::stop_daemon);
+
+    try {
+        Gammou::render_daemon daemon{config};
+        daemon.run(Gammou::daemon_running);
+        return 0;
+    }
+    catch (const std::exception& error)
+    {
+        LOG_ERROR("[render daemon] %s\n", error.what());
+        return 1;
+    }
+}
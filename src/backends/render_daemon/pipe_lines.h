@@ -0,0 +1,67 @@
+#ifndef GAMMOU_PIPE_LINES_H_
+#define GAMMOU_PIPE_LINES_H_
+
+#include <cerrno>
+#include <string>
+#include <unistd.h>
+
+namespace Gammou {
+
+    /**
+     * \brief Write a line to a file descriptor, retrying on partial writes
+     * \return false if the descriptor was closed
+     */
+    inline bool write_line(int fd, const std::string& line)
+    {
+        const auto data = line + '\n';
+        std::size_t written = 0u;
+
+        while (written < data.size()) {
+            const auto result = ::write(fd, data.data() + written, data.size() - written);
+            if (result < 0 && errno == EINTR)
+                continue;
+            if (result <= 0)
+                return false;
+            written += static_cast<std::size_t>(result);
+        }
+
+        return true;
+    }
+
+    /**
+     * \brief Move a complete line from a receive buffer to line, without its newline
+     * \return false if the buffer does not contain a complete line yet
+     */
+    inline bool extract_line(std::string& buffer, std::string& line)
+    {
+        const auto end = buffer.find('\n');
+        if (end == std::string::npos)
+            return false;
+
+        line = buffer.substr(0u, end);
+        buffer.erase(0u, end + 1u);
+        return true;
+    }
+
+    /**
+     * \brief Append the available data of a file descriptor to a receive buffer, blocking until some is available
+     * \return false if the descriptor was closed
+     */
+    inline bool receive(int fd, std::string& buffer)
+    {
+        char chunk[4096];
+
+        for (;;) {
+            const auto result = ::read(fd, chunk, sizeof(chunk));
+            if (result < 0 && errno == EINTR)
+                continue;
+            if (result <= 0)
+                return false;
+            buffer.append(chunk, static_cast<std::size_t>(result));
+            return true;
+        }
+    }
+
+}
+
+#endif /* GAMMOU_PIPE_LINES_H_ */
@@ -0,0 +1,309 @@
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <DSPJIT/log.h>
+#include "pipe_lines.h"
+#include "render_daemon.h"
+
+namespace Gammou {
+
+    static constexpr auto incoming_directory = "incoming";
+    static constexpr auto running_directory = "running";
+    static constexpr auto done_directory = "done";
+    static constexpr auto failed_directory = "failed";
+
+    //  How long a stopped worker is given to exit, before being terminated and then killed
+    static constexpr auto worker_exit_grace_period = std::chrono::milliseconds{2000};
+    static constexpr auto worker_exit_poll_interval = std::chrono::milliseconds{10};
+
+    render_daemon::render_daemon(const configuration& config)
+    :   _config{config},
+        _workers(std::max<std::size_t>(config.worker_count, 1u))
+    {
+        for (const auto *name : {incoming_directory, running_directory, done_directory, failed_directory})
+            std::filesystem::create_directories(_spool_directory(name));
+
+        //  Jobs left by a previous instance are rendered again
+        for (const auto& entry : std::filesystem::directory_iterator{_spool_directory(running_directory)}) {
+            if (entry.path().extension() == ".json")
+                std::filesystem::rename(entry.path(), _spool_directory(incoming_directory) / entry.path().filename());
+        }
+
+        for (auto& worker : _workers)
+            _spawn_worker(worker);
+
+        LOG_INFO("[render daemon] Started %zu workers, spool directory '%s'\n",
+            _workers.size(), _config.spool_path.generic_string().c_str());
+    }
+
+    render_daemon::~render_daemon()
+    {
+        for (auto& worker : _workers)
+            _stop_worker(worker);
+
+        LOG_INFO("[render daemon] Stopped : %zu jobs done, %zu failed\n", _completed_count, _failed_count);
+    }
+
+    void render_daemon::run(const std::atomic<bool>& running)
+    {
+        while (running.load()) {
+            _dispatch_jobs();
+            _collect_results(_config.poll_interval);
+        }
+
+        //  Wait for the jobs being rendered
+        const auto busy =
+            [this]()
+            {
+                return std::any_of(_workers.begin(), _workers.end(),
+                    [](const worker_process& worker) { return worker.job.has_value(); });
+            };
+
+        while (busy())
+            _collect_results(_config.poll_interval);
+    }
+
+    void render_daemon::_spawn_worker(worker_process& worker)
+    {
+        int job_pipe[2];
+        int result_pipe[2];
+
+        if (::pipe(job_pipe) != 0)
+            throw std::runtime_error("render daemon : unable to create a pipe");
+        if (::pipe(result_pipe) != 0) {
+            ::close(job_pipe[0]);
+            ::close(job_pipe[1]);
+            throw std::runtime_error("render daemon : unable to create a pipe");
+        }
+
+        const auto pid = ::fork();
+
+        if (pid < 0) {
+            for (auto fd : {job_pipe[0], job_pipe[1], result_pipe[0], result_pipe[1]})
+                ::close(fd);
+            throw std::runtime_error("render daemon : unable to fork a worker");
+        }
+        else if (pid == 0) {
+            //  Worker process : only keep its own pipe ends
+            for (const auto& other : _workers) {
+                if (other.job_fd >= 0)
+                    ::close(other.job_fd);
+                if (other.result_fd >= 0)
+                    ::close(other.result_fd);
+            }
+            ::close(job_pipe[1]);
+            ::close(result_pipe[0]);
+
+            //  The daemon stop handler is inherited : a worker must be terminated by SIGTERM
+            std::signal(SIGTERM, SIG_DFL);
+
+            const auto exit_code = render_worker::serve(_config.worker_config, job_pipe[0], result_pipe[1]);
+            ::_exit(exit_code);
+        }
+
+        ::close(job_pipe[0]);
+        ::close(result_pipe[1]);
+
+        worker.pid = pid;
+        worker.job_fd = job_pipe[1];
+        worker.result_fd = result_pipe[0];
+        worker.buffer.clear();
+        worker.job.reset();
+    }
+
+    /**
+     *  \brief Reap a worker process, waiting at most timeout for its exit
+     *  \return true if the worker was reaped
+     */
+    static bool wait_worker_exit(pid_t pid, std::chrono::milliseconds timeout)
+    {
+        const auto end = std::chrono::steady_clock::now() + timeout;
+
+        for (;;) {
+            const auto result = ::waitpid(pid, nullptr, WNOHANG);
+            if (result == pid || (result < 0 && errno != EINTR))
+                return true;
+            if (std::chrono::steady_clock::now() >= end)
+                return false;
+            std::this_thread::sleep_for(worker_exit_poll_interval);
+        }
+    }
+
+    void render_daemon::_stop_worker(worker_process& worker)
+    {
+        //  Closing the job pipe makes the worker exit once its current job is done
+        if (worker.job_fd >= 0)
+            ::close(worker.job_fd);
+        if (worker.result_fd >= 0)
+            ::close(worker.result_fd);
+
+        //  A hung worker must not block the daemon : it is terminated, then killed
+        if (worker.pid > 0 && !wait_worker_exit(worker.pid, worker_exit_grace_period)) {
+            LOG_WARNING("[render daemon] Worker %d did not exit, terminating it\n", worker.pid);
+            ::kill(worker.pid, SIGTERM);
+
+            if (!wait_worker_exit(worker.pid, worker_exit_grace_period)) {
+                LOG_ERROR("[render daemon] Worker %d did not terminate, killing it\n", worker.pid);
+                ::kill(worker.pid, SIGKILL);
+                ::waitpid(worker.pid, nullptr, 0);
+            }
+        }
+
+        worker.pid = -1;
+        worker.job_fd = -1;
+        worker.result_fd = -1;
+    }
+
+    void render_daemon::_dispatch_jobs()
+    {
+        auto idle_count = std::count_if(_workers.begin(), _workers.end(),
+            [](const worker_process& worker) { return !worker.job.has_value(); });
+
+        if (idle_count == 0)
+            return;
+
+        std::vector<std::filesystem::path> job_files{};
+        for (const auto& entry : std::filesystem::directory_iterator{_spool_directory(incoming_directory)}) {
+            if (entry.is_regular_file() && entry.path().extension() == ".json")
+                job_files.push_back(entry.path());
+        }
+        std::sort(job_files.begin(), job_files.end());
+
+        for (const auto& job_file : job_files) {
+            if (idle_count == 0)
+                break;
+
+            //  Claim the job
+            const auto running_file = _spool_directory(running_directory) / job_file.filename();
+            std::error_code error{};
+            std::filesystem::rename(job_file, running_file, error);
+            if (error)
+                continue;
+
+            auto worker = std::find_if(_workers.begin(), _workers.end(),
+                [](const worker_process& w) { return !w.job.has_value(); });
+
+            worker->job = running_job{{}, running_file, clock::now()};
+
+            try {
+                nlohmann::json json;
+                std::ifstream stream{running_file, std::ios_base::in};
+                stream >> json;
+                worker->job->job = render_job_from_json(job_file.stem().string(), json);
+            }
+            catch (const std::exception& error)
+            {
+                render_result result{};
+                result.error = error.what();
+                _complete_job(*worker, result);
+                continue;
+            }
+
+            if (!write_line(worker->job_fd, render_job_to_json(worker->job->job).dump())) {
+                render_result result{};
+                result.error = "Unable to send the job to the worker";
+                _complete_job(*worker, result);
+                _stop_worker(*worker);
+                _spawn_worker(*worker);
+                continue;
+            }
+
+            LOG_INFO("[render daemon] Job '%s' sent to worker %d\n", worker->job->job.id.c_str(), worker->pid);
+            idle_count--;
+        }
+    }
+
+    void render_daemon::_collect_results(std::chrono::milliseconds timeout)
+    {
+        std::vector<pollfd> fds{};
+        for (const auto& worker : _workers)
+            fds.push_back({worker.result_fd, POLLIN, 0});
+
+        const auto ready_count = ::poll(fds.data(), fds.size(), static_cast<int>(timeout.count()));
+        if (ready_count <= 0)
+            return;
+
+        for (auto i = 0u; i < _workers.size(); ++i) {
+            if (fds[i].revents == 0)
+                continue;
+
+            auto& worker = _workers[i];
+
+            if (!receive(worker.result_fd, worker.buffer)) {
+                //  The worker died
+                LOG_ERROR("[render daemon] Worker %d exited unexpectedly\n", worker.pid);
+                if (worker.job.has_value()) {
+                    render_result result{};
+                    result.error = "The worker process exited while rendering";
+                    result.worker_pid = worker.pid;
+                    _complete_job(worker, result);
+                }
+                _stop_worker(worker);
+                _spawn_worker(worker);
+                continue;
+            }
+
+            std::string line{};
+            while (extract_line(worker.buffer, line)) {
+                if (!worker.job.has_value())
+                    continue;
+
+                render_result result{};
+                try {
+                    result = render_result_from_json(nlohmann::json::parse(line));
+                }
+                catch (const std::exception& error)
+                {
+                    result.error = std::string{"Invalid worker result : "} + error.what();
+                }
+                _complete_job(worker, result);
+            }
+        }
+    }
+
+    void render_daemon::_complete_job(worker_process& worker, const render_result& result)
+    {
+        auto& job = worker.job.value();
+        const auto wall_duration = std::chrono::duration<double>(clock::now() - job.start).count();
+
+        if (result.success) {
+            _completed_count++;
+            LOG_INFO("[render daemon] Job '%s' done in %.3f s (load %.3f s%s, render %.3f s, real time factor %.1f, peak callback %.1f us)\n",
+                job.job.id.c_str(), wall_duration, result.load_duration, result.patch_cached ? ", cached patch" : "",
+                result.render_duration, result.realtime_factor, result.peak_callback_us);
+        }
+        else {
+            _failed_count++;
+            LOG_ERROR("[render daemon] Job '%s' failed : %s\n", job.job.id.c_str(), result.error.c_str());
+        }
+
+        //  The job file is replaced by a report
+        nlohmann::json report{
+            {"job", render_job_to_json(job.job)},
+            {"result", render_result_to_json(result)},
+            {"wall-duration", wall_duration}
+        };
+
+        const auto report_file =
+            _spool_directory(result.success ? done_directory : failed_directory) / job.file.filename();
+        std::ofstream{report_file, std::ios_base::out | std::ios_base::trunc} << report.dump(4);
+
+        std::error_code error{};
+        std::filesystem::remove(job.file, error);
+        worker.job.reset();
+    }
+
+    std::filesystem::path render_daemon::_spool_directory(const char *name) const
+    {
+        return _config.spool_path / name;
+    }
+
+}
@@ -0,0 +1,91 @@
+#ifndef GAMMOU_RENDER_DAEMON_H_
+#define GAMMOU_RENDER_DAEMON_H_
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+#include "render_job.h"
+#include "render_worker.h"
+
+namespace Gammou {
+
+    /**
+     * \class render_daemon
+     * \brief Distribute the render jobs found in a spool directory across worker processes.
+     *
+     *  Spool layout :
+     *      incoming/   job files (*.json) waiting to be rendered, taken by name order. A client must write
+     *                  a job under another name and rename it, so that an incomplete file is never read.
+     *      running/    jobs being rendered, moved back to incoming/ when the daemon restarts
+     *      done/       job files of successful renders, with their result and timings
+     *      failed/     job files of failed renders, with the error
+     *
+     *  Each worker is a forked process rendering one job at a time, \see render_worker. A worker which
+     *  dies fails its job and is replaced.
+     */
+    class render_daemon {
+    public:
+        struct configuration
+        {
+            std::filesystem::path spool_path{};
+            std::size_t worker_count{1u};
+            std::chrono::milliseconds poll_interval{200};    //<< Delay between two scans of the incoming directory
+            render_worker::configuration worker_config{};
+        };
+
+        /**
+         *  \brief Create the spool directories and start the workers
+         *  \note Must be called before any thread is started by the process
+         */
+        explicit render_daemon(const configuration& config);
+        ~render_daemon();
+
+        render_daemon(const render_daemon&) = delete;
+        render_daemon& operator=(const render_daemon&) = delete;
+
+        /**
+         *  \brief Dispatch the jobs and collect their results until running is false,
+         *  then wait for the jobs being rendered
+         */
+        void run(const std::atomic<bool>& running);
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        struct running_job
+        {
+            render_job job;
+            std::filesystem::path file;     //<< Job file, in running/
+            clock::time_point start;
+        };
+
+        struct worker_process
+        {
+            pid_t pid{-1};
+            int job_fd{-1};                 //<< Jobs are written here
+            int result_fd{-1};              //<< Results are read from here
+            std::string buffer{};
+            std::optional<running_job> job{};
+        };
+
+        void _spawn_worker(worker_process& worker);
+        void _stop_worker(worker_process& worker);
+        void _dispatch_jobs();
+        void _collect_results(std::chrono::milliseconds timeout);
+        void _complete_job(worker_process& worker, const render_result& result);
+        std::filesystem::path _spool_directory(const char *name) const;
+
+        const configuration _config;
+        std::vector<worker_process> _workers;
+        std::size_t _completed_count{0u};
+        std::size_t _failed_count{0u};
+    };
+
+}
+
+#endif /* GAMMOU_RENDER_DAEMON_H_ */
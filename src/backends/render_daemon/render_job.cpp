@@ -0,0 +1,74 @@
+#include <stdexcept>
+
+#include "render_job.h"
+
+namespace Gammou {
+
+    render_job render_job_from_json(const std::string& id, const nlohmann::json& json)
+    {
+        render_job job{};
+        job.id = id;
+
+        try {
+            job.patch = json.at("patch").get<std::string>();
+            job.midi = json.at("midi").get<std::string>();
+            job.output = json.at("output").get<std::string>();
+            job.sample_rate = json.value("sample-rate", job.sample_rate);
+            job.block_size = json.value("block-size", job.block_size);
+            job.tail_duration = json.value("tail", job.tail_duration);
+        }
+        catch (const nlohmann::json::exception& error)
+        {
+            throw std::invalid_argument(std::string{"render job : "} + error.what());
+        }
+
+        if (job.sample_rate == 0u || job.block_size == 0u || job.tail_duration < 0.f)
+            throw std::invalid_argument("render job : invalid settings");
+
+        return job;
+    }
+
+    nlohmann::json render_job_to_json(const render_job& job)
+    {
+        return {
+            {"id", job.id},
+            {"patch", job.patch.generic_string()},
+            {"midi", job.midi.generic_string()},
+            {"output", job.output.generic_string()},
+            {"sample-rate", job.sample_rate},
+            {"block-size", job.block_size},
+            {"tail", job.tail_duration}
+        };
+    }
+
+    render_result render_result_from_json(const nlohmann::json& json)
+    {
+        render_result result{};
+        result.success = json.value("success", false);
+        result.error = json.value("error", std::string{});
+        result.patch_cached = json.value("patch-cached", false);
+        result.load_duration = json.value("load-duration", 0.);
+        result.render_duration = json.value("render-duration", 0.);
+        result.realtime_factor = json.value("realtime-factor", 0.);
+        result.average_callback_us = json.value("average-callback-us", 0.);
+        result.peak_callback_us = json.value("peak-callback-us", 0.);
+        result.worker_pid = json.value("worker-pid", 0);
+        return result;
+    }
+
+    nlohmann::json render_result_to_json(const render_result& result)
+    {
+        return {
+            {"success", result.success},
+            {"error", result.error},
+            {"patch-cached", result.patch_cached},
+            {"load-duration", result.load_duration},
+            {"render-duration", result.render_duration},
+            {"realtime-factor", result.realtime_factor},
+            {"average-callback-us", result.average_callback_us},
+            {"peak-callback-us", result.peak_callback_us},
+            {"worker-pid", result.worker_pid}
+        };
+    }
+
+}
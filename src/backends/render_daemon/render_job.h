@@ -0,0 +1,51 @@
+#ifndef GAMMOU_RENDER_JOB_H_
+#define GAMMOU_RENDER_JOB_H_
+
+#include <filesystem>
+#include <string>
+#include <nlohmann/json.hpp>
+
+namespace Gammou {
+
+    /**
+     * \brief A render request, read from a json job file
+     */
+    struct render_job
+    {
+        std::string id{};               //<< Job file name, without extension
+        std::filesystem::path patch{};
+        std::filesystem::path midi{};
+        std::filesystem::path output{};
+        unsigned int sample_rate{48000u};
+        std::size_t block_size{512u};
+        float tail_duration{2.f};
+    };
+
+    /**
+     * \brief The outcome of a render job, reported by a worker
+     */
+    struct render_result
+    {
+        bool success{false};
+        std::string error{};
+        bool patch_cached{false};       //<< The patch was already compiled by the worker
+        double load_duration{0.};       //<< Patch and midi file loading (s)
+        double render_duration{0.};     //<< Rendering, including the wav writing (s)
+        double realtime_factor{0.};
+        double average_callback_us{0.};
+        double peak_callback_us{0.};
+        int worker_pid{0};
+    };
+
+    /**
+     * \throw std::invalid_argument if a required field is missing or invalid
+     */
+    render_job render_job_from_json(const std::string& id, const nlohmann::json& json);
+    nlohmann::json render_job_to_json(const render_job& job);
+
+    render_result render_result_from_json(const nlohmann::json& json);
+    nlohmann::json render_result_to_json(const render_result& result);
+
+}
+
+#endif /* GAMMOU_RENDER_JOB_H_ */
@@ -0,0 +1,133 @@
+#include <chrono>
+#include <fstream>
+
+#include <DSPJIT/log.h>
+#include "backends/offline_render/offline_renderer.h"
+#include "builtin_plugins/load_core_plugins.h"
+#include "pipe_lines.h"
+#include "plugin_system/package_loader.h"
+#include "render_worker.h"
+#include "utils/rt_log.h"
+
+namespace Gammou {
+
+    render_worker::render_worker(const configuration& config)
+    :   _synthesizer{_llvm_context, config.synthesizer_config},
+        _factory{package_loader{_llvm_context}.load_packages(config.packages_path).build()},
+        _patch{_synthesizer, *_factory}
+    {
+        load_core_plugins(_synthesizer, *_factory);
+        _synthesizer.add_library_module(_factory->module());
+    }
+
+    render_result render_worker::execute(const render_job& job) noexcept
+    {
+        using clock = std::chrono::steady_clock;
+        const auto seconds_since =
+            [](clock::time_point start)
+            {
+                return std::chrono::duration<double>(clock::now() - start).count();
+            };
+
+        render_result result{};
+        result.worker_pid = static_cast<int>(::getpid());
+
+        try {
+            const auto load_start = clock::now();
+            result.patch_cached = _load_patch(job.patch);
+            const auto events = load_midi_file(job.midi);
+            result.load_duration = seconds_since(load_start);
+
+            const auto render_start = clock::now();
+            const auto sample_rate = static_cast<float>(job.sample_rate);
+            wav_writer output{job.output, job.sample_rate, _synthesizer.get_output_count()};
+            offline_renderer renderer{_synthesizer, sample_rate, {job.block_size, job.tail_duration}};
+
+            const auto stats = renderer.render(events, output);
+            output.close();
+            result.render_duration = seconds_since(render_start);
+
+            result.realtime_factor = stats.realtime_factor(sample_rate);
+            result.average_callback_us = static_cast<double>(stats.average_callback_duration().count()) * 1e-3;
+            result.peak_callback_us = static_cast<double>(stats.max_callback_duration.count()) * 1e-3;
+            result.success = true;
+        }
+        catch (const std::exception& error)
+        {
+            result.error = error.what();
+            //  The patch may be partially loaded
+            _patch_path.clear();
+        }
+
+        return result;
+    }
+
+    int render_worker::serve(const configuration& config, int input_fd, int output_fd)
+    {
+        realtime_logger::instance().start();
+
+        std::unique_ptr<render_worker> worker{};
+        try {
+            worker = std::make_unique<render_worker>(config);
+        }
+        catch (const std::exception& error)
+        {
+            LOG_ERROR("[render worker] Initialization failed : %s\n", error.what());
+            return 1;
+        }
+
+        std::string buffer{};
+        std::string line{};
+
+        for (;;) {
+            while (!extract_line(buffer, line)) {
+                if (!receive(input_fd, buffer))
+                    return 0;
+            }
+
+            render_result result{};
+            try {
+                const auto json = nlohmann::json::parse(line);
+                const auto job = render_job_from_json(json.at("id").get<std::string>(), json);
+                result = worker->execute(job);
+            }
+            catch (const std::exception& error)
+            {
+                result.error = error.what();
+                result.worker_pid = static_cast<int>(::getpid());
+            }
+
+            if (!write_line(output_fd, render_result_to_json(result).dump()))
+                return 1;
+        }
+    }
+
+    bool render_worker::_load_patch(const std::filesystem::path& path)
+    {
+        const auto write_time = std::filesystem::last_write_time(path);
+
+        if (!_patch_path.empty() &&
+            std::filesystem::equivalent(path, _patch_path) && write_time == _patch_write_time) {
+            //  Same patch : reset the synthesizer instead of compiling it again
+            _synthesizer.reset(_initial_state);
+            return true;
+        }
+
+        nlohmann::json json;
+        std::ifstream stream{path, std::ios_base::in};
+        if (!stream.good())
+            throw std::invalid_argument("Unable to open the patch file '" + path.generic_string() + "'");
+        stream >> json;
+
+        _patch_path.clear();
+        _patch.deserialize(json);
+
+        //  Apply the new program before capturing the initial state
+        _synthesizer.update_program();
+        _initial_state = _synthesizer.capture_reset_point();
+        _patch_path = path;
+        _patch_write_time = write_time;
+        return false;
+    }
+
+}
@@ -0,0 +1,59 @@
+#ifndef GAMMOU_RENDER_WORKER_H_
+#define GAMMOU_RENDER_WORKER_H_
+
+#include <filesystem>
+#include <vector>
+
+#include "plugin_system/headless_patch.h"
+#include "synthesizer/synthesizer.h"
+#include "render_job.h"
+
+namespace Gammou {
+
+    /**
+     * \class render_worker
+     * \brief Render jobs in a worker process, with its own llvm context.
+     *
+     *  The packages are loaded once. The last patch is kept compiled : when the next job uses the same
+     *  patch file, unchanged, its compilation is skipped and the synthesizer is only reset by restoring
+     *  the state captured right after the patch was loaded.
+     */
+    class render_worker {
+    public:
+        struct configuration
+        {
+            std::filesystem::path packages_path{};
+            synthesizer::configuration synthesizer_config{};
+        };
+
+        explicit render_worker(const configuration& config);
+
+        /**
+         *  \brief Render a job, the errors are reported in the result
+         */
+        render_result execute(const render_job& job) noexcept;
+
+        /**
+         *  \brief Execute the jobs read from input_fd, one json line per job, and write one json result line
+         *  per job to output_fd, until input_fd is closed
+         *  \return the worker process exit code
+         */
+        static int serve(const configuration& config, int input_fd, int output_fd);
+
+    private:
+        bool _load_patch(const std::filesystem::path& path);
+
+        llvm::LLVMContext _llvm_context{};
+        synthesizer _synthesizer;
+        std::unique_ptr<node_factory> _factory;
+        headless_patch _patch;
+
+        //  Compiled patch cache
+        std::filesystem::path _patch_path{};
+        std::filesystem::file_time_type _patch_write_time{};
+        std::vector<uint8_t> _initial_state{};
+    };
+
+}
+
+#endif /* GAMMOU_RENDER_WORKER_H_ */
@@ -2,12 +2,17 @@
 #include "vst2_plugin.h"
 #include "synthesizer/midi_parser.h"
 #include "backends/common/default_configuration.h"
+#include "utils/denormals.h"
+#include "utils/rt_check.h"
+#include "utils/rt_log.h"
 
 #include <DSPJIT/log.h>
 
 #include <algorithm>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <limits>
 
 namespace Gammou {
 
@@ -15,6 +20,9 @@ namespace Gammou {
     :   _synthesizer{_llvm_context, synthesizer::configuration{}},
         _master_callback{master}
     {
+        //  Shared by the plugin instances : only the first one starts it
+        realtime_logger::instance().start();
+
         //  Allocate effect instance
         _effect = static_cast<AEffect*>(std::malloc(sizeof(AEffect)));
 
@@ -27,7 +35,7 @@ namespace Gammou {
         _effect->dispatcher = dispatcher_proc;
         _effect->setParameter = set_parameter_proc;
         _effect->getParameter = get_parameter_proc;
-        _effect->numParams = 0u;
+        _effect->numParams = synthesizer::automation_slot_count;
         _effect->numInputs = _synthesizer.get_input_count();
         _effect->numOutputs = _synthesizer.get_output_count();
 
@@ -98,6 +106,17 @@ namespace Gammou {
                 plugin->_display->close();
                 break;
 
+            case effEditIdle:
+                plugin->_synthesizer.dispatch_control_changes();
+                plugin->_report_automation();
+                plugin->_synthesizer.poll_load_governor_actions(
+                    [](const load_governor::action& action)
+                    {
+                        LOG_INFO("[vst2_plugin] Load governor : %s to %zu voices (load %.0f%%)\n",
+                            load_governor_action_name(action.kind), action.voice_budget, action.load * 100.f);
+                    });
+                break;
+
             case effProcessEvents:
             {
                 auto list =
@@ -128,6 +147,23 @@ namespace Gammou {
                 return 1;
                 break;
 
+            case effCanBeAutomated:
+                return 1;
+                break;
+
+            case effGetParamName:
+                //  The names are limited to kVstMaxParamStrLen characters, terminating null included : "K127" fits
+                std::snprintf(
+                    reinterpret_cast<char*>(ptr), kVstMaxParamStrLen,
+                    plugin->_synthesizer.automation_slot_used(index) ? "K%d" : "-", index);
+                break;
+
+            case effGetParamDisplay:
+                std::snprintf(
+                    reinterpret_cast<char*>(ptr), kVstMaxParamStrLen,
+                    "%.3f", plugin->_synthesizer.automation_get(index));
+                break;
+
             case effEditMouse:
                 return 1;
                 break;
@@ -159,6 +195,15 @@ namespace Gammou {
                 std::strcpy(reinterpret_cast<char*>(ptr), "Gammou");
                 break;
 
+            case effMainsChanged:
+                if (value != 0)
+                    plugin->_update_processing_mode();
+                break;
+
+            case effSetBlockSize:
+                plugin->_block_size = std::max<int32_t>(1, static_cast<int32_t>(value));
+                break;
+
             case effSetBlockSizeAndSampleRate:
             case effSetSampleRate:
                 LOG_INFO("[vst2_plugin) Set samplerate to %f\n", opt);
@@ -173,19 +218,33 @@ namespace Gammou {
     }
 
     void vst2_plugin::set_parameter_proc(
-        AEffect *, int32_t, float)
+        AEffect *fx, int32_t index, float value)
     {
+        auto plugin =
+            reinterpret_cast<vst2_plugin*>(fx->user);
 
+        if (index < 0 || index >= static_cast<int32_t>(synthesizer::automation_slot_count))
+            return;
+
+        //  Vst2 automation is not timestamped : ramp over the next block so that the value is reached
+        //  at its end. Several values received before this block are coalesced by the parameter manager.
+        plugin->_synthesizer.automation_set(index, value, plugin->_block_size);
+        plugin->_host_values[index] = value;
     }
 
     float vst2_plugin::get_parameter_proc(AEffect *fx, int32_t index)
     {
-        return 0.f;
+        auto plugin =
+            reinterpret_cast<vst2_plugin*>(fx->user);
+        return plugin->_synthesizer.automation_get(index);
     }
 
     void vst2_plugin::process_replacing_proc(
         AEffect *fx, float ** /*inputs*/, float **outputs, int32_t sample_count)
     {
+        scoped_denormals_flush denormals_flush{};
+        realtime_scope rt_scope{};
+
         auto plugin =
             reinterpret_cast<vst2_plugin*>(fx->user);
         plugin->_synthesizer.update_program();
@@ -193,32 +252,97 @@ namespace Gammou {
         auto output_left_buffer = outputs[0];
         auto output_right_buffer = outputs[1];
 
-        for (auto i = 0; i < sample_count; ++i) {
-            float tmp[2];
-            plugin->_synthesizer.process_sample(nullptr, tmp);
-            output_left_buffer[i] = tmp[0];
-            output_right_buffer[i] = tmp[1];
+        plugin->_block_size = sample_count;
+
+        //  Process by chunks so that the silence detection is done at block level,
+        //  and split the chunks at the midi events offsets so that they are sample accurate
+        for (auto offset = 0; offset < sample_count;) {
+            plugin->_execute_midi_events(offset);
+
+            const auto next_event_offset =
+                plugin->_next_midi_event < plugin->_midi_event_count ?
+                    plugin->_midi_events[plugin->_next_midi_event].offset : sample_count;
+            const auto chunk_size =
+                std::min<int32_t>(process_chunk_size, std::min(next_event_offset, sample_count) - offset);
+            float tmp[2u * process_chunk_size];
+
+            plugin->_synthesizer.process_buffer(chunk_size, nullptr, tmp);
+
+            for (auto i = 0; i < chunk_size; ++i) {
+                output_left_buffer[offset + i] = tmp[2 * i];
+                output_right_buffer[offset + i] = tmp[2 * i + 1];
+            }
+
+            offset += chunk_size;
         }
+
+        //  Events beyond the buffer end are executed anyway
+        plugin->_execute_midi_events(std::numeric_limits<int32_t>::max());
+        plugin->_midi_event_count = 0u;
+        plugin->_next_midi_event = 0u;
     }
 
-    void vst2_plugin::_call_master_callback(
+    intptr_t vst2_plugin::_call_master_callback(
             int32_t opcode,
             int32_t index,
             intptr_t value,
             void *ptr,
             float opt)
     {
-        _master_callback(_effect, opcode, index, value, ptr, opt);
+        return _master_callback(_effect, opcode, index, value, ptr, opt);
+    }
+
+    void vst2_plugin::_update_processing_mode()
+    {
+        //  When rendering offline, trade one block of latency for a pipelined processing
+        const auto offline =
+            _call_master_callback(audioMasterGetCurrentProcessLevel, 0, 0, nullptr, 0.f) == kVstProcessLevelOffline;
+
+        if (offline != _synthesizer.pipelined_processing_enabled()) {
+            _synthesizer.enable_pipelined_processing(offline);
+            _effect->initialDelay = static_cast<int32_t>(_synthesizer.get_latency());
+            _call_master_callback(audioMasterIOChanged, 0, 0, nullptr, 0.f);
+        }
     }
 
     void vst2_plugin::_handle_event(const VstEvent &ev)
     {
         if (ev.type == kVstMidiType) {
             auto midi_ev = reinterpret_cast<const VstMidiEvent*>(&ev);
-            execute_midi_msg(
-                _synthesizer,
-                reinterpret_cast<const uint8_t*>(midi_ev->midiData),
-                4u);
+
+            //  No room left : execute now, at the buffer start
+            if (_midi_event_count == max_midi_event_count) {
+                execute_midi_msg(_synthesizer, reinterpret_cast<const uint8_t*>(midi_ev->midiData), 4u);
+                return;
+            }
+
+            //  Hosts send the events in time order : the insertion is usually at the end
+            midi_event event{std::max(0, midi_ev->deltaFrames), {}};
+            std::memcpy(event.data, midi_ev->midiData, 4u);
+
+            auto pos = _midi_event_count++;
+            for (; pos > 0u && _midi_events[pos - 1u].offset > event.offset; --pos)
+                _midi_events[pos] = _midi_events[pos - 1u];
+            _midi_events[pos] = event;
+        }
+    }
+
+    void vst2_plugin::_execute_midi_events(int32_t offset)
+    {
+        for (; _next_midi_event < _midi_event_count && _midi_events[_next_midi_event].offset <= offset; ++_next_midi_event)
+            execute_midi_msg(_synthesizer, _midi_events[_next_midi_event].data, 4u);
+    }
+
+    void vst2_plugin::_report_automation()
+    {
+        //  Report the changes made with the gui or midi controls, so that the host can record them
+        for (auto slot = 0u; slot < synthesizer::automation_slot_count; ++slot) {
+            if (!_synthesizer.automation_slot_used(slot))
+                continue;
+
+            const auto value = _synthesizer.automation_get(slot);
+            if (value != _host_values[slot].exchange(value))
+                _call_master_callback(audioMasterAutomate, slot, 0, nullptr, value);
         }
     }
 
@@ -7,6 +7,9 @@
 
 #include <view.h>
 
+#include <array>
+#include <atomic>
+
 namespace Gammou {
 
     class vst2_plugin
@@ -16,6 +19,15 @@ namespace Gammou {
         ~vst2_plugin() = default;
 
     private:
+        static constexpr auto process_chunk_size = 64;
+        static constexpr auto max_midi_event_count = 1024u;
+
+        struct midi_event
+        {
+            int32_t offset; //<< Sample offset in the next processed buffer
+            uint8_t data[4];
+        };
+
         vst2_plugin(audioMasterCallback master);
 
         /*
@@ -38,7 +50,7 @@ namespace Gammou {
         /*
          *      helpers
          */
-        void _call_master_callback(
+        intptr_t _call_master_callback(
             int32_t opcode,
             int32_t index,
             intptr_t value,
@@ -46,6 +58,9 @@ namespace Gammou {
             float opt);
 
         void _handle_event(const VstEvent& ev);
+        void _execute_midi_events(int32_t offset);
+        void _report_automation();
+        void _update_processing_mode();
         std::size_t _load_state(const void *chunk, std::size_t size);
         std::size_t _save_state(void **chunk_ptr);
         void _update_windows_rect();
@@ -59,6 +74,15 @@ namespace Gammou {
         //  Processing
         llvm::LLVMContext _llvm_context{};
         synthesizer _synthesizer;
+        int32_t _block_size{process_chunk_size};    //<< Length of the host automation ramps
+
+        //  Midi events received for the next buffer, sorted by offset
+        std::array<midi_event, max_midi_event_count> _midi_events{};
+        std::size_t _midi_event_count{0u};
+        std::size_t _next_midi_event{0u};
+
+        //  Last automation values sent by or reported to the host
+        std::array<std::atomic<float>, synthesizer::automation_slot_count> _host_values{};
 
         //  Gui
         std::unique_ptr<application> _application;
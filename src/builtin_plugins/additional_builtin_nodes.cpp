@@ -16,5 +16,47 @@ namespace Gammou {
             inputs[0])};
     }
 
+    std::vector<llvm::Value*> probe_node::emit_outputs(DSPJIT::graph_compiler& compiler, const std::vector<llvm::Value*>& inputs, llvm::Value*, llvm::Value*) const
+    {
+        auto& ir_builder = compiler.builder();
+        auto& llvm_context = ir_builder.getContext();
+        //  Pointer constant to an object of type pointee_type
+        const auto address_of =
+            [&ir_builder](const void *ptr, llvm::Type *pointee_type)
+            {
+                return ir_builder.CreateIntToPtr(
+                    ir_builder.getIntN(8u * sizeof(void*), reinterpret_cast<uintptr_t>(ptr)),
+                    llvm::PointerType::getUnqual(pointee_type));
+            };
+
+        // if (tap.listening) probe_manager::push(&tap, in)
+        auto *listening_flag = ir_builder.CreateLoad(
+            ir_builder.getInt8Ty(), address_of(&_tap.listening, ir_builder.getInt8Ty()));
+        listening_flag->setAtomic(llvm::AtomicOrdering::Monotonic);
+        listening_flag->setAlignment(llvm::Align{alignof(std::atomic<bool>)});
+
+        auto *function = ir_builder.GetInsertBlock()->getParent();
+        auto *push_block = llvm::BasicBlock::Create(llvm_context, "probe_push", function);
+        auto *continue_block = llvm::BasicBlock::Create(llvm_context, "probe_continue", function);
+
+        ir_builder.CreateCondBr(
+            ir_builder.CreateICmpNE(listening_flag, ir_builder.getInt8(0u)),
+            push_block, continue_block);
+
+        ir_builder.SetInsertPoint(push_block);
+        auto *tap_pointer_type = llvm::PointerType::getUnqual(ir_builder.getInt8Ty());
+        auto *push_type = llvm::FunctionType::get(
+            ir_builder.getVoidTy(), {tap_pointer_type, ir_builder.getFloatTy()}, false);
+        ir_builder.CreateCall(
+            push_type,
+            address_of(reinterpret_cast<const void*>(&probe_manager::push), push_type),
+            {address_of(&_tap, ir_builder.getInt8Ty()), inputs[0]});
+        ir_builder.CreateBr(continue_block);
+
+        // out = in
+        ir_builder.SetInsertPoint(continue_block);
+        return {inputs[0]};
+    }
+
 
 } /* Gammou */
@@ -3,6 +3,8 @@
 
 #include <DSPJIT/compile_node_class.h>
 
+#include "synthesizer/probe_manager.h"
+
 namespace Gammou {
 
     // Logical not (out = 1 - in)
@@ -18,6 +20,24 @@ namespace Gammou {
             llvm::Value*, llvm::Value*) const override;
     };
 
+    // Probe (out = in), the input is pushed into a probe tap while it is listened.
+    // In the polyphonic circuit, the samples of every playing voice are pushed one after the other.
+    class probe_node : public DSPJIT::compile_node_class {
+    public:
+        explicit probe_node(probe_manager::tap& tap)
+        :    DSPJIT::compile_node_class{1u, 1u},
+             _tap{tap}
+        {}
+
+        std::vector<llvm::Value*> emit_outputs(
+            DSPJIT::graph_compiler& compiler,
+            const std::vector<llvm::Value*>& inputs,
+            llvm::Value*, llvm::Value*) const override;
+
+    private:
+        probe_manager::tap& _tap;
+    };
+
 }
 
 #endif /* GAMMOU_ADDITIONAL_BUILTIN_NODES_H_ */
\ No newline at end of file
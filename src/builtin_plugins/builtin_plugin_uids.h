@@ -0,0 +1,33 @@
+#ifndef GAMMOU_BUILTIN_PLUGIN_UIDS_H_
+#define GAMMOU_BUILTIN_PLUGIN_UIDS_H_
+
+#include <cstdint>
+
+namespace Gammou {
+
+    /**
+     *  Uids of the plugins built into gammou, shared by the gui and the headless node factories
+     *  as they identify the nodes in the patches
+     */
+    namespace builtin_plugin_uids {
+
+        // Calculus
+        constexpr uint64_t add = 0xdafa0fde10153761u;
+        constexpr uint64_t substract = 0x354a1a7d23ee5f6eu;
+        constexpr uint64_t mul = 0x5d777d71620078eeu;
+        constexpr uint64_t negate = 0xcd3d55d993e1c8d0u;
+        constexpr uint64_t logical_not = 0x2913f07efa7a7684u;
+
+        // Control
+        constexpr uint64_t constant = 0x3feb405c9167036eu;
+        constexpr uint64_t value_knob = 0x384d61a1be4de6cdu;
+        constexpr uint64_t gain_knob = 0xdde47c1126a20041u;
+        constexpr uint64_t probe = 0x7c0e5b39a4d21f86u;
+
+        // Composite
+        constexpr uint64_t composite = 0x82796d4e78cd63f1u;
+    }
+
+}
+
+#endif /* GAMMOU_BUILTIN_PLUGIN_UIDS_H_ */
@@ -0,0 +1,143 @@
+
+#include <DSPJIT/common_nodes.h>
+#include <DSPJIT/composite_node.h>
+
+#include "additional_builtin_nodes.h"
+#include "builtin_plugin_uids.h"
+#include "load_core_plugins.h"
+#include "node_builtin_plugin.h"
+#include "plugin_system/headless_patch.h"
+#include "plugin_system/patch_format.h"
+#include "register_calculus_plugins.h"
+#include "synthesizer/parameter_serialization.h"
+
+namespace Gammou {
+
+    /**
+     *  \brief Value and gain knobs : a parameter read by the circuit
+     */
+    class knob_node_plugin : public node_factory::plugin {
+    public:
+        enum class mode {
+            VALUE, GAIN
+        };
+
+        knob_node_plugin(synthesizer& synth, mode m)
+        :   node_factory::plugin{
+                m == mode::VALUE ? builtin_plugin_uids::value_knob : builtin_plugin_uids::gain_knob,
+                m == mode::VALUE ? "Knob" : "Gain Knob",
+                "Control"},
+            _synth{synth},
+            _mode{m}
+        {}
+
+        std::unique_ptr<DSPJIT::compile_node_class> create_node(headless_patch& patch, const nlohmann::json& internal_state) override
+        {
+            auto param = internal_state.is_null() ?
+                _synth.allocate_parameter(0.f) :
+                parameter_from_json(internal_state, _synth);
+
+            std::unique_ptr<DSPJIT::compile_node_class> node{};
+            if (_mode == mode::VALUE)
+                node = std::make_unique<DSPJIT::reference_node>(param.get_value_ptr());
+            else // GAIN
+                node = std::make_unique<DSPJIT::reference_multiply_node>(param.get_value_ptr());
+
+            patch.hold(std::move(param));
+            return node;
+        }
+
+    private:
+        synthesizer& _synth;
+        const mode _mode;
+    };
+
+    class constant_node_plugin : public node_factory::plugin {
+    public:
+        constant_node_plugin()
+        :   node_factory::plugin{builtin_plugin_uids::constant, "Constant", "Control"}
+        {}
+
+        std::unique_ptr<DSPJIT::compile_node_class> create_node(headless_patch&, const nlohmann::json& internal_state) override
+        {
+            const auto value = internal_state.is_null() ? 1.f : internal_state.at("value").get<float>();
+            return std::make_unique<DSPJIT::constant_node>(value);
+        }
+    };
+
+    /**
+     *  \brief The probe are loaded so that the patches using them can be played, but no one listens to them
+     */
+    class probe_node_plugin : public node_factory::plugin {
+    public:
+        explicit probe_node_plugin(synthesizer& synth)
+        :   node_factory::plugin{builtin_plugin_uids::probe, "Probe", "Control"},
+            _synth{synth}
+        {}
+
+        std::unique_ptr<DSPJIT::compile_node_class> create_node(headless_patch& patch, const nlohmann::json& internal_state) override
+        {
+            auto probe = _synth.allocate_probe();
+            probe.set_decimation(internal_state.is_object() ? internal_state.value("decimation", 1u) : 1u);
+
+            auto node = std::make_unique<probe_node>(probe.get_tap());
+            patch.hold(std::move(probe));
+            return node;
+        }
+
+        const std::optional<std::vector<unsigned int>>& silence_inputs() override
+        {
+            //  out = in
+            static const std::optional<std::vector<unsigned int>> probe_silence_inputs{std::vector<unsigned int>{0u}};
+            return probe_silence_inputs;
+        }
+
+    private:
+        synthesizer& _synth;
+    };
+
+    class composite_node_plugin : public node_factory::plugin {
+    public:
+        composite_node_plugin()
+        :   node_factory::plugin{builtin_plugin_uids::composite, "Circuit", "Composite"}
+        {}
+
+        std::unique_ptr<DSPJIT::compile_node_class> create_node(headless_patch& patch, const nlohmann::json& internal_state) override
+        {
+            //  A new composite node is empty, with 2 inputs and 2 outputs
+            if (internal_state.is_null())
+                return std::make_unique<DSPJIT::composite_node>(2u, 2u);
+
+            patch_format::composite_node_state state{};
+            from_json(internal_state, state);
+
+            auto node = std::make_unique<DSPJIT::composite_node>(
+                state.input_names.size(), state.output_names.size());
+
+            patch.deserialize_circuit(
+                state.internal_circuit_state,
+                [&node](const std::string& identifier) -> DSPJIT::compile_node_class&
+                {
+                    if (identifier == patch_format::composite_input_node_id)
+                        return node->input();
+                    else if (identifier == patch_format::composite_output_node_id)
+                        return node->output();
+                    else
+                        throw std::runtime_error("composite_node_plugin::create_node : Unknown internal node : " + identifier);
+                });
+
+            return node;
+        }
+    };
+
+    void load_core_plugins(synthesizer& synth, node_factory& factory)
+    {
+        register_calculus_plugins<node_builtin_plugin>(factory);
+        factory.register_plugin(std::make_unique<knob_node_plugin>(synth, knob_node_plugin::mode::VALUE));
+        factory.register_plugin(std::make_unique<knob_node_plugin>(synth, knob_node_plugin::mode::GAIN));
+        factory.register_plugin(std::make_unique<constant_node_plugin>());
+        factory.register_plugin(std::make_unique<probe_node_plugin>(synth));
+        factory.register_plugin(std::make_unique<composite_node_plugin>());
+    }
+
+}
@@ -0,0 +1,17 @@
+#ifndef GAMMOU_LOAD_CORE_PLUGINS_H_
+#define GAMMOU_LOAD_CORE_PLUGINS_H_
+
+#include "plugin_system/node_factory.h"
+#include "synthesizer/synthesizer.h"
+
+namespace Gammou {
+
+    /**
+     *  \brief Load the gui free counterparts of the builtin, control and composite plugins into a node factory,
+     *  so that the patches using them can be loaded by a headless_patch
+     */
+    void load_core_plugins(synthesizer& synth, node_factory& factory);
+
+}
+
+#endif /* GAMMOU_LOAD_CORE_PLUGINS_H_ */
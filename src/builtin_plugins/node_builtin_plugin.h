@@ -0,0 +1,41 @@
+#ifndef GAMMOU_NODE_BUILTIN_PLUGIN_H_
+#define GAMMOU_NODE_BUILTIN_PLUGIN_H_
+
+#include "plugin_system/node_factory.h"
+
+namespace Gammou {
+
+    /**
+     *  \brief Gui free counterpart of node_widget_builtin_plugin
+     */
+    template <typename TCompileNode>
+    class node_builtin_plugin : public node_factory::plugin {
+    public:
+        using plugin_id = node_factory::plugin_id;
+
+        node_builtin_plugin(
+            plugin_id id,
+            const std::string& name,
+            const std::string& category,
+            std::optional<std::vector<unsigned int>> silence_inputs = std::nullopt)
+        :   node_factory::plugin{id, name, category},
+            _silence_inputs{std::move(silence_inputs)}
+        {}
+
+        std::unique_ptr<DSPJIT::compile_node_class> create_node(headless_patch&, const nlohmann::json&) override
+        {
+            return std::make_unique<TCompileNode>();
+        }
+
+        const std::optional<std::vector<unsigned int>>& silence_inputs() override
+        {
+            return _silence_inputs;
+        }
+
+    private:
+        const std::optional<std::vector<unsigned int>> _silence_inputs;
+    };
+
+}
+
+#endif /* GAMMOU_NODE_BUILTIN_PLUGIN_H_ */
@@ -13,8 +13,10 @@ namespace Gammou {
         node_widget_builtin_plugin(
             plugin_id id,
             const std::string& name,
-            const std::string& category)
-        :   node_widget_factory::plugin{id, name, category}
+            const std::string& category,
+            std::optional<std::vector<unsigned int>> silence_inputs = std::nullopt)
+        :   node_widget_factory::plugin{id, name, category},
+            _silence_inputs{std::move(silence_inputs)}
         {}
 
         std::unique_ptr<plugin_node_widget> create_node(abstract_configuration_directory&) override
@@ -23,15 +25,24 @@ namespace Gammou {
                 name(), id(),
                 std::make_unique<TCompileNode>());
         }
+
+        const std::optional<std::vector<unsigned int>>& silence_inputs() override
+        {
+            return _silence_inputs;
+        }
+
+    private:
+        const std::optional<std::vector<unsigned int>> _silence_inputs;
     };
 
     template <typename TCompileNode>
     auto make_builtin_plugin(
         node_widget_factory::plugin_id id,
         const std::string& name,
-        const std::string& category)
+        const std::string& category,
+        std::optional<std::vector<unsigned int>> silence_inputs = std::nullopt)
     {
-        return std::make_unique<node_widget_builtin_plugin<TCompileNode>>(id, name, category);
+        return std::make_unique<node_widget_builtin_plugin<TCompileNode>>(id, name, category, std::move(silence_inputs));
     }
 
 }
@@ -0,0 +1,34 @@
+#ifndef GAMMOU_REGISTER_CALCULUS_PLUGINS_H_
+#define GAMMOU_REGISTER_CALCULUS_PLUGINS_H_
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <DSPJIT/common_nodes.h>
+
+#include "additional_builtin_nodes.h"
+#include "builtin_plugin_uids.h"
+
+namespace Gammou {
+
+    /**
+     *  \brief Register the builtin calculus plugins into a factory
+     *  \tparam TPlugin the builtin plugin template of the factory, instanciated with the node type
+     */
+    template <template <typename> class TPlugin, typename TFactory>
+    void register_calculus_plugins(TFactory& factory)
+    {
+        using silence_inputs = std::optional<std::vector<unsigned int>>;
+
+        //  Mul output is silent if either input is silent : the first one is used
+        factory.register_plugin(std::make_unique<TPlugin<DSPJIT::add_node>>(builtin_plugin_uids::add, "Add", "Calculus", silence_inputs{{0u, 1u}}));
+        factory.register_plugin(std::make_unique<TPlugin<DSPJIT::substract_node>>(builtin_plugin_uids::substract, "Sub", "Calculus", silence_inputs{{0u, 1u}}));
+        factory.register_plugin(std::make_unique<TPlugin<DSPJIT::mul_node>>(builtin_plugin_uids::mul, "Mul", "Calculus", silence_inputs{{0u}}));
+        factory.register_plugin(std::make_unique<TPlugin<DSPJIT::negate_node>>(builtin_plugin_uids::negate, "Negate", "Calculus", silence_inputs{{0u}}));
+        factory.register_plugin(std::make_unique<TPlugin<logical_not_node>>(builtin_plugin_uids::logical_not, "1 - X", "Calculus", silence_inputs{}));
+    }
+
+}
+
+#endif /* GAMMOU_REGISTER_CALCULUS_PLUGINS_H_ */
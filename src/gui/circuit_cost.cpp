@@ -0,0 +1,84 @@
+#include <cstdio>
+
+#include "circuit_cost.h"
+#include "composite_node/composite_node_widget.h"
+
+namespace Gammou {
+
+    static void accumulate_circuit_cost(node_widget_factory& factory, const circuit_editor& editor, circuit_cost& cost);
+
+    static void accumulate_node_cost(node_widget_factory& factory, const node_widget& widget, circuit_cost& cost)
+    {
+        const auto *plugin_node = dynamic_cast<const plugin_node_widget*>(&widget);
+
+        // Internal nodes (circuit inputs and outputs) are free
+        if (plugin_node == nullptr)
+            return;
+
+        if (const auto *composite = dynamic_cast<const composite_node_widget*>(plugin_node)) {
+            accumulate_circuit_cost(factory, composite->internal_editor(), cost);
+        }
+        else if (auto *plugin = factory.get_plugin(plugin_node->id())) {
+            const auto& node_cost = plugin->cost();
+            cost.cycles += node_cost.cycles;
+            cost.state_bytes += node_cost.state_bytes;
+            cost.node_count++;
+        }
+    }
+
+    static void accumulate_circuit_cost(node_widget_factory& factory, const circuit_editor& editor, circuit_cost& cost)
+    {
+        for (const auto& pair : editor.node_widgets())
+            accumulate_node_cost(factory, *pair.second, cost);
+    }
+
+    circuit_cost estimate_circuit_cost(node_widget_factory& factory, const circuit_editor& editor)
+    {
+        circuit_cost cost{};
+        accumulate_circuit_cost(factory, editor, cost);
+        return cost;
+    }
+
+    circuit_cost estimate_node_cost(node_widget_factory& factory, const node_widget& widget)
+    {
+        circuit_cost cost{};
+        accumulate_node_cost(factory, widget, cost);
+        return cost;
+    }
+
+    static std::string format_bytes(std::size_t bytes)
+    {
+        constexpr auto text_len = 16;
+        char text[text_len];
+
+        if (bytes < 1024u)
+            std::snprintf(text, text_len, "%zu B", bytes);
+        else if (bytes < 1024u * 1024u)
+            std::snprintf(text, text_len, "%.1f KB", static_cast<double>(bytes) / 1024.);
+        else
+            std::snprintf(text, text_len, "%.1f MB", static_cast<double>(bytes) / (1024. * 1024.));
+
+        return text;
+    }
+
+    std::string format_circuit_cost(const circuit_cost& cost, std::size_t instance_count)
+    {
+        constexpr auto text_len = 128;
+        char text[text_len];
+
+        if (instance_count > 1u) {
+            std::snprintf(
+                text, text_len, "~%.0f cycles/sample/voice, %s/voice, %s for %zu voices",
+                cost.cycles, format_bytes(cost.state_bytes).c_str(),
+                format_bytes(cost.state_bytes * instance_count).c_str(), instance_count);
+        }
+        else {
+            std::snprintf(
+                text, text_len, "~%.0f cycles/sample, %s",
+                cost.cycles, format_bytes(cost.state_bytes).c_str());
+        }
+
+        return text;
+    }
+
+}
@@ -0,0 +1,39 @@
+#ifndef GAMMOU_CIRCUIT_COST_H_
+#define GAMMOU_CIRCUIT_COST_H_
+
+#include <string>
+
+#include "circuit_editor.h"
+#include "plugin_system/node_widget_factory.h"
+
+namespace Gammou {
+
+    /**
+     * \brief Static cost estimate of a circuit instance
+     */
+    struct circuit_cost
+    {
+        double cycles{0.};              //<< Estimated cpu cycles needed to process one sample
+        std::size_t state_bytes{0u};    //<< Size of the circuit nodes states
+        std::size_t node_count{0u};
+    };
+
+    /**
+     * \brief Sum the estimated cost of every node of a circuit, including composite nodes content
+     */
+    circuit_cost estimate_circuit_cost(node_widget_factory& factory, const circuit_editor& editor);
+
+    /**
+     * \brief Return the estimated cost of a node of a circuit. Internal nodes are free
+     */
+    circuit_cost estimate_node_cost(node_widget_factory& factory, const node_widget& widget);
+
+    /**
+     * \brief Format a circuit cost as a short human readable text
+     * \param instance_count number of circuit instances (voices) used to compute the total memory
+     */
+    std::string format_circuit_cost(const circuit_cost& cost, std::size_t instance_count);
+
+}
+
+#endif /* GAMMOU_CIRCUIT_COST_H_ */
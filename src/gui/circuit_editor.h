@@ -118,6 +118,11 @@ namespace Gammou
         void remove_node_widget(node_widget*);
         void clear();
 
+        /**
+         *  \brief Return the node widgets indexed by their compile node
+         **/
+        const auto& node_widgets() const noexcept { return _node_widgets; }
+
         bool on_mouse_move(float x, float y) override;
         bool on_mouse_drag(const View::mouse_button button, float x, float y, float dx, float dy) override;
         bool on_mouse_drag_start(const View::mouse_button button, float x, float y) override;
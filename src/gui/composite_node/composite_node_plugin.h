@@ -1,6 +1,7 @@
 #ifndef GAMMOU_COMPOSITE_NODE_PLUGIN_H_
 #define GAMMOU_COMPOSITE_NODE_PLUGIN_H_
 
+#include "builtin_plugins/builtin_plugin_uids.h"
 #include "plugin_system/node_widget_factory.h"
 #include "gui/configuration_widget.h"
 
@@ -8,7 +9,7 @@ namespace Gammou {
 
     class composite_node_plugin : public node_widget_factory::plugin {
     public:
-        static constexpr node_widget_factory::plugin_id uid = 0x82796d4e78cd63f1;
+        static constexpr node_widget_factory::plugin_id uid = builtin_plugin_uids::composite;
 
         composite_node_plugin(factory_widget& factory);
 
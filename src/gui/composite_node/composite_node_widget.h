@@ -3,6 +3,7 @@
 
 #include <DSPJIT/composite_node.h>
 #include "gui/factory_widget.h"
+#include "plugin_system/patch_format.h"
 
 namespace Gammou
 {
@@ -10,17 +11,11 @@ namespace Gammou
 
     class composite_node_widget : public plugin_node_widget
     {
-        static constexpr auto composite_input_id = "composite_input";
-        static constexpr auto composite_output_id = "composite_output";
+        static constexpr auto composite_input_id = patch_format::composite_input_node_id;
+        static constexpr auto composite_output_id = patch_format::composite_output_node_id;
 
     public:
-        struct state
-        {
-            std::string name;
-            std::vector<std::string> input_names;
-            std::vector<std::string> output_names;
-            nlohmann::json internal_circuit_state;
-        };
+        using state = patch_format::composite_node_state;
 
         /**
          * \brief Connstruct a fresh new composite node
@@ -62,6 +57,11 @@ namespace Gammou
          */
         void set_output_name(unsigned int output_id, const std::string& name) override;
 
+        /**
+         * \brief Return the editor of the internal circuit
+         */
+        const circuit_editor& internal_editor() const noexcept { return *_internal_editor; }
+
     private:
         std::unique_ptr<node_widget> _make_input_node();
         std::unique_ptr<node_widget> _make_output_node();
@@ -86,8 +86,6 @@ namespace Gammou
         circuit_editor *_internal_editor{nullptr};
         View::text_input *_name_text_input{nullptr};
     };
-
-    NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(composite_node_widget::state, name, input_names, output_names, internal_circuit_state)
 }
 
 #endif
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "configuration_widget.h"
 #include "synthesizer_gui.h"
 #include "helpers/layout_builder.h"
+#include "plugin_system/patch_format.h"
 
 namespace Gammou
 {
@@ -160,22 +161,6 @@ namespace Gammou
     }
 
 
-    /**
-     *  Synthesizer state serialization/deserialization
-     */
-    struct synthesizer_state
-    {
-        nlohmann::json master_circuit{};
-        nlohmann::json polyphonic_circuit{};
-        synthesizer::voice_mode voicing_mode{synthesizer::voice_mode::POLYPHONIC};
-    };
-
-    NLOHMANN_JSON_SERIALIZE_ENUM(synthesizer::voice_mode, {
-        {synthesizer::voice_mode::POLYPHONIC, "polyphonic"},
-        {synthesizer::voice_mode::LEGATO, "legato"}
-    })
-    NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(synthesizer_state, master_circuit, polyphonic_circuit, voicing_mode)
-
     /**
      *  Configuration widget implementation
      */
@@ -211,10 +196,22 @@ namespace Gammou
             });
     }
 
+    configuration_widget::~configuration_widget()
+    {
+        // The synthesizer may outlive the configuration widget
+        _synthesizer.get_master_circuit_controller().set_compile_callback({});
+        _synthesizer.get_polyphonic_circuit_controller().set_compile_callback({});
+    }
+
     void configuration_widget::deserialize_configuration(const nlohmann::json& json)
     {
+        // Every compilation requested while loading (reset, samples loading, ...)
+        // is deferred until the transaction commit, in order to compile each circuit once.
+        // The transaction outlives the try block, so that it is ended on the failure path too.
+        synthesizer::compile_transaction transaction{_synthesizer};
+
         try {
-            synthesizer_state state{};
+            patch_format::synthesizer_state state{};
             from_json(json, state);
 
             reset_editor();
@@ -234,9 +231,10 @@ namespace Gammou
 
             _synthesizer.set_voice_mode(state.voicing_mode);
 
-            // Recompile the new loaded circuit
+            // Recompile the new loaded circuit, a patch which can not be compiled is not loaded
             _synthesizer.get_master_circuit_controller().compile();
             _synthesizer.get_polyphonic_circuit_controller().compile();
+            transaction.commit();
         }
         catch (const std::exception &e) {
             reset_editor();
@@ -246,7 +244,7 @@ namespace Gammou
 
     nlohmann::json configuration_widget::serialize_configuration()
     {
-        const synthesizer_state state{
+        const patch_format::synthesizer_state state{
             _master_circuit_editor->serialize(),
             _polyphonic_circuit_editor->serialize(),
             _synthesizer.get_voice_mode()
@@ -271,6 +269,7 @@ namespace Gammou
     void configuration_widget::reset_editor()
     {
         LOG_DEBUG("[configuration_widget] Reset content\n");
+        synthesizer::compile_transaction transaction{_synthesizer};
 
         // Remove the nodes : this will also remove relevant configuration dirs
         _master_circuit_editor->clear();
@@ -291,7 +290,7 @@ namespace Gammou
         //  Select master circuit by default
         _master_circuit_dir->display();
 
-        // Recompile circuits
+        // Recompile circuits (at transaction commit)
         _synthesizer.get_master_circuit_controller().compile();
         _synthesizer.get_polyphonic_circuit_controller().compile();
     }
@@ -305,8 +304,29 @@ namespace Gammou
         _master_circuit_editor = master_editor.get();
         _polyphonic_circuit_editor = polyphonic_editor.get();
 
-        auto master_circuit_widget = _wrap_editor(std::move(master_editor));
-        auto polyphonic_circuit_widget = _wrap_editor(std::move(polyphonic_editor));
+        // initialize circuit cost estimates, updated each time a circuit is compiled
+        auto master_cost_label = std::make_unique<View::label>(200, 20, "");
+        auto polyphonic_cost_label = std::make_unique<View::label>(200, 20, "");
+
+        _master_cost_label = master_cost_label.get();
+        _polyphonic_cost_label = polyphonic_cost_label.get();
+
+        _synthesizer.get_master_circuit_controller().set_compile_callback(
+            [this]()
+            {
+                _update_cost_label(*_master_cost_label, *_master_circuit_editor, 1u);
+            });
+        _synthesizer.get_polyphonic_circuit_controller().set_compile_callback(
+            [this]()
+            {
+                const auto cost =
+                    _update_cost_label(*_polyphonic_cost_label, *_polyphonic_circuit_editor, _synthesizer.get_voice_count());
+                // Used to enforce the voice memory cap
+                _synthesizer.set_voice_state_size(cost.state_bytes);
+            });
+
+        auto master_circuit_widget = _wrap_editor(std::move(master_editor), std::move(master_cost_label));
+        auto polyphonic_circuit_widget = _wrap_editor(std::move(polyphonic_editor), std::move(polyphonic_cost_label));
 
 
         std::string master_name = "Master";
@@ -335,10 +355,19 @@ namespace Gammou
         reset_editor();
     }
 
-    std::shared_ptr<View::widget> configuration_widget::_wrap_editor(std::unique_ptr<circuit_editor>&& editor)
+    std::shared_ptr<View::widget> configuration_widget::_wrap_editor(std::unique_ptr<circuit_editor>&& editor, std::unique_ptr<View::label>&& cost_label)
     {
         const View::layout_builder builder{};
-        return builder.shared_header(builder.map(std::move(editor)), View::color_theme::color::SURFACE_DARK, 0.f /* no internal border */);
+        return builder.shared_header(
+            builder.vertical(std::move(cost_label), builder.map(std::move(editor))),
+            View::color_theme::color::SURFACE_DARK, 0.f /* no internal border */);
+    }
+
+    circuit_cost configuration_widget::_update_cost_label(View::label& label, const circuit_editor& editor, std::size_t instance_count)
+    {
+        const auto cost = estimate_circuit_cost(_factory.factory(), editor);
+        label.set_text(format_circuit_cost(cost, instance_count));
+        return cost;
     }
 
     std::unique_ptr<node_widget> configuration_widget::_deserialize_node(abstract_configuration_directory& parent_config, const nlohmann::json& json)
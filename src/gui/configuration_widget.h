@@ -1,6 +1,7 @@
 #ifndef CONFIGURATION_WIDGET_H_
 #define CONFIGURATION_WIDGET_H_
 
+#include "circuit_cost.h"
 #include "configuration_tree.h"
 #include "factory_widget.h"
 
@@ -17,8 +18,11 @@ namespace Gammou
             View::widget_proxy<>& editor_proxy,
             float width, float height);
 
+        ~configuration_widget() override;
+
         /**
          * \brief Deserialize synthesizer circuits and settings
+         * \throw std::exception if the patch could not be loaded or compiled, the editor is then reset
          */
         void deserialize_configuration(const nlohmann::json&);
 
@@ -32,12 +36,16 @@ namespace Gammou
          */
         void reset_editor();
 
+        circuit_editor& master_circuit_editor() noexcept { return *_master_circuit_editor; }
+        circuit_editor& polyphonic_circuit_editor() noexcept { return *_polyphonic_circuit_editor; }
+
     private:
         void _select_config(configuration_tree& config_dir);
         void _select_config(configuration_leaf& config_leaf);
         void _initialize();
 
-        std::shared_ptr<View::widget> _wrap_editor(std::unique_ptr<circuit_editor>&& editor);
+        std::shared_ptr<View::widget> _wrap_editor(std::unique_ptr<circuit_editor>&& editor, std::unique_ptr<View::label>&& cost_label);
+        circuit_cost _update_cost_label(View::label& label, const circuit_editor& editor, std::size_t instance_count);
         std::unique_ptr<node_widget> _deserialize_node(abstract_configuration_directory& parent_config, const nlohmann::json&);
 
         std::unique_ptr<abstract_configuration_directory> _master_circuit_dir{};
@@ -46,6 +54,9 @@ namespace Gammou
         circuit_editor *_polyphonic_circuit_editor{};
         circuit_editor *_master_circuit_editor{};
 
+        View::label *_polyphonic_cost_label{};
+        View::label *_master_cost_label{};
+
         factory_widget& _factory;
         synthesizer& _synthesizer;
         View::widget_proxy<>& _editor_proxy;
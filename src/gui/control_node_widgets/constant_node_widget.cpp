@@ -1,10 +1,11 @@
 #include <sstream>
 #include <DSPJIT/common_nodes.h>
+#include "builtin_plugins/builtin_plugin_uids.h"
 #include "constant_node_widget.h"
 
 namespace Gammou
 {
-    static constexpr auto constant_node_widget_uid = 0x3feb405c9167036eu;
+    static constexpr auto constant_node_widget_uid = builtin_plugin_uids::constant;
 
     class constant_node_widget : public plugin_node_widget
     {
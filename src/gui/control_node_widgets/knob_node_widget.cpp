@@ -2,12 +2,13 @@
 #include <DSPJIT/common_nodes.h>
 
 #include "knob_node_widget.h"
-#include "parameter_serialization.h"
+#include "builtin_plugins/builtin_plugin_uids.h"
+#include "synthesizer/parameter_serialization.h"
 
 namespace Gammou {
 
-    static constexpr auto value_knob_widget_uid = 0x384d61a1be4de6cdu;
-    static constexpr auto gain_knob_widget_uid = 0xdde47c1126a20041u;
+    static constexpr auto value_knob_widget_uid = builtin_plugin_uids::value_knob;
+    static constexpr auto gain_knob_widget_uid = builtin_plugin_uids::gain_knob;
 
     class knob_node_widget : public plugin_node_widget {
         using parameter = synthesizer::parameter;
@@ -3,6 +3,7 @@
 
 #include "knob_node_widget.h"
 #include "constant_node_widget.h"
+#include "probe_node_widget.h"
 
 namespace Gammou {
 
@@ -11,5 +12,6 @@ namespace Gammou {
         factory.register_plugin(std::make_unique<value_knob_node_widget_plugin>(synth));
         factory.register_plugin(std::make_unique<gain_knob_node_widget_plugin>(synth));
         factory.register_plugin(std::make_unique<constant_node_widget_plugin>());
+        factory.register_plugin(std::make_unique<probe_node_widget_plugin>(synth));
     }
 }
\ No newline at end of file
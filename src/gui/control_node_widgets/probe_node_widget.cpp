@@ -0,0 +1,166 @@
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+
+#include "builtin_plugins/additional_builtin_nodes.h"
+#include "builtin_plugins/builtin_plugin_uids.h"
+#include "probe_node_widget.h"
+
+namespace Gammou
+{
+    static constexpr auto probe_node_widget_uid = builtin_plugin_uids::probe;
+
+    /**
+     *  \brief Display the probed signal as a scope, with its peak level.
+     *  The probe is read when the widget is drawn : it stops pushing samples when the widget is not displayed.
+     *  Only supported in the master circuit, \see probe_manager
+     */
+    class probe_node_widget : public plugin_node_widget
+    {
+        using probe = synthesizer::probe;
+        static constexpr auto scope_height = 60.f;
+        static constexpr auto history_size = 256u;
+        static constexpr std::array<unsigned int, 4u> decimations{1u, 4u, 16u, 64u};
+
+    public:
+        probe_node_widget(probe&& p, unsigned int decimation = 1u)
+        :   plugin_node_widget{"Probe", probe_node_widget_uid, std::make_unique<probe_node>(p.get_tap())},
+            _probe{std::move(p)}
+        {
+            _probe.set_decimation(decimation);
+
+            //  Cycle through the decimations
+            auto decimation_label = std::make_unique<View::label>(node_widget::node_header_size * 2.f, node_widget::node_header_size, "");
+            auto decimation_button = std::make_unique<View::text_push_button>("D", node_widget::node_header_size, node_widget::node_header_size);
+            _set_decimation_label(*decimation_label);
+
+            decimation_button->set_callback(
+                [this, label = decimation_label.get()]()
+                {
+                    const auto current = std::find(decimations.begin(), decimations.end(), _probe.get_decimation());
+                    const auto next = (current == decimations.end() || current + 1 == decimations.end()) ?
+                        decimations.begin() : current + 1;
+                    _probe.set_decimation(*next);
+                    _set_decimation_label(*label);
+                });
+
+            _scope_top = node_widget::node_header_size + node_widget::socket_size;
+            resize_height(_scope_top + scope_height + node_widget::node_header_size * 1.5f);
+
+            const auto controls_y_pos = _scope_top + scope_height + 2.f;
+            insert_widget(
+                width() - node_widget::node_header_size * 4.f, controls_y_pos, std::move(decimation_button));
+            insert_widget(
+                width() - node_widget::node_header_size * 3.f, controls_y_pos, std::move(decimation_label));
+
+            apply_color_theme(View::default_color_theme);
+        }
+
+        void apply_color_theme(const View::color_theme& theme) override
+        {
+            plugin_node_widget::apply_color_theme(theme);
+            _trace_color = theme.primary;
+            _text_color = theme.on_surface;
+        }
+
+        void draw(NVGcontext *vg) override
+        {
+            plugin_node_widget::draw(vg);
+
+            //  Read the samples pushed since the last frame
+            _probe.read(
+                [this](float sample)
+                {
+                    _history[_history_position] = sample;
+                    _history_position = (_history_position + 1u) % history_size;
+                    _peak = std::max(_peak, std::abs(sample));
+                });
+
+            const auto scope_left = static_cast<float>(node_widget::socket_size);
+            const auto scope_width = width() - 2.f * node_widget::socket_size;
+            const auto scope_middle = _scope_top + scope_height * 0.5f;
+
+            nvgBeginPath(vg);
+            nvgRect(vg, scope_left, _scope_top, scope_width, scope_height);
+            nvgStrokeColor(vg, _text_color);
+            nvgStrokeWidth(vg, 0.5f);
+            nvgStroke(vg);
+
+            //  Oldest sample on the left, clipped to [-1, 1]
+            nvgBeginPath(vg);
+            for (auto i = 0u; i < history_size; ++i) {
+                const auto sample = std::clamp(_history[(_history_position + i) % history_size], -1.f, 1.f);
+                const auto x = scope_left + scope_width * static_cast<float>(i) / static_cast<float>(history_size - 1u);
+                const auto y = scope_middle - sample * scope_height * 0.5f;
+                if (i == 0u)
+                    nvgMoveTo(vg, x, y);
+                else
+                    nvgLineTo(vg, x, y);
+            }
+            nvgStrokeColor(vg, _trace_color);
+            nvgStrokeWidth(vg, 1.f);
+            nvgStroke(vg);
+
+            //  Peak level, with a slow release
+            char text[16];
+            if (_peak > 0.f)
+                snprintf(text, sizeof(text), "%.1f dB", 20.f * std::log10(_peak));
+            else
+                snprintf(text, sizeof(text), "-inf dB");
+            nvgFillColor(vg, _text_color);
+            View::draw_text(
+                vg, scope_left, _scope_top + scope_height, scope_width, node_widget::node_header_size,
+                12, text, false, View::horizontal_alignment::left, View::vertical_alignment::center);
+            _peak *= 0.9f;
+
+            //  Keep reading while displayed
+            invalidate();
+        }
+
+    protected:
+        nlohmann::json serialize_internal_state() override
+        {
+            return { { "decimation", _probe.get_decimation() } };
+        }
+
+    private:
+        void _set_decimation_label(View::label& label)
+        {
+            label.set_text("x" + std::to_string(_probe.get_decimation()));
+        }
+
+        probe _probe;
+        std::array<float, history_size> _history{};
+        unsigned int _history_position{0u};
+        float _peak{0.f};
+        float _scope_top{0.f};
+        NVGcolor _trace_color{};
+        NVGcolor _text_color{};
+    };
+
+    probe_node_widget_plugin::probe_node_widget_plugin(synthesizer& synth)
+    :   node_widget_factory::plugin{probe_node_widget_uid, "Probe", "Control"},
+        _synth{synth}
+    {
+    }
+
+    std::unique_ptr<plugin_node_widget> probe_node_widget_plugin::create_node(abstract_configuration_directory&)
+    {
+        return std::make_unique<probe_node_widget>(_synth.allocate_probe());
+    }
+
+    std::unique_ptr<plugin_node_widget> probe_node_widget_plugin::create_node(abstract_configuration_directory&, const nlohmann::json& internal_state)
+    {
+        const auto decimation = internal_state.value("decimation", 1u);
+        return std::make_unique<probe_node_widget>(_synth.allocate_probe(), decimation);
+    }
+
+    const std::optional<std::vector<unsigned int>>& probe_node_widget_plugin::silence_inputs()
+    {
+        //  out = in
+        static const std::optional<std::vector<unsigned int>> probe_silence_inputs{std::vector<unsigned int>{0u}};
+        return probe_silence_inputs;
+    }
+}
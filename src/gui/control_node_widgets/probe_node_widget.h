@@ -0,0 +1,21 @@
+#ifndef GAMMOU_PROBE_NODE_WIDGET_H_
+#define GAMMOU_PROBE_NODE_WIDGET_H_
+
+#include "synthesizer/synthesizer.h"
+#include "plugin_system/node_widget_factory.h"
+
+namespace Gammou {
+
+    class probe_node_widget_plugin : public node_widget_factory::plugin {
+    public:
+        probe_node_widget_plugin(synthesizer& synth);
+        std::unique_ptr<plugin_node_widget> create_node(abstract_configuration_directory&) override;
+        std::unique_ptr<plugin_node_widget> create_node(abstract_configuration_directory&, const nlohmann::json&) override;
+        const std::optional<std::vector<unsigned int>>& silence_inputs() override;
+    private:
+        synthesizer& _synth;
+    };
+
+}
+
+#endif
@@ -28,6 +28,8 @@ namespace Gammou {
         std::unique_ptr<node_widget> create_node(abstract_configuration_directory& parent_config);
 
         void rescan_factory();
+
+        node_widget_factory& factory() noexcept { return _factory; }
     private:
         std::unique_ptr<plugin_node_widget> _create_node_from_recipe(const factory_recipe&, abstract_configuration_directory& parent_config);
 
@@ -2,6 +2,7 @@
 #define GAMMOU_SYNTHESIZER_GUI_H
 
 #include "synthesizer/synthesizer.h"
+#include "plugin_system/patch_format.h"
 #include "circuit_editor.h"
 
 namespace Gammou {
@@ -25,10 +26,10 @@ namespace Gammou {
         static std::unique_ptr<circuit_editor> make_editor(synthesizer::circuit_controller& circuit);
 
     private:
-        static constexpr auto _master_from_polyphonic_node_id = "from-polyphonic";
-        static constexpr auto _master_output_node_id = "output";
-        static constexpr auto _polyphonic_midi_input_node_id = "midi-input";
-        static constexpr auto _polyphonic_to_master_node_id = "to-master";
+        static constexpr auto _master_from_polyphonic_node_id = patch_format::master_from_polyphonic_node_id;
+        static constexpr auto _master_output_node_id = patch_format::master_output_node_id;
+        static constexpr auto _polyphonic_midi_input_node_id = patch_format::polyphonic_midi_input_node_id;
+        static constexpr auto _polyphonic_to_master_node_id = patch_format::polyphonic_to_master_node_id;
 
 
     };
@@ -13,6 +13,19 @@ extern "C" {
 extern const float _sample_rate;        // The synthesizer sample rate (Hz)
 extern const float _sample_duration;    // The synthesizer sample duration (Sec)
 
+/**
+ * \brief Node state layout
+ *
+ *  Small, frequently used, variables (indexes, filter memory) are declared first
+ *  and large buffers (delay lines) last.
+ *
+ *  The states of a node are allocated next to each other, so a variable declared after the buffers
+ *  shares a cache line with the first variables of the next state : this order was not measured faster
+ *  than the reverse one, and padding the hot variables to a cache line was measured slower.
+ *  Use tools/state_layout_benchmark.c before changing a state layout for performance.
+ *  Alignment attributes must not be used in node states as node states are not guaranteed to be aligned on cache lines.
+ */
+
 #ifdef __cplusplus
 }
 #endif
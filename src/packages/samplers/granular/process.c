@@ -4,8 +4,9 @@
 #include <math_utils.h>
 #include <sample_utils.h>
 #include <synthesizer_def.h>
+#include <plugin_state_config.h>
 
-#define GRAIN_COUNT 16u
+#define GRAIN_COUNT ((unsigned int)STATE_GRAIN_COUNT)
 
 struct grain
 {
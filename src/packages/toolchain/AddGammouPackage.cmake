@@ -20,7 +20,7 @@ function(add_llvm_bytecode_object)
         ARGS                                # prefix
         ""                                  # bools
         "SOURCE;OUTPUT"                     # monovalued
-        "INCLUDE_DIRECTORIES"               # multivalued
+        "INCLUDE_DIRECTORIES;DEPENDS"       # multivalued
         ${ARGN}
     )
 
@@ -53,7 +53,8 @@ function(add_llvm_bytecode_object)
             -c ${CLANG_IR_FLAGS}
             -o ${ARGS_OUTPUT}
         DEPENDS
-            ${source_file}
+            ${ARGS_SOURCE}
+            ${ARGS_DEPENDS}
         COMMAND_EXPAND_LISTS
     )
 endfunction()
@@ -86,6 +87,22 @@ function(add_gammou_plugin target)
     #   Make plugin directory at configuration time
     file(MAKE_DIRECTORY ${plugin_dir})
 
+    #    Generate the state config header from the plugin state parameters
+    set(state_config_header ${plugin_dir}/plugin_state_config.h)
+    add_custom_command(
+        OUTPUT
+            ${state_config_header}
+        COMMAND
+            Python3::Interpreter
+        ARGS
+            ${GAMMOU_PLUGIN_GENERATOR_PATH}
+            --plugin-content ${ARGS_PLUGIN_FILE}
+            --state-config-header ${state_config_header}
+        DEPENDS
+            ${GAMMOU_PLUGIN_GENERATOR_PATH}
+            ${ARGS_PLUGIN_FILE}
+    )
+
     #    Compile each source to llvm bytecode
     foreach(source_file ${ARGS_SOURCES})
         get_filename_component(source_name ${source_file} NAME_WE)
@@ -97,6 +114,9 @@ function(add_gammou_plugin target)
                 ${output_file}
             INCLUDE_DIRECTORIES
                 ${ARGS_INCLUDE_DIRECTORIES}
+                ${plugin_dir}
+            DEPENDS
+                ${state_config_header}
         )
         list(APPEND bytecode_modules ${output_file})
     endforeach()
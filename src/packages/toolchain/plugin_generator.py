@@ -2,6 +2,7 @@
 
 import argparse
 import json
+import re
 
 def generate_plugin(dest, src, modules):
     """
@@ -14,14 +15,58 @@ def generate_plugin(dest, src, modules):
     input_content["modules"] = modules
     output_file.write(json.dumps(input_content, sort_keys=True, indent=4))
 
+def state_parameter_macro(name):
+    """
+        Convert a state parameter name (ex : max-delay-ms) to a macro name (ex : STATE_MAX_DELAY_MS)
+    """
+    return "STATE_" + re.sub("[^A-Za-z0-9]", "_", name).upper()
+
+def generate_state_config_header(dest, src):
+    """
+        dest : destination C header file
+        src  : source plugin json file
+
+        Each plugin state parameter is defined as a macro which can be used to size the node state,
+        ex : "state-parameters" : { "max-delay-ms" : 1000 }  =>  #define STATE_MAX_DELAY_MS 1000
+        Use integer values for parameters used in array sizes : they must be integer constant expressions.
+    """
+    with open(src, "rb") as input_file:
+        input_content = json.loads(input_file.read())
+
+    parameters = input_content.get("state-parameters", {})
+    lines = [
+        "/* Generated from the plugin state parameters, do not edit */",
+        "#ifndef GAMMOU_PLUGIN_STATE_CONFIG_H_",
+        "#define GAMMOU_PLUGIN_STATE_CONFIG_H_",
+        ""]
+
+    for name, value in sorted(parameters.items()):
+        if isinstance(value, bool) or not isinstance(value, (int, float)):
+            raise ValueError("State parameter '{}' must be a number".format(name))
+        lines.append("#define {} {}".format(state_parameter_macro(name), repr(value)))
+
+    lines += ["", "#endif", ""]
+
+    with open(dest, "w+") as output_file:
+        output_file.write("\n".join(lines))
+
 if __name__ == '__main__':
     parser = argparse.ArgumentParser(description="Generate a plugin content file with given module list")
-    parser.add_argument("-o", "--output", help="plugin json output file", nargs=1, required=True)
+    parser.add_argument("-o", "--output", help="plugin json output file", nargs=1, required=False)
     parser.add_argument("--plugin-content", help="plugin json source file", nargs=1, required=True)
-    parser.add_argument("--modules", help="additional bytecode module", nargs='+', required=True)
+    parser.add_argument("--modules", help="additional bytecode module", nargs='+', required=False)
+    parser.add_argument("--state-config-header", help="plugin state config header output file", nargs=1, required=False)
     args = parser.parse_args()
 
-    generate_plugin(
-        args.output[0],
-        args.plugin_content[0],
-        args.modules)
\ No newline at end of file
+    if args.state_config_header is not None:
+        generate_state_config_header(
+            args.state_config_header[0],
+            args.plugin_content[0])
+
+    if args.output is not None:
+        if args.modules is None:
+            parser.error("--modules is required to generate a plugin content file")
+        generate_plugin(
+            args.output[0],
+            args.plugin_content[0],
+            args.modules)
@@ -2,22 +2,29 @@
 #include <math.h>
 #include <synthesizer_def.h>
 
-#include "../common_libs/sample_queue.h"
+#include <plugin_state_config.h>
 
-#define QUEUE_SIZE 48000u
+#include "../common_libs/sample_queue.h"
 
-//  state = [read_idx +, write_idx +, read_idx -, write_idx -, data...+, data...+]
+//  The queue is sized for the maximum delay at the maximum sample rate,
+//  but only the part needed at the current sample rate is used.
+#define QUEUE_SIZE (STATE_MAX_DELAY_MS * STATE_MAX_SAMPLE_RATE / 1000u + 2u)
 
 struct delay_state {
     int write_idx;
+    int size;
     float data[QUEUE_SIZE];
 };
 
 void node_initialize(struct delay_state*state)
 {
+    const unsigned int size = (unsigned int)(0.001f * STATE_MAX_DELAY_MS * _sample_rate) + 2u;
+
     state->write_idx = 0;
+    state->size = size < QUEUE_SIZE ? size : QUEUE_SIZE;
 
-    for (int i = 0; i < QUEUE_SIZE; ++i)
+    //  The unused part of the queue is never touched
+    for (int i = 0; i < state->size; ++i)
         state->data[i] = 0.f;
 }
 
@@ -25,13 +32,14 @@ void node_process(struct delay_state *state, float in, float g, float t,  float
 {
     const float gain = powf(g, t);
 
-    const float fidx = t * _sample_rate;
+    const float max_fidx = (float)(state->size - 2);
+    const float fidx = fminf(t * _sample_rate, max_fidx);
     const unsigned int idx = fidx;
     const float factor = fidx - (float)idx;
 
-    queue_write_sample(in, &(state->write_idx), state->data, QUEUE_SIZE);
+    queue_write_sample(in, &(state->write_idx), state->data, state->size);
 
     *out = gain * (
-        queue_read_sample(idx, state->write_idx, state->data, QUEUE_SIZE) * (1.f - factor) +
-        queue_read_sample(idx + 1, state->write_idx, state->data, QUEUE_SIZE) * factor);
+        queue_read_sample(idx, state->write_idx, state->data, state->size) * (1.f - factor) +
+        queue_read_sample(idx + 1, state->write_idx, state->data, state->size) * factor);
 }
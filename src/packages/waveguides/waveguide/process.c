@@ -2,37 +2,47 @@
 #include <math.h>
 #include <synthesizer_def.h>
 
+#include <plugin_state_config.h>
+
 #include "../common_libs/sample_queue.h"
 
-#define QUEUE_SIZE 10000u
+//  The queues are sized for the maximum delay at the maximum sample rate,
+//  but only the part needed at the current sample rate is used.
+#define QUEUE_SIZE (STATE_MAX_DELAY_MS * STATE_MAX_SAMPLE_RATE / 1000u + 2u)
 
 struct waveguide_state {
     int write_idx_p;
     int write_idx_m;
+    int size;
+    float delay;
     float data_p[QUEUE_SIZE];
     float data_m[QUEUE_SIZE];
-    float delay;
 };
 
 void node_initialize(struct waveguide_state *state)
 {
+    const unsigned int size = (unsigned int)(0.001f * STATE_MAX_DELAY_MS * _sample_rate) + 2u;
+
     state->write_idx_p = 0;
     state->write_idx_m = 0;
+    state->size = size < QUEUE_SIZE ? size : QUEUE_SIZE;
     state->delay = _sample_duration;
 
-    for (int i = 0; i < QUEUE_SIZE; ++i)
+    //  The unused part of the queues is never touched
+    for (int i = 0; i < state->size; ++i)
         state->data_p[i] = 0.f;
-    for (int i = 0; i < QUEUE_SIZE; ++i)
+    for (int i = 0; i < state->size; ++i)
         state->data_m[i] = 0.f;
 }
 
 void node_push(struct waveguide_state *state, float in_m, float t, float g, float in_p)
 {
-    const float delay = t > _sample_duration ? t : _sample_duration;
+    const float max_delay = (float)(state->size - 1) * _sample_duration;
+    const float delay = fminf(t > _sample_duration ? t : _sample_duration, max_delay);
     const float gain = powf(g, delay);
     state->delay = delay;
-    queue_write_sample(gain * in_p, &(state->write_idx_p), state->data_p, QUEUE_SIZE);
-    queue_write_sample(gain * in_m, &(state->write_idx_m), state->data_m, QUEUE_SIZE);
+    queue_write_sample(gain * in_p, &(state->write_idx_p), state->data_p, state->size);
+    queue_write_sample(gain * in_m, &(state->write_idx_m), state->data_m, state->size);
 }
 
 void node_pull(struct waveguide_state *state, float *out_p, float *out_m)
@@ -42,9 +52,9 @@ void node_pull(struct waveguide_state *state, float *out_p, float *out_m)
     const float factor = fidx - (float)idx;
 
     *out_p = (
-        queue_read_sample(idx, state->write_idx_p, state->data_p, QUEUE_SIZE) * (1.f - factor) +
-        queue_read_sample(idx + 1, state->write_idx_p, state->data_p, QUEUE_SIZE) * factor);
+        queue_read_sample(idx, state->write_idx_p, state->data_p, state->size) * (1.f - factor) +
+        queue_read_sample(idx + 1, state->write_idx_p, state->data_p, state->size) * factor);
     *out_m = (
-        queue_read_sample(idx, state->write_idx_m, state->data_m, QUEUE_SIZE) * (1.f - factor) +
-        queue_read_sample(idx + 1, state->write_idx_m, state->data_m, QUEUE_SIZE) * factor);
+        queue_read_sample(idx, state->write_idx_m, state->data_m, state->size) * (1.f - factor) +
+        queue_read_sample(idx + 1, state->write_idx_m, state->data_m, state->size) * factor);
 }
@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <unordered_map>
+
+#include <llvm/Analysis/BlockFrequencyInfo.h>
+#include <llvm/Analysis/BranchProbabilityInfo.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/Analysis/PostDominators.h>
+#include <llvm/Analysis/TargetLibraryInfo.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/IR/Operator.h>
+
+#include "cost_model.h"
+
+namespace Gammou {
+
+    /*
+     *  Rough instruction costs, in cycles, for a modern out of order x86 or arm core.
+     *  Latencies are favored over throughputs as dsp code is mostly made of dependency chains.
+     */
+    static constexpr auto integer_op_cost = 1.;
+    static constexpr auto integer_mul_cost = 3.;
+    static constexpr auto integer_div_cost = 25.;
+    static constexpr auto float_op_cost = 4.;
+    static constexpr auto float_div_cost = 14.;
+    static constexpr auto float_sqrt_cost = 16.;
+    static constexpr auto load_cost = 4.;
+    static constexpr auto store_cost = 1.;
+    static constexpr auto transcendental_cost = 40.;   //  sin, exp, pow, ...
+    static constexpr auto unknown_call_cost = 20.;
+    static constexpr auto max_call_depth = 8u;
+
+    class function_cost_estimator {
+    public:
+        explicit function_cost_estimator(const llvm::Module& module)
+        :   _library_info_impl{llvm::Triple{module.getTargetTriple()}}
+        {}
+
+        double function_cost(const llvm::Function& function, unsigned int depth = 0u)
+        {
+            if (function.isDeclaration())
+                return _declaration_cost(function.getName());
+
+            //  Recursive functions are not expected in dsp code
+            if (depth > max_call_depth)
+                return unknown_call_cost;
+
+            auto it = _function_costs.find(&function);
+            if (it != _function_costs.end())
+                return it->second;
+
+            //  The analysis api require non const functions, but they are left untouched
+            auto& func = const_cast<llvm::Function&>(function);
+            llvm::TargetLibraryInfo library_info{_library_info_impl};
+            llvm::DominatorTree dominator_tree{func};
+            llvm::PostDominatorTree post_dominator_tree{func};
+            llvm::LoopInfo loop_info{dominator_tree};
+            llvm::BranchProbabilityInfo branch_info{func, loop_info, &library_info, &dominator_tree, &post_dominator_tree};
+            llvm::BlockFrequencyInfo frequency_info{func, branch_info, loop_info};
+
+            const auto entry_frequency = static_cast<double>(frequency_info.getEntryFreq());
+            double cost = 0.;
+
+            for (const auto& block : function) {
+                const auto frequency =
+                    static_cast<double>(frequency_info.getBlockFreq(&block).getFrequency()) / entry_frequency;
+                double block_cost = 0.;
+
+                for (const auto& instruction : block)
+                    block_cost += _instruction_cost(instruction, depth);
+
+                cost += frequency * block_cost;
+            }
+
+            _function_costs[&function] = cost;
+            return cost;
+        }
+
+    private:
+        double _instruction_cost(const llvm::Instruction& instruction, unsigned int depth)
+        {
+            if (llvm::isa<llvm::DbgInfoIntrinsic>(instruction))
+                return 0.;
+
+            if (const auto call = llvm::dyn_cast<llvm::CallBase>(&instruction)) {
+                const auto callee = call->getCalledFunction();
+                return callee != nullptr ? function_cost(*callee, depth + 1u) : unknown_call_cost;
+            }
+
+            switch (instruction.getOpcode()) {
+                case llvm::Instruction::PHI:
+                case llvm::Instruction::BitCast:
+                case llvm::Instruction::Ret:
+                case llvm::Instruction::Br:
+                case llvm::Instruction::Alloca:
+                    return 0.;
+
+                case llvm::Instruction::GetElementPtr:
+                    return llvm::cast<llvm::GetElementPtrInst>(instruction).hasAllConstantIndices() ?
+                        0. : integer_op_cost;
+
+                case llvm::Instruction::Mul:
+                    return integer_mul_cost;
+
+                case llvm::Instruction::UDiv:
+                case llvm::Instruction::SDiv:
+                case llvm::Instruction::URem:
+                case llvm::Instruction::SRem:
+                    return integer_div_cost;
+
+                case llvm::Instruction::FAdd:
+                case llvm::Instruction::FSub:
+                case llvm::Instruction::FMul:
+                case llvm::Instruction::FNeg:
+                case llvm::Instruction::FCmp:
+                case llvm::Instruction::FPToSI:
+                case llvm::Instruction::FPToUI:
+                case llvm::Instruction::SIToFP:
+                case llvm::Instruction::UIToFP:
+                case llvm::Instruction::FPExt:
+                case llvm::Instruction::FPTrunc:
+                    return float_op_cost;
+
+                case llvm::Instruction::FDiv:
+                    return float_div_cost;
+
+                case llvm::Instruction::FRem:
+                    return transcendental_cost;
+
+                case llvm::Instruction::Load:
+                    return load_cost;
+
+                case llvm::Instruction::Store:
+                    return store_cost;
+
+                default:
+                    return integer_op_cost;
+            }
+        }
+
+        static double _declaration_cost(llvm::StringRef name)
+        {
+            //  Cheap intrinsics and libm functions
+            static const llvm::StringRef cheap_functions[] = {
+                "fabs", "copysign", "minnum", "maxnum", "floor", "ceil", "trunc", "round", "rint",
+                "llvm.lifetime", "llvm.assume", "llvm.memset", "llvm.memcpy"};
+            static const llvm::StringRef sqrt_functions[] = {"sqrt", "llvm.sqrt"};
+            static const llvm::StringRef fma_functions[] = {"llvm.fma", "llvm.fmuladd"};
+
+            const auto name_contains =
+                [name](llvm::StringRef pattern) { return name.contains(pattern); };
+
+            if (std::any_of(std::begin(fma_functions), std::end(fma_functions), name_contains))
+                return float_op_cost;
+            else if (std::any_of(std::begin(sqrt_functions), std::end(sqrt_functions), name_contains))
+                return float_sqrt_cost;
+            else if (std::any_of(std::begin(cheap_functions), std::end(cheap_functions), name_contains))
+                return integer_op_cost;
+            else
+                return transcendental_cost;
+        }
+
+        llvm::TargetLibraryInfoImpl _library_info_impl;
+        std::unordered_map<const llvm::Function*, double> _function_costs{};
+    };
+
+    static std::size_t state_size(const llvm::Argument& state, const llvm::DataLayout& layout)
+    {
+#if LLVM_VERSION_MAJOR < 15
+        //  Typed pointers : the state size is given by the pointed type
+        const auto pointed_type = state.getType()->getPointerElementType();
+        if (pointed_type->isSized())
+            return layout.getTypeAllocSize(pointed_type);
+#endif
+        //  Use the largest type used to access the state
+        std::size_t size = 0u;
+        for (const auto user : state.users()) {
+            llvm::Type *type = nullptr;
+
+            if (const auto gep = llvm::dyn_cast<llvm::GEPOperator>(user))
+                type = gep->getSourceElementType();
+            else if (const auto load = llvm::dyn_cast<llvm::LoadInst>(user))
+                type = load->getType();
+            else if (const auto store = llvm::dyn_cast<llvm::StoreInst>(user))
+                type = store->getValueOperand()->getType();
+
+            if (type != nullptr && type->isSized())
+                size = std::max<std::size_t>(size, layout.getTypeAllocSize(type));
+        }
+
+        return size;
+    }
+
+    static const llvm::Function *find_process_function(const llvm::Module& module, std::size_t io_arg_count)
+    {
+        const llvm::Function *process_function = nullptr;
+
+        for (const auto& function : module) {
+            const auto arg_count = function.arg_size();
+
+            if (function.isDeclaration() || (arg_count != io_arg_count && arg_count != io_arg_count + 1u))
+                continue;
+
+            //  Prefer a function named as a process function if several signatures match
+            if (process_function == nullptr || function.getName().contains("process"))
+                process_function = &function;
+        }
+
+        return process_function;
+    }
+
+    node_cost estimate_node_cost(
+        const llvm::Module& module,
+        unsigned int input_count, unsigned int output_count,
+        bool use_static_memory)
+    {
+        const auto io_arg_count = input_count + output_count + (use_static_memory ? 1u : 0u);
+        const auto process_function = find_process_function(module, io_arg_count);
+
+        if (process_function == nullptr)
+            return {};
+
+        node_cost cost{};
+        function_cost_estimator estimator{module};
+        cost.cycles = estimator.function_cost(*process_function);
+
+        if (process_function->arg_size() > io_arg_count) {
+            const auto state_arg = process_function->getArg(use_static_memory ? 1u : 0u);
+            cost.state_bytes = state_size(*state_arg, module.getDataLayout());
+        }
+
+        return cost;
+    }
+
+}
@@ -0,0 +1,34 @@
+#ifndef GAMMOU_COST_MODEL_H_
+#define GAMMOU_COST_MODEL_H_
+
+#include <cstddef>
+#include <llvm/IR/Module.h>
+
+namespace Gammou {
+
+    /**
+     * \brief Static cost estimate of a node
+     */
+    struct node_cost
+    {
+        double cycles{0.};              //<< Estimated cpu cycles needed to process one sample
+        std::size_t state_bytes{0u};    //<< Size of the node state, allocated for each instance (voice)
+    };
+
+    /**
+     * \brief Estimate the cost of a node from its plugin module IR.
+     *  The process function is identified by its signature:
+     *  ([static memory chunk], [state], inputs..., outputs...)
+     *  Cycles are computed by weighting each instruction with a rough cost and each basic block
+     *  with its estimated execution frequency (branch probabilities, loop trip counts).
+     * \note This is an order of magnitude estimate: it ignores the optimizations
+     *  applied once the node is inlined into a circuit
+     */
+    node_cost estimate_node_cost(
+        const llvm::Module& module,
+        unsigned int input_count, unsigned int output_count,
+        bool use_static_memory);
+
+}
+
+#endif /* GAMMOU_COST_MODEL_H_ */
@@ -0,0 +1,180 @@
+
+#include <algorithm>
+
+#include <DSPJIT/log.h>
+
+#include "external_node_plugin.h"
+#include "headless_patch.h"
+#include "ir_loader.h"
+#include "utils/wav_loader.h"
+
+namespace Gammou {
+
+    /**
+     *  Plugin descriptor deserialization
+     */
+    static external_node_plugin::static_chunk_type _parse_chunk_type(const std::string& str)
+    {
+        if (str == "wav-channel")
+            return  external_node_plugin::static_chunk_type::WAV_CHANNEL;
+        // else if (str == "wav-sample")
+        //     return  external_node_plugin::static_chunk_type::WAV_SAMPLE;
+        else
+            throw std::invalid_argument("Unknown static memory chunk type");
+    }
+
+    void from_json(
+        const nlohmann::json& j,
+        external_node_plugin::descriptor& desc)
+    {
+        j.at("name").get_to(desc.name);
+        j.at("uid").get_to(desc.plugin_id);
+        j.at("category").get_to(desc.category);
+        j.at("input-names").get_to(desc.input_names);
+        j.at("output-names").get_to(desc.output_names);
+        j.at("modules").get_to(desc.modules_paths);
+
+        // static chunk type is optional
+        auto it = j.find("static-chunk-type");
+        desc.static_chunk = it != j.end() ?
+            _parse_chunk_type(it->get<std::string>()) :
+            external_node_plugin::static_chunk_type::NONE;
+
+        // silence inputs are optional
+        it = j.find("silence-inputs");
+        if (it != j.end())
+            desc.silence_input_names = it->get<std::vector<std::string>>();
+    }
+
+    static std::vector<unsigned int> _silence_input_ids(const external_node_plugin::descriptor& desc)
+    {
+        std::vector<unsigned int> ids{};
+
+        for (const auto& name : desc.silence_input_names.value()) {
+            const auto it = std::find(desc.input_names.begin(), desc.input_names.end(), name);
+            if (it == desc.input_names.end())
+                throw std::invalid_argument("Unknown silence input " + name);
+            ids.push_back(static_cast<unsigned int>(it - desc.input_names.begin()));
+        }
+
+        return ids;
+    }
+
+    /**
+     *  external node plugin implementation
+     */
+
+    external_node_plugin::external_node_plugin(
+        const node_factory::plugin_id plugin_id,
+        const std::string& name, const std::string& category,
+        static_chunk_type static_memory,
+        std::unique_ptr<llvm::Module>&& module)
+    :   node_factory::plugin{plugin_id, name, category},
+        _dsp_plugin{std::move(module)},
+        _static_memory_chunk{static_memory}
+    {
+        const auto& proc_info = _dsp_plugin.get_process_info();
+        if (proc_info.use_static_memory && static_memory == static_chunk_type::NONE)
+            throw std::invalid_argument("No chunk type was declared for an external node using static chunk");
+    }
+
+    std::unique_ptr<external_node_plugin> external_node_plugin::from_desc(const external_node_plugin::descriptor& desc, llvm::LLVMContext& ctx)
+    {
+        auto module = load_ir_modules(ctx, desc.modules_paths);
+        auto plugin = std::make_unique<external_node_plugin>(desc.plugin_id, desc.name, desc.category, desc.static_chunk, std::move(module));
+        plugin->set_input_names(std::vector<std::string>(desc.input_names));
+        plugin->set_output_names(std::vector<std::string>(desc.output_names));
+        if (desc.silence_input_names.has_value())
+            plugin->set_silence_inputs(_silence_input_ids(desc));
+        return plugin;
+    }
+
+    std::unique_ptr<DSPJIT::compile_node_class> external_node_plugin::create_node(headless_patch& patch, const nlohmann::json& internal_state)
+    {
+        auto node = create_compile_node();
+
+        if (!use_static_memory() || !internal_state.is_object())
+            return node;
+
+        auto it = internal_state.find("sample-path");
+        if (it == internal_state.end())
+            return node;    // no sample to load
+
+        //  As the gui, a sample which can not be loaded leaves the node without static chunk
+        const auto sample_path = it->get<std::string>();
+        try {
+            LOG_INFO("[external_node_plugin] Loading wav sample '%s'\n", sample_path.c_str());
+
+            if (_static_memory_chunk == static_chunk_type::WAV_CHANNEL) {
+                const auto channel_id = internal_state.at("channel-id").get<unsigned int>();
+                const auto sample = load_wav_from_file(sample_path);
+                patch.register_static_memory_chunk(*node, sample.clone_channel_data(channel_id));
+            }
+            else {
+                LOG_WARNING("[external_node_plugin] Unsupported chunk type\n");
+            }
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR("[external_node_plugin] Unable to load wav sample : '%s'\n", e.what());
+        }
+
+        return node;
+    }
+
+    std::unique_ptr<DSPJIT::compile_node_class> external_node_plugin::create_compile_node()
+    {
+        return _dsp_plugin.create_node();
+    }
+
+    std::unique_ptr<llvm::Module> external_node_plugin::module()
+    {
+        return _dsp_plugin.create_module();
+    }
+
+    const std::vector<function_statistics>& external_node_plugin::statistics()
+    {
+        // Statistics are computed on demand as native code generation is not free
+        if (!_statistics.has_value())
+            _statistics = compute_module_statistics(*_dsp_plugin.create_module());
+        return _statistics.value();
+    }
+
+    const node_cost& external_node_plugin::cost()
+    {
+        if (!_cost.has_value()) {
+            const auto& proc_info = _dsp_plugin.get_process_info();
+            _cost = estimate_node_cost(
+                *_dsp_plugin.create_module(),
+                proc_info.input_count, proc_info.output_count,
+                proc_info.use_static_memory);
+        }
+        return _cost.value();
+    }
+
+    const std::optional<std::vector<unsigned int>>& external_node_plugin::silence_inputs()
+    {
+        return _silence_inputs;
+    }
+
+    void external_node_plugin::set_input_names(std::vector<std::string>&& names)
+    {
+        const auto& proc_info = _dsp_plugin.get_process_info();
+        if (names.size() == proc_info.input_count)
+            _node_input_names = std::move(names);
+    }
+
+    void external_node_plugin::set_output_names(std::vector<std::string>&& names)
+    {
+        const auto& proc_info = _dsp_plugin.get_process_info();
+        if (names.size() == proc_info.output_count)
+            _node_output_names = std::move(names);
+    }
+
+    void external_node_plugin::set_silence_inputs(std::vector<unsigned int>&& inputs)
+    {
+        const auto& proc_info = _dsp_plugin.get_process_info();
+        if (std::all_of(inputs.begin(), inputs.end(), [&](unsigned int input) { return input < proc_info.input_count; }))
+            _silence_inputs = std::move(inputs);
+    }
+}
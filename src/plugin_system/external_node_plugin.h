@@ -0,0 +1,95 @@
+#ifndef GAMMOU_EXTERNAL_NODE_PLUGIN_H_
+#define GAMMOU_EXTERNAL_NODE_PLUGIN_H_
+
+#include <DSPJIT/external_plugin.h>
+
+#include <filesystem>
+#include <optional>
+#include <nlohmann/json.hpp>
+
+#include "node_factory.h"
+
+namespace Gammou
+{
+    /**
+     * \brief Plugin implementation for node whose process is defined in external bitcode.
+     *  The gui counterpart, external_plugin, add the static chunk management user interface.
+     */
+    class external_node_plugin : public node_factory::plugin {
+    public:
+
+        /**
+         * \brief Define different sources of data for the static memory chunk if used
+         * These map to a given memory layout that the nodes should handle.
+         */
+        enum class static_chunk_type
+        {
+            NONE,           //<< No static chunk is used
+            WAV_CHANNEL,    //<< Data from a wav single channel is used as static chunk
+            // WAV_SAMPLE      //<< Data from a wav's all channels is used as a static chunk
+        };
+
+        struct descriptor
+        {
+            node_factory::plugin_id plugin_id{0u};
+            std::string name{};
+            std::string category{};
+            std::vector<std::string> input_names{};
+            std::vector<std::string> output_names{};
+            std::vector<std::filesystem::path> modules_paths{};
+            static_chunk_type static_chunk{static_chunk_type::NONE};
+            std::optional<std::vector<std::string>> silence_input_names{};
+        };
+
+        external_node_plugin(
+            const node_factory::plugin_id plugin_id,
+            const std::string& name, const std::string& category,
+            const static_chunk_type static_memory,
+            std::unique_ptr<llvm::Module>&& module);
+
+        external_node_plugin(const external_node_plugin&) = delete;
+        external_node_plugin(external_node_plugin&&) = default;
+        ~external_node_plugin() = default;
+
+        static std::unique_ptr<external_node_plugin> from_desc(const descriptor&, llvm::LLVMContext&);
+
+        /**
+         * \brief Create a node, and load the sample referenced by its state into its static memory chunk
+         */
+        std::unique_ptr<DSPJIT::compile_node_class> create_node(headless_patch&, const nlohmann::json&) override;
+        std::unique_ptr<llvm::Module> module() override;
+        const std::vector<function_statistics>& statistics() override;
+        const node_cost& cost() override;
+        const std::optional<std::vector<unsigned int>>& silence_inputs() override;
+
+        /**
+         * \brief Create a node without loading its static memory chunk
+         */
+        std::unique_ptr<DSPJIT::compile_node_class> create_compile_node();
+
+        bool use_static_memory() const noexcept { return _dsp_plugin.get_process_info().use_static_memory; }
+        auto get_static_chunk_type() const noexcept { return _static_memory_chunk; }
+        const auto& get_input_names() const noexcept { return _node_input_names; }
+        const auto& get_output_names() const noexcept { return _node_output_names; }
+
+        void set_input_names(std::vector<std::string>&& names);
+        void set_output_names(std::vector<std::string>&& names);
+        void set_silence_inputs(std::vector<unsigned int>&& inputs);
+
+    private:
+        DSPJIT::external_plugin _dsp_plugin;
+        static_chunk_type _static_memory_chunk{};
+        std::vector<std::string> _node_input_names{};
+        std::vector<std::string> _node_output_names{};
+        std::optional<std::vector<function_statistics>> _statistics{};
+        std::optional<node_cost> _cost{};
+        std::optional<std::vector<unsigned int>> _silence_inputs{};
+    };
+
+    /**
+     * \brief Deserialize an external plugin descriptor from a json object
+     */
+    void from_json(const nlohmann::json&, external_node_plugin::descriptor&);
+}
+
+#endif /* GAMMOU_EXTERNAL_NODE_PLUGIN_H_ */
@@ -0,0 +1,240 @@
+
+#include <DSPJIT/log.h>
+
+#include "headless_patch.h"
+#include "patch_format.h"
+
+namespace Gammou {
+
+    headless_patch::headless_patch(synthesizer& synth, node_factory& factory)
+    :   _synthesizer{synth},
+        _factory{factory}
+    {
+        //  Describe the master circuit nodes using their plugins properties, as the application does
+        _synthesizer.set_master_node_info_provider(
+            [this](const DSPJIT::compile_node_class& node)
+            {
+                const auto it = _node_entries.find(&node);
+                return it != _node_entries.end() ? it->second.info : master_branches::node_info{};
+            });
+    }
+
+    headless_patch::~headless_patch() noexcept
+    {
+        _synthesizer.set_master_node_info_provider({});
+        _release_nodes(content_mark{});
+    }
+
+    void headless_patch::deserialize(const nlohmann::json& json)
+    {
+        //  Compile each circuit once, when the whole patch is loaded
+        synthesizer::compile_transaction transaction{_synthesizer};
+        auto& master_controller = _synthesizer.get_master_circuit_controller();
+        auto& polyphonic_controller = _synthesizer.get_polyphonic_circuit_controller();
+
+        try {
+            patch_format::synthesizer_state state{};
+            from_json(json, state);
+
+            clear();
+
+            _circuit_controller = &master_controller;
+            deserialize_circuit(
+                state.master_circuit,
+                [this](const std::string& identifier) -> DSPJIT::compile_node_class&
+                {
+                    if (identifier == patch_format::master_from_polyphonic_node_id)
+                        return _synthesizer.from_polyphonic_node();
+                    else if (identifier == patch_format::master_output_node_id)
+                        return _synthesizer.output_node();
+                    else
+                        throw std::runtime_error("headless_patch::deserialize : Unknown internal node : " + identifier);
+                });
+
+            _circuit_controller = &polyphonic_controller;
+            const auto first_polyphonic_node = _nodes.size();
+            deserialize_circuit(
+                state.polyphonic_circuit,
+                [this](const std::string& identifier) -> DSPJIT::compile_node_class&
+                {
+                    if (identifier == patch_format::polyphonic_midi_input_node_id)
+                        return _synthesizer.midi_input_node();
+                    else if (identifier == patch_format::polyphonic_to_master_node_id)
+                        return _synthesizer.to_master_node();
+                    else
+                        throw std::runtime_error("headless_patch::deserialize : Unknown internal node : " + identifier);
+                });
+
+            _circuit_controller = nullptr;
+            _synthesizer.set_voice_mode(state.voicing_mode);
+
+            // Used to enforce the voice memory cap, as the application does
+            _synthesizer.set_voice_state_size(_state_bytes(first_polyphonic_node));
+
+            // Recompile the new loaded circuit, a patch which can not be compiled is not loaded
+            master_controller.compile();
+            polyphonic_controller.compile();
+            transaction.commit();
+
+            LOG_INFO("[headless patch] Loaded %zu nodes\n", _nodes.size());
+        }
+        catch (const std::exception&) {
+            _circuit_controller = nullptr;
+            clear();
+            throw;
+        }
+    }
+
+    void headless_patch::clear()
+    {
+        _release_nodes(content_mark{});
+        _synthesizer.set_voice_state_size(0u);
+        _synthesizer.get_master_circuit_controller().compile();
+        _synthesizer.get_polyphonic_circuit_controller().compile();
+    }
+
+    void headless_patch::deserialize_circuit(const nlohmann::json& circuit, const internal_node_resolver& resolver)
+    {
+        //  On failure, the nodes created so far are released before the internal nodes they may be linked to
+        const auto mark = _mark();
+
+        try {
+            const auto& nodes_desc = circuit.at("nodes");
+            std::vector<DSPJIT::compile_node_class*> circuit_nodes{};
+            circuit_nodes.reserve(nodes_desc.size());
+
+            //  Create nodes
+            for (const auto& node_desc : nodes_desc) {
+                const auto& node_json = node_desc.at("node");
+
+                if (node_json.is_string()) {
+                    auto& node = resolver(node_json.get<std::string>());
+                    //  Internal nodes are free
+                    _internal_nodes.push_back(&node);
+                    _node_entries.emplace(&node, node_entry{{0., true, std::nullopt}});
+                    circuit_nodes.push_back(&node);
+                }
+                else {
+                    circuit_nodes.push_back(&_create_node(node_json));
+                }
+            }
+
+            //  Create links
+            for (const auto& link_desc : circuit.at("links")) {
+                const auto& from = link_desc.at("from");
+                const auto& to = link_desc.at("to");
+                const auto from_node = from.at("node").get<std::size_t>();
+                const auto to_node = to.at("node").get<std::size_t>();
+
+                if (from_node >= circuit_nodes.size() || to_node >= circuit_nodes.size())
+                    throw std::invalid_argument("headless_patch::deserialize_circuit : Link to an unknown node");
+
+                circuit_nodes[from_node]->connect(
+                    from.at("out").get<unsigned int>(),
+                    *circuit_nodes[to_node],
+                    to.at("in").get<unsigned int>());
+            }
+        }
+        catch (...) {
+            _release_nodes(mark);
+            throw;
+        }
+    }
+
+    void headless_patch::register_static_memory_chunk(const DSPJIT::compile_node_class& node, std::vector<uint8_t>&& data)
+    {
+        if (_circuit_controller == nullptr)
+            throw std::logic_error("headless_patch::register_static_memory_chunk : No circuit is being deserialized");
+
+        _circuit_controller->register_static_memory_chunk(node, std::move(data));
+        _static_chunks.emplace_back(_circuit_controller, &node);
+    }
+
+    DSPJIT::compile_node_class& headless_patch::_create_node(const nlohmann::json& json)
+    {
+        static const nlohmann::json no_state{};
+        auto& plugin = _factory.get_plugin(json);
+        const auto state_it = json.find("state");
+        const auto first_content_node = _nodes.size();
+
+        auto node = plugin.create_node(*this, state_it != json.end() ? *state_it : no_state);
+        if (!node)
+            throw std::runtime_error("headless_patch : plugin '" + plugin.name() + "' did not create a node");
+
+        node_entry entry{};
+        entry.info.silence_inputs = plugin.silence_inputs();
+
+        if (_nodes.size() == first_content_node) {
+            entry.cost = plugin.cost();
+        }
+        else {
+            //  The nodes created meanwhile are the content of a composite node
+            entry.composite = true;
+            for (auto i = first_content_node; i < _nodes.size(); ++i) {
+                const auto& content_entry = _node_entries.at(_nodes[i].get());
+                if (!content_entry.composite) {
+                    entry.cost.cycles += content_entry.cost.cycles;
+                    entry.cost.state_bytes += content_entry.cost.state_bytes;
+                }
+            }
+        }
+
+        entry.info.cycles = entry.cost.cycles;
+        entry.info.stateless = (entry.cost.state_bytes == 0u);
+
+        auto& node_ref = *node;
+        _node_entries.emplace(&node_ref, std::move(entry));
+        _nodes.emplace_back(std::move(node));
+        return node_ref;
+    }
+
+    std::size_t headless_patch::_state_bytes(std::size_t first_node) const
+    {
+        std::size_t state_bytes = 0u;
+
+        //  The composite nodes content is owned by the patch as well : only the content is counted
+        for (auto i = first_node; i < _nodes.size(); ++i) {
+            const auto& entry = _node_entries.at(_nodes[i].get());
+            if (!entry.composite)
+                state_bytes += entry.cost.state_bytes;
+        }
+
+        return state_bytes;
+    }
+
+    headless_patch::content_mark headless_patch::_mark() const noexcept
+    {
+        return {_nodes.size(), _internal_nodes.size(), _static_chunks.size(), _resources.size()};
+    }
+
+    void headless_patch::_release_nodes(const content_mark& mark) noexcept
+    {
+        //  Unlink every node before destroying them, as the composite nodes own their internal nodes
+        const auto disconnect_inputs =
+            [](DSPJIT::compile_node_class& node)
+            {
+                const auto ic = node.get_input_count();
+                for (auto i = 0u; i < ic; ++i)
+                    node.disconnect(i);
+            };
+
+        for (auto i = mark.node_count; i < _nodes.size(); ++i)
+            disconnect_inputs(*_nodes[i]);
+        for (auto i = mark.internal_node_count; i < _internal_nodes.size(); ++i)
+            disconnect_inputs(*_internal_nodes[i]);
+
+        for (auto i = mark.static_chunk_count; i < _static_chunks.size(); ++i)
+            _static_chunks[i].first->free_static_memory_chunk(*_static_chunks[i].second);
+
+        for (auto i = mark.node_count; i < _nodes.size(); ++i)
+            _node_entries.erase(_nodes[i].get());
+        for (auto i = mark.internal_node_count; i < _internal_nodes.size(); ++i)
+            _node_entries.erase(_internal_nodes[i]);
+
+        _static_chunks.resize(mark.static_chunk_count);
+        _nodes.resize(mark.node_count);
+        _internal_nodes.resize(mark.internal_node_count);
+        _resources.resize(mark.resource_count);
+    }
+
+}
@@ -0,0 +1,119 @@
+#ifndef GAMMOU_HEADLESS_PATCH_H_
+#define GAMMOU_HEADLESS_PATCH_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "node_factory.h"
+#include "synthesizer/synthesizer.h"
+
+namespace Gammou {
+
+    /**
+     * \class headless_patch
+     * \brief Load a patch into a synthesizer without gui : the circuits json are turned
+     *  into dsp node graphs, using a node_factory.
+     *
+     *  The patch owns the nodes it created and the resources they use (parameters, probes,
+     *  static memory chunks) until it is cleared or destroyed.
+     */
+    class headless_patch {
+    public:
+        /**
+         *  \brief Return the node identified by a string in a circuit \see patch_format
+         */
+        using internal_node_resolver = std::function<DSPJIT::compile_node_class&(const std::string&)>;
+
+        headless_patch(synthesizer& synth, node_factory& factory);
+        ~headless_patch() noexcept;
+
+        headless_patch(const headless_patch&) = delete;
+        headless_patch& operator=(const headless_patch&) = delete;
+
+        /**
+         *  \brief Replace the synthesizer circuits by the ones of a patch saved by the gui, and compile them
+         *  \throw std::exception if the patch could not be loaded or compiled, the synthesizer circuits are then empty
+         */
+        void deserialize(const nlohmann::json& json);
+
+        /**
+         *  \brief Remove every node from the synthesizer circuits, and compile them
+         */
+        void clear();
+
+        std::size_t get_node_count() const noexcept { return _nodes.size(); }
+
+        /**
+         *  Interface used by the node_factory plugins while the patch is deserialized
+         */
+
+        synthesizer& get_synthesizer() noexcept { return _synthesizer; }
+
+        /**
+         *  \brief Create the nodes of a circuit and link them. The nodes are owned by the patch
+         *  \param resolver return the internal nodes of the circuit, which are not owned
+         */
+        void deserialize_circuit(const nlohmann::json& circuit, const internal_node_resolver& resolver);
+
+        /**
+         *  \brief Register the static memory chunk of a node of the circuit being deserialized
+         *  \note The chunk is freed when the patch is cleared
+         */
+        void register_static_memory_chunk(const DSPJIT::compile_node_class& node, std::vector<uint8_t>&& data);
+
+        /**
+         *  \brief Keep a resource used by a node (parameter, probe...) until the patch is cleared
+         */
+        template <typename TResource>
+        void hold(TResource&& resource)
+        {
+            _resources.emplace_back(
+                std::make_shared<std::decay_t<TResource>>(std::forward<TResource>(resource)));
+        }
+
+    private:
+        struct node_entry
+        {
+            master_branches::node_info info{};
+            bool composite{false};              //<< The cost of a composite node is the one of its content
+            node_cost cost{};
+        };
+
+        /**
+         *  \brief Number of each element owned by the patch, used to release the ones added since
+         */
+        struct content_mark
+        {
+            std::size_t node_count{0u};
+            std::size_t internal_node_count{0u};
+            std::size_t static_chunk_count{0u};
+            std::size_t resource_count{0u};
+        };
+
+        DSPJIT::compile_node_class& _create_node(const nlohmann::json& json);
+
+        /**
+         *  \brief Return the state size of the nodes created since first_node, for one instance
+         */
+        std::size_t _state_bytes(std::size_t first_node) const;
+        content_mark _mark() const noexcept;
+        void _release_nodes(const content_mark& mark) noexcept;
+
+        synthesizer& _synthesizer;
+        node_factory& _factory;
+        synthesizer::circuit_controller *_circuit_controller{nullptr};  //<< Controller of the circuit being deserialized
+        std::vector<std::unique_ptr<DSPJIT::compile_node_class>> _nodes{};
+        std::vector<DSPJIT::compile_node_class*> _internal_nodes{};
+        std::unordered_map<const DSPJIT::compile_node_class*, node_entry> _node_entries{};
+        std::vector<std::pair<synthesizer::circuit_controller*, const DSPJIT::compile_node_class*>> _static_chunks{};
+        std::vector<std::shared_ptr<void>> _resources{};
+    };
+
+}
+
+#endif /* GAMMOU_HEADLESS_PATCH_H_ */
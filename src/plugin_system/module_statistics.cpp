@@ -0,0 +1,141 @@
+#include <unordered_map>
+
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/Object/ObjectFile.h>
+#include <llvm/Object/SymbolSize.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Target/TargetOptions.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+
+#if LLVM_VERSION_MAJOR >= 14
+#include <llvm/MC/TargetRegistry.h>
+#else
+#include <llvm/Support/TargetRegistry.h>
+#endif
+
+#include <DSPJIT/log.h>
+
+#include "module_statistics.h"
+
+namespace Gammou {
+
+    static std::unique_ptr<llvm::TargetMachine> create_host_target_machine()
+    {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+
+        const auto triple = llvm::sys::getProcessTriple();
+        std::string error{};
+        const auto target = llvm::TargetRegistry::lookupTarget(triple, error);
+
+        if (target == nullptr)
+            throw std::runtime_error("Unable to find host target: " + error);
+
+        //  Use host features in order to get realistic code sizes
+        llvm::StringMap<bool> host_features;
+        std::string features{};
+        if (llvm::sys::getHostCPUFeatures(host_features)) {
+            for (const auto& feature : host_features) {
+                if (!features.empty())
+                    features += ',';
+                features += (feature.second ? "+" : "-") + feature.first().str();
+            }
+        }
+
+        return std::unique_ptr<llvm::TargetMachine>{
+            target->createTargetMachine(
+                triple, llvm::sys::getHostCPUName(), features,
+                llvm::TargetOptions{}, llvm::Reloc::PIC_)};
+    }
+
+    static std::unordered_map<std::string, std::size_t> compute_code_sizes(const llvm::Module& module)
+    {
+        std::unordered_map<std::string, std::size_t> code_sizes{};
+        auto target_machine = create_host_target_machine();
+
+        //  Code generation mutate the module
+        auto clone = llvm::CloneModule(module);
+        clone->setDataLayout(target_machine->createDataLayout());
+        clone->setTargetTriple(target_machine->getTargetTriple().str());
+
+        llvm::SmallVector<char, 0> object_buffer{};
+        llvm::raw_svector_ostream stream{object_buffer};
+        llvm::legacy::PassManager pass_manager{};
+
+        if (target_machine->addPassesToEmitFile(pass_manager, stream, nullptr, llvm::CGFT_ObjectFile))
+            throw std::runtime_error("Host target can not emit object files");
+
+        pass_manager.run(*clone);
+
+        auto object = llvm::object::ObjectFile::createObjectFile(
+            llvm::MemoryBufferRef{llvm::StringRef{object_buffer.data(), object_buffer.size()}, clone->getName()});
+
+        if (!object) {
+            llvm::consumeError(object.takeError());
+            throw std::runtime_error("Unable to read generated object file");
+        }
+
+        for (const auto& symbol_size : llvm::object::computeSymbolSizes(*object.get())) {
+            const auto& symbol = symbol_size.first;
+            auto type = symbol.getType();
+            auto name = symbol.getName();
+
+            if (type && name && type.get() == llvm::object::SymbolRef::ST_Function) {
+                //  Remove the global prefix added on some platforms (Mach-O)
+                auto symbol_name = name.get();
+                const auto prefix = clone->getDataLayout().getGlobalPrefix();
+                if (prefix != '\0' && symbol_name.startswith(llvm::StringRef{&prefix, 1u}))
+                    symbol_name = symbol_name.drop_front();
+                code_sizes[symbol_name.str()] = symbol_size.second;
+            }
+            else {
+                if (!type)
+                    llvm::consumeError(type.takeError());
+                if (!name)
+                    llvm::consumeError(name.takeError());
+            }
+        }
+
+        return code_sizes;
+    }
+
+    std::vector<function_statistics> compute_module_statistics(const llvm::Module& module)
+    {
+        std::vector<function_statistics> statistics{};
+        std::unordered_map<std::string, std::size_t> code_sizes{};
+
+        try {
+            code_sizes = compute_code_sizes(module);
+        }
+        catch (const std::exception& e) {
+            LOG_WARNING("[module statistics] Native code sizes are not available: %s\n", e.what());
+        }
+
+        for (const auto& function : module) {
+            if (function.isDeclaration())
+                continue;
+
+            function_statistics stats{function.getName().str()};
+
+            for (const auto& instruction : llvm::instructions(function)) {
+                if (!llvm::isa<llvm::DbgInfoIntrinsic>(instruction))
+                    stats.instruction_count++;
+            }
+
+            auto it = code_sizes.find(stats.name);
+            if (it != code_sizes.end())
+                stats.code_bytes = it->second;
+
+            statistics.emplace_back(std::move(stats));
+        }
+
+        return statistics;
+    }
+
+}
@@ -0,0 +1,29 @@
+#ifndef GAMMOU_MODULE_STATISTICS_H_
+#define GAMMOU_MODULE_STATISTICS_H_
+
+#include <string>
+#include <vector>
+#include <llvm/IR/Module.h>
+
+namespace Gammou {
+
+    /**
+     * \brief Static code generation statistics of a function
+     */
+    struct function_statistics
+    {
+        std::string name{};
+        std::size_t instruction_count{0u};  //<< Number of IR instructions
+        std::size_t code_bytes{0u};         //<< Native code size when compiled alone for the host
+    };
+
+    /**
+     * \brief Compute the statistics of every function defined in a module
+     * \param module the module to be analyzed. It is cloned before native code generation
+     * \note Native code sizes are left to zero if the host target can not be used
+     */
+    std::vector<function_statistics> compute_module_statistics(const llvm::Module& module);
+
+}
+
+#endif /* GAMMOU_MODULE_STATISTICS_H_ */
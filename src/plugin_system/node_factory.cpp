@@ -0,0 +1,80 @@
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Linker/Linker.h>
+
+#include "node_factory.h"
+
+namespace Gammou {
+
+    /**
+     *  Plugin implementation
+     */
+    node_factory::plugin::plugin(plugin_id id, const std::string& name, const std::string& category)
+    : _id{id}, _name{name}, _category{category}
+    {
+    }
+
+    const std::vector<function_statistics>& node_factory::plugin::statistics()
+    {
+        static const std::vector<function_statistics> no_statistics{};
+        return no_statistics;
+    }
+
+    const node_cost& node_factory::plugin::cost()
+    {
+        // Nodes without IR are builtin nodes : a few instructions without state
+        static const node_cost builtin_node_cost{1., 0u};
+        return builtin_node_cost;
+    }
+
+    const std::optional<std::vector<unsigned int>>& node_factory::plugin::silence_inputs()
+    {
+        static const std::optional<std::vector<unsigned int>> no_silence_inputs{};
+        return no_silence_inputs;
+    }
+
+    /*
+     *  Factory Implementation
+     */
+    node_factory::node_factory(llvm::LLVMContext& llvm_context)
+    :   _llvm_context{llvm_context}
+    {
+        _module = std::make_unique<llvm::Module>("FACTORY", _llvm_context);
+    }
+
+    void node_factory::register_plugin(std::unique_ptr<plugin>&& plugin)
+    {
+        auto plugin_module = plugin->module();
+        auto id = plugin->id();
+
+        if (plugin_module)
+            add_library_module(std::move(plugin_module));
+
+        _plugins.emplace(id, std::move(plugin));
+    }
+
+    void node_factory::add_library_module(std::unique_ptr<llvm::Module>&& m)
+    {
+        llvm::Linker::linkModules(*_module, std::move(m));
+    }
+
+    std::unique_ptr<llvm::Module> node_factory::module()
+    {
+        return llvm::CloneModule(*_module);
+    }
+
+    node_factory::plugin *node_factory::get_plugin(plugin_id id) const noexcept
+    {
+        auto it = _plugins.find(id);
+        return it != _plugins.end() ? it->second.get() : nullptr;
+    }
+
+    node_factory::plugin& node_factory::get_plugin(const nlohmann::json& state) const
+    {
+        const auto uid = state.at("plugin-uid").get<plugin_id>();
+        auto *plugin = get_plugin(uid);
+        if (plugin == nullptr)
+            throw std::runtime_error("node_factory::get_plugin unkown id");
+        return *plugin;
+    }
+
+}
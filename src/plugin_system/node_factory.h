@@ -0,0 +1,127 @@
+#ifndef GAMMOU_NODE_FACTORY_H_
+#define GAMMOU_NODE_FACTORY_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include <DSPJIT/compile_node_class.h>
+
+#include "cost_model.h"
+#include "module_statistics.h"
+
+namespace Gammou {
+
+    class headless_patch;
+
+    /**
+     * \class node_factory
+     * \brief Gui free counterpart of node_widget_factory : create the dsp nodes of a patch
+     *  without their widgets, \see headless_patch.
+     *  Plugins are identified by the same ids in both factories, so that a patch saved from the gui can be loaded.
+     */
+    class node_factory {
+    public:
+        using plugin_id = uint64_t;
+
+        /**
+         * \class plugin
+         * \brief A plugin is a factory which can deserialize nodes
+         */
+        class plugin {
+        public:
+            plugin(plugin_id id, const std::string& name, const std::string& category);
+            virtual ~plugin() noexcept = default;
+
+            /**
+             * \param patch the patch which will own the node and the resources it needs
+             * \param internal_state from which the node will be deserialized, null if the node has no state
+             * \return a new node built with given state
+             */
+            virtual std::unique_ptr<DSPJIT::compile_node_class> create_node(
+                headless_patch& patch,
+                const nlohmann::json& internal_state) =0;
+
+            /**
+             * \brief Return a module containing all the dependendies needed
+             *      to compile the nodes created by the plugin
+             */
+            virtual std::unique_ptr<llvm::Module> module() { return nullptr; }
+
+            /**
+             * \see node_widget_factory::plugin::statistics
+             */
+            virtual const std::vector<function_statistics>& statistics();
+
+            /**
+             * \see node_widget_factory::plugin::cost
+             */
+            virtual const node_cost& cost();
+
+            /**
+             * \see node_widget_factory::plugin::silence_inputs
+             */
+            virtual const std::optional<std::vector<unsigned int>>& silence_inputs();
+
+            const auto id() const noexcept { return _id; }
+            const auto& name() const noexcept { return _name; }
+            const auto& category() const noexcept { return _category; }
+        private:
+            const plugin_id _id;
+            const std::string _name;
+            const std::string _category;
+        };
+
+        /**
+         * \brief Build an empty node factory
+         */
+        node_factory(llvm::LLVMContext&);
+
+        /**
+         * \brief Register a plugin into the factory.
+         * \param plugin the new plugin to be registered
+         */
+        void register_plugin(std::unique_ptr<plugin>&& plugin);
+
+        /**
+         * \brief Add a plugin dependency module into the factory
+         * \param m the module to be added
+         */
+        void add_library_module(std::unique_ptr<llvm::Module>&& m);
+
+        /**
+         * \return a module where all registred plugins dependencies are linked
+         */
+        std::unique_ptr<llvm::Module> module();
+
+        /**
+         * \brief Return the plugin identified by the plugin id, null if there is no such plugin
+         */
+        plugin *get_plugin(plugin_id id) const noexcept;
+
+        /**
+         * \brief Return the plugin used to create a serialized node
+         * \param state a serialized plugin node, as written by plugin_node_widget::serialize
+         * \throw std::runtime_error if the plugin is unknown
+         */
+        plugin& get_plugin(const nlohmann::json& state) const;
+
+        auto begin() const noexcept { return _plugins.begin(); }
+        auto end() const noexcept { return _plugins.end(); }
+
+        /**
+         * \brief Return a reference to the underlying LLVM context
+         */
+        auto& get_llvm_context() noexcept { return _llvm_context; }
+    private:
+        llvm::LLVMContext& _llvm_context;
+        std::unordered_map<plugin_id, std::unique_ptr<plugin>> _plugins{};
+        std::unique_ptr<llvm::Module> _module{};
+    };
+
+}
+
+#endif /* GAMMOU_NODE_FACTORY_H_ */
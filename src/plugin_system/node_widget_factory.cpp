@@ -23,6 +23,25 @@ namespace Gammou {
         return create_node(dir);
     }
 
+    const std::vector<function_statistics>& node_widget_factory::plugin::statistics()
+    {
+        static const std::vector<function_statistics> no_statistics{};
+        return no_statistics;
+    }
+
+    const node_cost& node_widget_factory::plugin::cost()
+    {
+        // Nodes without IR are builtin nodes : a few instructions without state
+        static const node_cost builtin_node_cost{1., 0u};
+        return builtin_node_cost;
+    }
+
+    const std::optional<std::vector<unsigned int>>& node_widget_factory::plugin::silence_inputs()
+    {
+        static const std::optional<std::vector<unsigned int>> no_silence_inputs{};
+        return no_silence_inputs;
+    }
+
 
     /*
      *  Factory Implementation
@@ -49,6 +68,12 @@ namespace Gammou {
         llvm::Linker::linkModules(*_module, std::move(m));
     }
 
+    node_widget_factory::plugin *node_widget_factory::get_plugin(plugin_id id) const noexcept
+    {
+        auto it = _plugins.find(id);
+        return it != _plugins.end() ? it->second.get() : nullptr;
+    }
+
     std::unique_ptr<plugin_node_widget> node_widget_factory::create_node(plugin_id id, abstract_configuration_directory& parent_config)
     {
         if (id == no_id) {
@@ -4,10 +4,13 @@
 #include <cstdint>
 #include <unordered_map>
 #include <functional>
+#include <optional>
 #include <nlohmann/json.hpp>
 
 #include "gui/circuit_editor.h"
 #include "configuration/abstract_configuration_directory.h"
+#include "cost_model.h"
+#include "module_statistics.h"
 
 namespace Gammou {
 
@@ -50,6 +53,27 @@ namespace Gammou {
              */
             virtual std::unique_ptr<llvm::Module> module() { return nullptr; }
 
+            /**
+             * \brief Return the code generation statistics of the functions
+             *      used to compile the nodes created by the plugin, if any
+             */
+            virtual const std::vector<function_statistics>& statistics();
+
+            /**
+             * \brief Return the estimated cost of a node created by the plugin
+             */
+            virtual const node_cost& cost();
+
+            /**
+             * \brief Return the inputs which, while silent (exact zeros), keep the outputs of the nodes
+             *      created by the plugin silent once they decayed. Used to skip the silent parts of a circuit.
+             * \note Only the master circuit branches run by the master worker threads are skipped :
+             *      nothing is skipped in the polyphonic circuit, nor in the master circuit when it is
+             *      processed as a whole (no workers, or not enough branches or cycles to be split)
+             * \return std::nullopt if the outputs can not be assumed to be silent
+             */
+            virtual const std::optional<std::vector<unsigned int>>& silence_inputs();
+
             const auto id() const noexcept { return _id; }
             const auto& name() const noexcept { return _name; }
             const auto& category() const noexcept { return _category; }
@@ -99,6 +123,11 @@ namespace Gammou {
             const nlohmann::json& state,
             abstract_configuration_directory& parent_config);
 
+        /**
+         * \brief Return the plugin identified by the plugin id, null if there is no such plugin
+         */
+        plugin *get_plugin(plugin_id id) const noexcept;
+
         /**
          * \brief Begin const iterator to the register plugins
          */
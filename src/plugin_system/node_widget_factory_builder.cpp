@@ -0,0 +1,42 @@
+
+#include <DSPJIT/log.h>
+
+#include "external_plugin.h"
+#include "node_widget_factory_builder.h"
+
+namespace Gammou {
+
+    node_widget_factory_builder::node_widget_factory_builder(llvm::LLVMContext& llvm_context)
+    :   _loader{llvm_context}
+    {
+    }
+
+    node_widget_factory_builder& node_widget_factory_builder::load_package(const std::filesystem::path& package_root_dir_path)
+    {
+        _loader.load_package(package_root_dir_path);
+        return *this;
+    }
+
+    node_widget_factory_builder& node_widget_factory_builder::load_packages(const std::filesystem::path& packages_dir_path)
+    {
+        _loader.load_packages(packages_dir_path);
+        return *this;
+    }
+
+    std::unique_ptr<node_widget_factory> node_widget_factory_builder::build()
+    {
+        auto factory = std::make_unique<node_widget_factory>(_loader.get_llvm_context());
+
+        for (auto& pair : _loader.release_packages()) {
+            auto& package = pair.second;
+            //  Add the gui on top of the loaded plugins
+            for (auto&& plugin : package.loaded_plugins)
+                factory->register_plugin(std::make_unique<external_plugin>(std::move(plugin)));
+            if (package.lib_module)
+                factory->add_library_module(std::move(package.lib_module));
+        }
+
+        LOG_DEBUG("[package loader] Packages where loaded.\n");
+        return factory;
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef GAMMOU_NODE_WIDGET_FACTORY_BUILDER_H_
+#define GAMMOU_NODE_WIDGET_FACTORY_BUILDER_H_
+
+#include "node_widget_factory.h"
+#include "package_loader.h"
+
+namespace Gammou
+{
+    /**
+     * \class node_widget_factory_builder
+     * \brief Build a node widget factory from the packages loaded by a package_loader
+     */
+    class node_widget_factory_builder
+    {
+    public:
+        node_widget_factory_builder(llvm::LLVMContext& llvm_context);
+
+        /**
+         *  \see package_loader::load_package
+         */
+        node_widget_factory_builder& load_package(const std::filesystem::path& package_root_dir_path);
+
+        /**
+         *  \see package_loader::load_packages
+         */
+        node_widget_factory_builder& load_packages(const std::filesystem::path& packages_dir_path);
+
+        /**
+         *  \brief build a factory with the loaded packages
+         *  \note Resolve packages dependency before building,
+         *  and remove packages with missing dependencies
+         */
+        std::unique_ptr<node_widget_factory> build();
+
+    private:
+        package_loader _loader;
+    };
+}
+
+#endif
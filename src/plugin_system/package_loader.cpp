@@ -1,5 +1,6 @@
 
 #include <fstream>
+#include <utility>
 #include <nlohmann/json.hpp>
 #include <llvm/IRReader/IRReader.h>
 #include <llvm/Support/SourceMgr.h>
@@ -8,7 +9,6 @@
 #include <DSPJIT/log.h>
 
 #include "package_loader.h"
-#include "external_plugin.h"
 #include "utils/serialization_helpers.h"
 
 namespace Gammou {
@@ -17,12 +17,12 @@ namespace Gammou {
     struct package_descriptor {
         std::string package_name{};
         package_uid uid;
-        std::vector<external_plugin::descriptor> plugins{};
+        std::vector<external_node_plugin::descriptor> plugins{};
         std::vector<std::filesystem::path> common_libs{};
-        std::vector<node_widget_factory_builder::dependency> dependencies{};
+        std::vector<package_loader::dependency> dependencies{};
     };
 
-    NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(node_widget_factory_builder::dependency, uid, name)
+    NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(package_loader::dependency, uid, name)
 
     void from_json(const nlohmann::json& j, package_descriptor& desc)
     {
@@ -33,19 +33,19 @@ namespace Gammou {
         optional_field_get_to(j, "package-dependencies", desc.dependencies);
     }
 
-    node_widget_factory_builder::node_widget_factory_builder(llvm::LLVMContext& llvm_context)
+    package_loader::package_loader(llvm::LLVMContext& llvm_context)
     :   _llvm_context{llvm_context}
     {
     }
 
-    node_widget_factory_builder& node_widget_factory_builder::add_package(package&& package)
+    package_loader& package_loader::add_package(package&& package)
     {
         const auto uid = package.uid;
         _packages.emplace(uid, std::move(package));
         return *this;
     }
 
-    node_widget_factory_builder& node_widget_factory_builder::load_package(const std::filesystem::path& package_root_dir_path)
+    package_loader& package_loader::load_package(const std::filesystem::path& package_root_dir_path)
     {
         try
         {
@@ -60,7 +60,7 @@ namespace Gammou {
         }
     }
 
-    node_widget_factory_builder& node_widget_factory_builder::load_packages(const std::filesystem::path& packages_dir_path)
+    package_loader& package_loader::load_packages(const std::filesystem::path& packages_dir_path)
     {
         LOG_INFO("[package loader] Scanning package directory '%s'\n", packages_dir_path.generic_string().c_str());
 
@@ -80,13 +80,17 @@ namespace Gammou {
         return *this;
     }
 
-    std::unique_ptr<node_widget_factory> node_widget_factory_builder::build()
+    std::map<package_uid, package_loader::package> package_loader::release_packages()
     {
-        auto factory = std::make_unique<node_widget_factory>(_llvm_context);
-
         _resolve_dependencies();
+        return std::exchange(_packages, {});
+    }
+
+    std::unique_ptr<node_factory> package_loader::build()
+    {
+        auto factory = std::make_unique<node_factory>(_llvm_context);
 
-        for (auto& pair : _packages) {
+        for (auto& pair : release_packages()) {
             auto& package = pair.second;
             for (auto&& plugin : package.loaded_plugins)
                 factory->register_plugin(std::move(plugin));
@@ -98,7 +102,7 @@ namespace Gammou {
         return factory;
     }
 
-    void node_widget_factory_builder::_resolve_dependencies()
+    void package_loader::_resolve_dependencies()
     {
         bool all_dependencies_satisfied = true;
 
@@ -136,7 +140,7 @@ namespace Gammou {
         } while (!all_dependencies_satisfied);
     }
 
-    node_widget_factory_builder::package node_widget_factory_builder::_load_package(const std::filesystem::path& package_root_dir_path)
+    package_loader::package package_loader::_load_package(const std::filesystem::path& package_root_dir_path)
     {
         using namespace std::filesystem;
         LOG_DEBUG("[package loader] Scanning package '%s'\n", package_root_dir_path.generic_string().c_str());
@@ -182,7 +186,7 @@ namespace Gammou {
 
             try {
                 pack.loaded_plugins.emplace_back(
-                    external_plugin::from_desc(
+                    external_node_plugin::from_desc(
                         node_class_desc, _llvm_context));
             }
             catch (const std::exception& e)
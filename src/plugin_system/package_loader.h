@@ -4,13 +4,18 @@
 #include <filesystem>
 #include <map>
 
-#include "node_widget_factory.h"
+#include "external_node_plugin.h"
+#include "node_factory.h"
 
 namespace Gammou
 {
     using package_uid = uint64_t;
 
-    class node_widget_factory_builder
+    /**
+     * \class package_loader
+     * \brief Load the plugin packages, without gui. \see node_widget_factory_builder for the gui factory
+     */
+    class package_loader
     {
     public:
         struct dependency
@@ -24,36 +29,42 @@ namespace Gammou
             package_uid uid;
             std::string name;
             std::vector<dependency> dependencies{};
-            std::vector<std::unique_ptr<node_widget_factory::plugin>> loaded_plugins{};
+            std::vector<std::unique_ptr<external_node_plugin>> loaded_plugins{};
             std::unique_ptr<llvm::Module> lib_module{};
         };
 
-        node_widget_factory_builder(llvm::LLVMContext& llvm_context);
+        package_loader(llvm::LLVMContext& llvm_context);
 
         /**
-         *  \brief Add a package in the factory
+         *  \brief Add a package in the loader
          */
-        node_widget_factory_builder& add_package(package&& package);
+        package_loader& add_package(package&& package);
 
         /**
          *  \brief Load a package
          *  \param package_root_dir_path the root directory of the package (this directory must contain a content.json file)
          *  \details a package is a directory containing a file content.json
          */
-        node_widget_factory_builder& load_package(const std::filesystem::path& package_root_dir_path);
+        package_loader& load_package(const std::filesystem::path& package_root_dir_path);
 
         /**
          *  \brief Load all package located in a given directory (without recursing in subdir)
          *  \param packages_dir_path the directory in which packages will be looked for
          */
-        node_widget_factory_builder& load_packages(const std::filesystem::path& packages_dir_path);
+        package_loader& load_packages(const std::filesystem::path& packages_dir_path);
 
         /**
-         *  \brief build a factory with the loaded packages
-         *  \note Resolve packages dependency before building,
-         *  and remove packages with missing dependencies
+         *  \brief Resolve packages dependency and remove packages with missing dependencies,
+         *  then hand over the loaded packages
          */
-        std::unique_ptr<node_widget_factory> build();
+        std::map<package_uid, package> release_packages();
+
+        /**
+         *  \brief build a gui free factory with the loaded packages
+         */
+        std::unique_ptr<node_factory> build();
+
+        auto& get_llvm_context() noexcept { return _llvm_context; }
 
     private:
 
@@ -65,4 +76,4 @@ namespace Gammou
     };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,64 @@
+#ifndef GAMMOU_PATCH_FORMAT_H_
+#define GAMMOU_PATCH_FORMAT_H_
+
+#include <nlohmann/json.hpp>
+
+#include "synthesizer/synthesizer.h"
+
+namespace Gammou {
+
+    NLOHMANN_JSON_SERIALIZE_ENUM(synthesizer::voice_mode, {
+        {synthesizer::voice_mode::POLYPHONIC, "polyphonic"},
+        {synthesizer::voice_mode::LEGATO, "legato"}
+    })
+
+    /**
+     *  The patch json format, shared by the gui editors and the headless_patch.
+     *
+     *  A circuit is serialized as
+     *      {"nodes" : [{"x" : .., "y" : .., "node" : ..}, ...], "links" : [{"from" : {"node" : .., "out" : ..}, "to" : {"node" : .., "in" : ..}}, ...]}
+     *  where a node is either the identifier of an internal node, or a plugin node {"plugin-uid" : .., ["state" : ..]}
+     */
+    namespace patch_format {
+
+        //  Master circuit internal nodes
+        constexpr auto master_from_polyphonic_node_id = "from-polyphonic";
+        constexpr auto master_output_node_id = "output";
+
+        //  Polyphonic circuit internal nodes
+        constexpr auto polyphonic_midi_input_node_id = "midi-input";
+        constexpr auto polyphonic_to_master_node_id = "to-master";
+
+        //  Composite node circuit internal nodes
+        constexpr auto composite_input_node_id = "composite_input";
+        constexpr auto composite_output_node_id = "composite_output";
+
+        /**
+         *  Composite node internal state
+         */
+        struct composite_node_state
+        {
+            std::string name;
+            std::vector<std::string> input_names;
+            std::vector<std::string> output_names;
+            nlohmann::json internal_circuit_state;
+        };
+
+        NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(composite_node_state, name, input_names, output_names, internal_circuit_state)
+
+        /**
+         *  Synthesizer state serialization/deserialization
+         */
+        struct synthesizer_state
+        {
+            nlohmann::json master_circuit{};
+            nlohmann::json polyphonic_circuit{};
+            synthesizer::voice_mode voicing_mode{synthesizer::voice_mode::POLYPHONIC};
+        };
+
+        NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(synthesizer_state, master_circuit, polyphonic_circuit, voicing_mode)
+    }
+
+}
+
+#endif /* GAMMOU_PATCH_FORMAT_H_ */
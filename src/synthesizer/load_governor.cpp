@@ -0,0 +1,131 @@
+
+#include <algorithm>
+
+#include "load_governor.h"
+
+namespace Gammou
+{
+    //  Smoothing factor of the load measure
+    static constexpr auto load_smoothing = 0.1f;
+
+    load_governor::load_governor(const configuration& config, std::size_t max_voice_budget)
+    :   _config{config},
+        _max_voice_budget{max_voice_budget},
+        _last_max_voice_budget{max_voice_budget},
+        _voice_budget{max_voice_budget}
+    {
+    }
+
+    void load_governor::set_sample_rate(float sample_rate) noexcept
+    {
+        _sample_period_ns = 1e9f / sample_rate;
+    }
+
+    void load_governor::set_enabled(bool enabled) noexcept
+    {
+        _enabled = enabled;
+    }
+
+    void load_governor::set_max_voice_budget(std::size_t budget) noexcept
+    {
+        _max_voice_budget = budget;
+    }
+
+    bool load_governor::end_block(
+        std::chrono::nanoseconds duration,
+        std::size_t sample_count,
+        std::size_t active_voice_count) noexcept
+    {
+        if (sample_count == 0u)
+            return false;
+
+        const auto block_load =
+            static_cast<float>(duration.count()) / (_sample_period_ns * static_cast<float>(sample_count));
+
+        _load += load_smoothing * (block_load - _load);
+        _peak_load = std::max(_peak_load, block_load);
+        if (block_load > 1.f)
+            _overrun_count++;
+
+        //  The budget follows the maximum when it was not reduced
+        const auto max_budget = _max_voice_budget.load();
+        const auto enabled = _enabled.load();
+        const auto follow_max_budget =
+            !enabled || _voice_budget == _last_max_voice_budget || _voice_budget > max_budget;
+        _last_max_voice_budget = max_budget;
+
+        if (follow_max_budget && _voice_budget != max_budget) {
+            _set_voice_budget(
+                _voice_budget < max_budget ? action_kind::RESTORE_VOICE_BUDGET : action_kind::REDUCE_VOICE_BUDGET,
+                max_budget);
+            return true;
+        }
+        else if (!enabled) {
+            return false;
+        }
+
+        //  Overload is detected on the raw block load, so that the effect of a reduction is seen on the next block
+        if (block_load > _config.overload_threshold) {
+            _headroom_block_count = 0u;
+
+            if (++_overloaded_block_count >= _config.overload_block_count) {
+                //  Reduce from the actual polyphony so that the reduction is immediately effective
+                const auto reduced_budget =
+                    std::max<std::size_t>(
+                        1u,
+                        static_cast<std::size_t>(
+                            static_cast<float>(std::min(_voice_budget, active_voice_count)) * _config.reduction_factor));
+
+                _overloaded_block_count = 0u;
+
+                //  When no voice would be released, the overload comes from the master circuit : the budget is
+                //  left as it is, as it would not be restored while the master circuit stays heavy
+                if (reduced_budget < active_voice_count && reduced_budget < _voice_budget) {
+                    _set_voice_budget(action_kind::REDUCE_VOICE_BUDGET, reduced_budget);
+                    return true;
+                }
+            }
+        }
+        else if (_load < _config.headroom_threshold && _voice_budget < max_budget) {
+            _overloaded_block_count = 0u;
+
+            if (++_headroom_block_count >= _config.headroom_block_count) {
+                const auto step = std::max<std::size_t>(1u, max_budget / 16u);
+
+                _headroom_block_count = 0u;
+                _set_voice_budget(
+                    action_kind::RESTORE_VOICE_BUDGET,
+                    std::min(max_budget, _voice_budget + step));
+                return true;
+            }
+        }
+        else {
+            _overloaded_block_count = 0u;
+            _headroom_block_count = 0u;
+        }
+
+        return false;
+    }
+
+    load_governor::statistics load_governor::get_statistics() const noexcept
+    {
+        return {_load, _peak_load, _overrun_count, _voice_budget};
+    }
+
+    void load_governor::_set_voice_budget(action_kind kind, std::size_t budget) noexcept
+    {
+        _voice_budget = budget;
+        //  The action report is lost if nobody consume them
+        _actions.push(action{kind, budget, _load});
+    }
+
+    const char *load_governor_action_name(load_governor::action_kind kind) noexcept
+    {
+        switch (kind) {
+            case load_governor::action_kind::REDUCE_VOICE_BUDGET:   return "reduce voice budget";
+            case load_governor::action_kind::RESTORE_VOICE_BUDGET:  return "restore voice budget";
+            default:                                                return "unknown";
+        }
+    }
+
+}
@@ -0,0 +1,116 @@
+#ifndef GAMMOU_LOAD_GOVERNOR_H_
+#define GAMMOU_LOAD_GOVERNOR_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <utility>
+
+#include "utils/spsc_queue.h"
+
+namespace Gammou
+{
+    /**
+     * \class load_governor
+     * \brief Compare the time spent processing each block to the block duration and,
+     *  under sustained overload, lower the voice budget. The budget is restored step by step
+     *  when the headroom comes back. The budget is only lowered when it releases playing voices :
+     *  an overload caused by the master circuit alone is not handled by the governor.
+     *  Every decision is reported through a queue which is drained out of the processing thread.
+     */
+    class load_governor
+    {
+    public:
+        struct configuration
+        {
+            float overload_threshold{0.85f};        //<< Block load above which a block is considered overloaded
+            float headroom_threshold{0.5f};         //<< Smoothed load under which the budget can be restored
+            unsigned int overload_block_count{8u};  //<< Consecutive overloaded blocks before lowering the budget
+            unsigned int headroom_block_count{256u};//<< Consecutive blocks with headroom before raising the budget
+            float reduction_factor{0.75f};          //<< Budget reduction applied to the active voice count
+        };
+
+        enum class action_kind
+        {
+            REDUCE_VOICE_BUDGET,
+            RESTORE_VOICE_BUDGET
+        };
+
+        struct action
+        {
+            action_kind kind;
+            std::size_t voice_budget;   //<< The new voice budget
+            float load;                 //<< The smoothed load which triggered the action
+        };
+
+        struct statistics
+        {
+            float load{0.f};                //<< Smoothed processing time / block duration
+            float peak_load{0.f};
+            std::size_t overrun_count{0u};  //<< Number of blocks which took longer than their duration
+            std::size_t voice_budget{0u};
+        };
+
+        explicit load_governor(const configuration& config, std::size_t max_voice_budget);
+
+        void set_sample_rate(float sample_rate) noexcept;
+
+        /**
+         *  \brief Enable or disable the budget adjustments. The load is measured anyway.
+         *  When disabled, the budget goes back to its maximum.
+         */
+        void set_enabled(bool enabled) noexcept;
+
+        /**
+         *  \brief Set the voice budget used when there is enough headroom
+         */
+        void set_max_voice_budget(std::size_t budget) noexcept;
+
+        /**
+         *  \brief Account a processed block, called on the processing thread
+         *  \param duration time spent processing the block
+         *  \param sample_count number of samples in the block
+         *  \param active_voice_count number of voices processed during the block
+         *  \return true if the voice budget was changed, \see voice_budget()
+         */
+        bool end_block(
+            std::chrono::nanoseconds duration,
+            std::size_t sample_count,
+            std::size_t active_voice_count) noexcept;
+
+        std::size_t voice_budget() const noexcept { return _voice_budget; }
+        statistics get_statistics() const noexcept;
+
+        /**
+         *  \brief Pass the actions taken since the last call to func, out of the processing thread
+         */
+        template <typename Func>
+        void consume_actions(Func&& func)
+        {
+            _actions.consume_all(std::forward<Func>(func));
+        }
+
+    private:
+        void _set_voice_budget(action_kind kind, std::size_t budget) noexcept;
+
+        const configuration _config;
+        float _sample_period_ns{1e9f / 44100.f};
+        std::atomic<bool> _enabled{true};
+        std::atomic<std::size_t> _max_voice_budget;
+        std::size_t _last_max_voice_budget;
+        std::size_t _voice_budget;
+
+        float _load{0.f};
+        float _peak_load{0.f};
+        std::size_t _overrun_count{0u};
+        unsigned int _overloaded_block_count{0u};
+        unsigned int _headroom_block_count{0u};
+
+        spsc_queue<action, 64u> _actions{};
+    };
+
+    const char *load_governor_action_name(load_governor::action_kind kind) noexcept;
+
+}
+
+#endif
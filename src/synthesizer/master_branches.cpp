@@ -0,0 +1,532 @@
+
+#include <algorithm>
+#include <numeric>
+
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <DSPJIT/common_nodes.h>
+#include <DSPJIT/log.h>
+
+#include "master_branches.h"
+#include "utils/denormals.h"
+#include "utils/rt_check.h"
+
+namespace Gammou {
+
+    /**
+     *  \brief Connect the terms of a branch to its proxy output node while the branch is compiled.
+     *  The proxy is not needed by the compiled program : it is disconnected at destruction,
+     *  so that the circuit is left as it was, even if the compilation throws.
+     */
+    class proxy_connections {
+    public:
+        explicit proxy_connections(DSPJIT::compile_node_class& proxy) noexcept
+        :   _proxy{proxy}
+        {
+        }
+
+        ~proxy_connections()
+        {
+            const auto input_count = _proxy.get_input_count();
+            for (auto i = 0u; i < input_count; ++i)
+                _proxy.disconnect(i);
+        }
+
+        proxy_connections(const proxy_connections&) = delete;
+        proxy_connections& operator=(const proxy_connections&) = delete;
+
+        void connect(const DSPJIT::compile_node_class& node, unsigned int output, unsigned int proxy_input)
+        {
+            //  Only the outputs list of the term node is modified, until destruction
+            const_cast<DSPJIT::compile_node_class&>(node).connect(output, _proxy, proxy_input);
+        }
+
+    private:
+        DSPJIT::compile_node_class& _proxy;
+    };
+
+    master_branches::master_branches(
+        llvm::LLVMContext& llvm_context,
+        opt_level level,
+        const llvm::TargetOptions& target_options,
+        std::size_t input_count,
+        std::size_t output_count,
+        const configuration& config)
+    :   _llvm_context{llvm_context},
+        _opt_level{level},
+        _target_options{target_options},
+        _input_count{input_count},
+        _output_count{output_count},
+        _config{config}
+    {
+        if (config.worker_count != 0u)
+            _task_pool = std::make_unique<task_pool>(config.worker_count);
+    }
+
+    master_branches::~master_branches()
+    {
+        _collect_retired_layouts();
+        delete _pending_layout.load();
+        delete _current_layout;
+    }
+
+    void master_branches::add_library_module(std::unique_ptr<llvm::Module>&& module)
+    {
+        for (auto& context : _contexts)
+            context->add_library_module(llvm::CloneModule(*module));
+        _library_modules.emplace_back(std::move(module));
+    }
+
+    void master_branches::set_global_constant(const std::string& symbol, float value)
+    {
+        for (auto& context : _contexts)
+            context->set_global_constant(symbol, value);
+        _global_constants[symbol] = value;
+    }
+
+    void master_branches::register_static_memory_chunk(const DSPJIT::compile_node_class& node, const std::vector<uint8_t>& data)
+    {
+        //  Without workers, the master circuit is always processed as a whole : no copy is needed
+        if (!_task_pool)
+            return;
+
+        _static_chunks[&node] = data;
+
+        //  Update the chunk in the contexts which already use it
+        for (auto& context : _contexts) {
+            if (_context_static_chunks[context.get()].count(&node) != 0u)
+                context->register_static_memory_chunk(node, std::vector<uint8_t>{data});
+        }
+    }
+
+    void master_branches::free_static_memory_chunk(const DSPJIT::compile_node_class& node)
+    {
+        _static_chunks.erase(&node);
+
+        for (auto& context : _contexts) {
+            if (_context_static_chunks[context.get()].erase(&node) != 0u)
+                context->free_static_memory_chunk(node);
+        }
+    }
+
+    void master_branches::enable_ir_dump(bool enable)
+    {
+        for (auto& context : _contexts)
+            context->enable_ir_dump(enable);
+        _ir_dump_enabled = enable;
+    }
+
+    void master_branches::initialize_states()
+    {
+        for (auto& context : _contexts)
+            context->initialize_state(0u);
+
+        if (_current_layout != nullptr) {
+            for (auto& b : _current_layout->branches)
+                b.silent_block_count = 0u;
+        }
+    }
+
+    void master_branches::set_node_info_provider(node_info_provider provider)
+    {
+        _node_info_provider = std::move(provider);
+    }
+
+    bool master_branches::compile(DSPJIT::compile_node_class& input, DSPJIT::compile_node_class& output)
+    {
+        _collect_retired_layouts();
+        _destroy_unused_contexts();
+
+        //  Find the terms summed by the mix bus into each output
+        std::vector<root> roots{};
+        std::vector<std::vector<std::size_t>> output_roots(_output_count);
+        std::vector<const DSPJIT::compile_node_class*> path{};
+
+        for (auto i = 0u; i < _output_count; ++i) {
+            unsigned int output_id;
+            if (const auto *node = output.get_input(i, output_id))
+                _collect_terms(node, output_id, roots, output_roots[i], path);
+        }
+
+        //  Walk the nodes each term depends on, and merge the terms sharing nodes
+        std::vector<std::size_t> parents(roots.size());
+        std::iota(parents.begin(), parents.end(), 0u);
+        const auto find =
+            [&parents](std::size_t index)
+            {
+                while (parents[index] != index)
+                    index = parents[index] = parents[parents[index]];
+                return index;
+            };
+
+        std::unordered_map<const DSPJIT::compile_node_class*, std::size_t> node_roots{};
+        std::vector<const DSPJIT::compile_node_class*> stack{};
+
+        for (auto i = 0u; i < roots.size(); ++i) {
+            if (roots[i].node == &input)
+                continue;
+
+            stack.push_back(roots[i].node);
+            while (!stack.empty()) {
+                const auto *node = stack.back();
+                stack.pop_back();
+
+                const auto it = node_roots.find(node);
+                if (it != node_roots.end()) {
+                    //  The node dependencies were already walked
+                    if (it->second != i)
+                        parents[find(it->second)] = find(i);
+                    continue;
+                }
+
+                node_roots.emplace(node, i);
+                const auto input_count = node->get_input_count();
+                for (auto j = 0u; j < input_count; ++j) {
+                    const auto *src = node->get_input(j);
+                    if (src != nullptr && src != &input)
+                        stack.push_back(src);
+                }
+            }
+        }
+
+        //  Build the branches
+        std::unordered_map<std::size_t, std::size_t> root_branches{};
+        std::vector<node_set> branch_nodes{};
+        std::vector<double> branch_cycles{};
+        node_infos infos{};
+
+        for (const auto& pair : node_roots) {
+            const auto group = find(pair.second);
+            auto it = root_branches.find(group);
+            if (it == root_branches.end()) {
+                it = root_branches.emplace(group, branch_nodes.size()).first;
+                branch_nodes.emplace_back();
+                branch_cycles.push_back(0.);
+            }
+
+            const auto& info = infos.emplace(pair.first, _node_info(*pair.first)).first->second;
+            branch_nodes[it->second].insert(pair.first);
+            branch_cycles[it->second] += info.cycles;
+        }
+
+        const auto total_cycles = std::accumulate(branch_cycles.begin(), branch_cycles.end(), 0.);
+        auto new_layout = std::make_unique<layout>();
+
+        if (!_task_pool || branch_nodes.size() < 2u || total_cycles < _config.min_parallel_cycles) {
+            LOG_INFO("[master branches] %zu branches, ~%.0f cycles/sample : process the master circuit as a whole\n",
+                branch_nodes.size(), total_cycles);
+            _compiled_branch_count = 0u;
+            _publish(std::move(new_layout));
+            return false;
+        }
+
+        //  Assign the terms to the branch outputs
+        std::vector<term> root_terms(roots.size());
+        std::vector<std::vector<std::size_t>> branch_roots(branch_nodes.size());
+
+        for (auto i = 0u; i < roots.size(); ++i) {
+            if (roots[i].node == &input) {
+                root_terms[i] = term{direct_input_term, roots[i].output};
+            }
+            else {
+                const auto branch_index = root_branches[find(i)];
+                auto& branch_root_list = branch_roots[branch_index];
+                root_terms[i] = term{branch_index, static_cast<unsigned int>(branch_root_list.size())};
+                branch_root_list.push_back(i);
+            }
+        }
+
+        new_layout->output_terms.resize(_output_count);
+        for (auto i = 0u; i < _output_count; ++i) {
+            for (auto root_index : output_roots[i])
+                new_layout->output_terms[i].push_back(root_terms[root_index]);
+        }
+
+        //  Compile each branch in its own context
+        std::vector<const DSPJIT::graph_execution_context*> used_contexts{};
+        std::size_t skippable_count = 0u;
+
+        for (auto i = 0u; i < branch_nodes.size(); ++i) {
+            auto& context = _select_context(branch_nodes[i], used_contexts);
+            used_contexts.push_back(&context);
+            _register_static_chunks(context, branch_nodes[i]);
+
+            const auto term_count = static_cast<unsigned int>(branch_roots[i].size());
+            auto proxy = std::make_unique<DSPJIT::compile_node_class>(term_count, 0u);
+            std::vector<const DSPJIT::compile_node_class*> term_nodes{};
+
+            {
+                proxy_connections connections{*proxy};
+
+                for (auto j = 0u; j < term_count; ++j) {
+                    const auto& term_root = roots[branch_roots[i][j]];
+                    connections.connect(*term_root.node, term_root.output, j);
+                    term_nodes.push_back(term_root.node);
+                }
+
+                context.compile({input}, {*proxy});
+            }
+
+            const auto skippable =
+                _config.skip_silent_branches && _is_skippable(branch_nodes[i], term_nodes, input, infos);
+            skippable_count += skippable ? 1u : 0u;
+
+            new_layout->branches.push_back(
+                branch{&context, std::move(proxy), std::vector<float>(max_block_size * term_count), term_count, skippable});
+        }
+
+        LOG_INFO("[master branches] Master circuit split in %zu branches (%zu skippable on silence), ~%.0f cycles/sample\n",
+            branch_nodes.size(), skippable_count, total_cycles);
+
+        _compiled_branch_count = branch_nodes.size();
+        _publish(std::move(new_layout));
+        return true;
+    }
+
+    bool master_branches::update_program() noexcept
+    {
+        auto *next_layout = _pending_layout.exchange(nullptr);
+        if (next_layout == nullptr)
+            return false;
+
+        for (auto& b : next_layout->branches)
+            b.context->update_program();
+
+        //  The retired layout is deleted by the compilation thread. If the queue is full, it is leaked
+        if (_current_layout != nullptr)
+            _retired_layouts.push(_current_layout);
+
+        _current_layout = next_layout;
+        return true;
+    }
+
+    bool master_branches::active() const noexcept
+    {
+        return _current_layout != nullptr && !_current_layout->branches.empty();
+    }
+
+    void master_branches::process(std::size_t sample_count, const float inputs[], float outputs[]) noexcept
+    {
+        auto& current = *_current_layout;
+        const auto is_silent = [](float x) { return x == 0.f; };
+        const auto input_silent = std::all_of(inputs, inputs + sample_count * _input_count, is_silent);
+        const auto hold_block_count = _config.silence_hold_block_count;
+
+        const auto must_skip =
+            [&](const branch& b)
+            {
+                return input_silent && b.skippable && b.silent_block_count >= hold_block_count;
+            };
+
+        //  Do not wake up the workers when every branch is skipped
+        if (std::all_of(current.branches.begin(), current.branches.end(), must_skip)) {
+            std::fill_n(outputs, sample_count * _output_count, 0.f);
+            return;
+        }
+
+        auto process_branch =
+            [&](std::size_t index)
+            {
+                scoped_denormals_flush flush{};
+                realtime_scope rt_scope{};
+
+                auto& b = current.branches[index];
+                const auto value_count = sample_count * b.output_count;
+
+                if (must_skip(b)) {
+                    std::fill_n(b.outputs.data(), value_count, 0.f);
+                    return;
+                }
+
+                for (auto i = 0u; i < sample_count; ++i)
+                    b.context->process(inputs + i * _input_count, b.outputs.data() + i * b.output_count);
+
+                if (b.skippable && input_silent && std::all_of(b.outputs.data(), b.outputs.data() + value_count, is_silent))
+                    b.silent_block_count = std::min(b.silent_block_count + 1u, hold_block_count);
+                else
+                    b.silent_block_count = 0u;
+            };
+
+        _task_pool->run(current.branches.size(), process_branch);
+
+        //  Mix bus
+        for (auto i = 0u; i < sample_count; ++i) {
+            for (auto j = 0u; j < _output_count; ++j) {
+                auto sum = 0.f;
+                for (const auto& t : current.output_terms[j]) {
+                    if (t.branch == direct_input_term) {
+                        sum += inputs[i * _input_count + t.output];
+                    }
+                    else {
+                        const auto& b = current.branches[t.branch];
+                        sum += b.outputs[i * b.output_count + t.output];
+                    }
+                }
+                outputs[i * _output_count + j] = sum;
+            }
+        }
+    }
+
+    void master_branches::_collect_terms(
+        const DSPJIT::compile_node_class *node, unsigned int output_id,
+        std::vector<root>& roots, std::vector<std::size_t>& output_roots,
+        std::vector<const DSPJIT::compile_node_class*>& path)
+    {
+        const auto is_add = dynamic_cast<const DSPJIT::add_node*>(node) != nullptr;
+
+        //  An add node in a feedback loop is kept in a branch
+        if (is_add && std::find(path.begin(), path.end(), node) == path.end()) {
+            path.push_back(node);
+            const auto input_count = node->get_input_count();
+            for (auto i = 0u; i < input_count; ++i) {
+                unsigned int src_output_id;
+                if (const auto *src = node->get_input(i, src_output_id))
+                    _collect_terms(src, src_output_id, roots, output_roots, path);
+            }
+            path.pop_back();
+        }
+        else {
+            const auto it = std::find_if(roots.begin(), roots.end(),
+                [&](const root& r) { return r.node == node && r.output == output_id; });
+
+            output_roots.push_back(static_cast<std::size_t>(it - roots.begin()));
+            if (it == roots.end())
+                roots.push_back(root{node, output_id});
+        }
+    }
+
+    master_branches::node_info master_branches::_node_info(const DSPJIT::compile_node_class& node) const
+    {
+        return _node_info_provider ? _node_info_provider(node) : node_info{};
+    }
+
+    bool master_branches::_is_skippable(
+        const node_set& nodes, const std::vector<const DSPJIT::compile_node_class*>& term_nodes,
+        const DSPJIT::compile_node_class& input, const node_infos& infos)
+    {
+        //  Every term must be silent while the circuit input is silent : walk the silence inputs
+        std::unordered_map<const DSPJIT::compile_node_class*, bool> silent_nodes{};
+        std::vector<const DSPJIT::compile_node_class*> stack{term_nodes};
+
+        while (!stack.empty()) {
+            const auto *node = stack.back();
+            stack.pop_back();
+
+            if (node == &input || !silent_nodes.emplace(node, true).second)
+                continue;
+
+            const auto& silence_inputs = infos.at(node).silence_inputs;
+            if (!silence_inputs.has_value())
+                return false;
+
+            for (auto input_id : silence_inputs.value()) {
+                //  An unconnected input is silent
+                if (const auto *src = node->get_input(input_id))
+                    stack.push_back(src);
+            }
+        }
+
+        //  The stateful nodes must also be silent, or they would miss their updates while skipped
+        return std::all_of(nodes.begin(), nodes.end(),
+            [&](const DSPJIT::compile_node_class *node)
+            {
+                return infos.at(node).stateless || silent_nodes.count(node) != 0u;
+            });
+    }
+
+    DSPJIT::graph_execution_context& master_branches::_create_context()
+    {
+        auto context = std::make_unique<DSPJIT::graph_execution_context>(
+            DSPJIT::graph_execution_context_factory::build(_llvm_context, _opt_level, _target_options));
+
+        for (const auto& module : _library_modules)
+            context->add_library_module(llvm::CloneModule(*module));
+        for (const auto& pair : _global_constants)
+            context->set_global_constant(pair.first, pair.second);
+        context->enable_ir_dump(_ir_dump_enabled);
+
+        return *_contexts.emplace_back(std::move(context));
+    }
+
+    DSPJIT::graph_execution_context& master_branches::_select_context(
+        const node_set& nodes, const std::vector<const DSPJIT::graph_execution_context*>& used_contexts)
+    {
+        //  Prefer the context which already ran most of these nodes, in order to keep their states
+        DSPJIT::graph_execution_context *best_context = nullptr;
+        std::size_t best_overlap = 0u;
+
+        for (auto& context : _contexts) {
+            if (std::find(used_contexts.begin(), used_contexts.end(), context.get()) != used_contexts.end())
+                continue;
+
+            const auto& context_nodes = _context_nodes[context.get()];
+            const auto overlap = static_cast<std::size_t>(
+                std::count_if(nodes.begin(), nodes.end(),
+                    [&](const DSPJIT::compile_node_class *node) { return context_nodes.count(node) != 0u; }));
+
+            if (best_context == nullptr || overlap > best_overlap) {
+                best_context = context.get();
+                best_overlap = overlap;
+            }
+        }
+
+        auto& context = (best_context != nullptr) ? *best_context : _create_context();
+        _context_nodes[&context] = nodes;
+        return context;
+    }
+
+    void master_branches::_register_static_chunks(DSPJIT::graph_execution_context& context, const node_set& nodes)
+    {
+        auto& registered_chunks = _context_static_chunks[&context];
+
+        for (const auto *node : nodes) {
+            const auto it = _static_chunks.find(node);
+            if (it != _static_chunks.end() && registered_chunks.insert(node).second)
+                context.register_static_memory_chunk(*node, std::vector<uint8_t>{it->second});
+        }
+    }
+
+    void master_branches::_publish(std::unique_ptr<layout>&& new_layout)
+    {
+        for (const auto& b : new_layout->branches)
+            _context_layout_count[b.context]++;
+
+        //  A layout still pending was never used by the processing thread
+        _release_layout(_pending_layout.exchange(new_layout.release()));
+    }
+
+    void master_branches::_collect_retired_layouts()
+    {
+        layout *retired_layout;
+        while (_retired_layouts.pop(retired_layout))
+            _release_layout(retired_layout);
+    }
+
+    void master_branches::_release_layout(layout *released_layout)
+    {
+        if (released_layout == nullptr)
+            return;
+
+        for (const auto& b : released_layout->branches)
+            _context_layout_count[b.context]--;
+        delete released_layout;
+    }
+
+    void master_branches::_destroy_unused_contexts()
+    {
+        //  The processing thread only uses the contexts of the pending and current layouts, which were not released
+        const auto unused =
+            [this](const std::unique_ptr<DSPJIT::graph_execution_context>& context)
+            {
+                if (_context_layout_count[context.get()] != 0u)
+                    return false;
+
+                _context_layout_count.erase(context.get());
+                _context_nodes.erase(context.get());
+                _context_static_chunks.erase(context.get());
+                return true;
+            };
+
+        _contexts.erase(std::remove_if(_contexts.begin(), _contexts.end(), unused), _contexts.end());
+    }
+
+}
@@ -0,0 +1,219 @@
+#ifndef GAMMOU_MASTER_BRANCHES_H_
+#define GAMMOU_MASTER_BRANCHES_H_
+
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <DSPJIT/compile_node_class.h>
+#include <DSPJIT/graph_execution_context_factory.h>
+
+#include "utils/spsc_queue.h"
+#include "utils/task_pool.h"
+
+namespace Gammou
+{
+    /**
+     * \class master_branches
+     * \brief Run the independent branches of the master circuit concurrently.
+     *
+     *  At compile time, the add nodes directly feeding the output node (the mix bus) are
+     *  walked to find the terms summed into each output. The nodes each term depends on form
+     *  a branch, and branches sharing nodes are merged. When there are at least two branches
+     *  and their estimated cost is high enough, each one is compiled in its own execution
+     *  context and run as a task on a task pool for each block, the mix bus being summed afterward.
+     *  Otherwise the master circuit is processed as a whole by the synthesizer.
+     *
+     *  Branch contexts are reused for the same nodes from one compilation to the next,
+     *  so that their states are kept while the circuit is edited. The contexts which are no longer
+     *  used by the processing thread are destroyed at the next compilation.
+     *
+     *  DSPJIT contexts own their static memory chunks : with workers, a chunk is copied in the branch
+     *  context which uses it, and kept in order to register it in the contexts created later.
+     *  Without workers the chunks are not copied.
+     *
+     *  A branch whose nodes are either stateless or declare silence inputs, and whose outputs only
+     *  depend on the circuit input through silence inputs, is skipped while the circuit input is
+     *  silent and its outputs have been silent for a while. As the branches are only compiled
+     *  separately with workers, nothing is skipped when the circuit is processed as a whole.
+     */
+    class master_branches
+    {
+    public:
+        static constexpr std::size_t max_block_size = 64u;
+        static constexpr double default_node_cycles = 100.;
+        using opt_level = DSPJIT::graph_execution_context::opt_level;
+
+        struct node_info
+        {
+            double cycles{default_node_cycles};  //<< Estimated cost, in cycles per sample
+            bool stateless{false};
+            std::optional<std::vector<unsigned int>> silence_inputs{};  //<< \see node_widget_factory::plugin::silence_inputs
+        };
+
+        /**
+         *  \brief Return the properties of a node of the circuit
+         */
+        using node_info_provider = std::function<node_info(const DSPJIT::compile_node_class&)>;
+
+        struct configuration
+        {
+            std::size_t worker_count{0u};       //<< Threads created by each synthesizer in addition to the processing thread, 0 to disable
+            double min_parallel_cycles{20000.}; //<< Estimated cycles per sample under which the circuit is processed as a whole
+            bool skip_silent_branches{true};   //<< Only effective when the circuit is split in branches
+            std::size_t silence_hold_block_count{64u};  //<< Silent blocks before a silent branch is skipped
+        };
+
+        master_branches(
+            llvm::LLVMContext& llvm_context,
+            opt_level level,
+            const llvm::TargetOptions& target_options,
+            std::size_t input_count,
+            std::size_t output_count,
+            const configuration& config);
+        ~master_branches();
+
+        /*
+         *  Forwarded to every branch execution context
+         */
+        void add_library_module(std::unique_ptr<llvm::Module>&& module);
+        void set_global_constant(const std::string& symbol, float value);
+        void register_static_memory_chunk(const DSPJIT::compile_node_class& node, const std::vector<uint8_t>& data);
+        void free_static_memory_chunk(const DSPJIT::compile_node_class& node);
+        void enable_ir_dump(bool enable);
+
+        /**
+         *  \brief Reset the node states of every branch
+         *  \note Must not be called while processing
+         */
+        void initialize_states();
+
+        /**
+         *  \brief Set the node info provider. Without provider, each node is assumed to be stateful
+         *  and to cost default_node_cycles
+         */
+        void set_node_info_provider(node_info_provider provider);
+
+        /**
+         *  \brief Partition the circuit between input and output, and compile its branches if
+         *  it is worth being processed in parallel.
+         *  \return false if the circuit must be processed as a whole from the next program update
+         */
+        bool compile(DSPJIT::compile_node_class& input, DSPJIT::compile_node_class& output);
+
+        /**
+         *  \brief Return the number of branches of the last successful compile, 0 if serial
+         */
+        std::size_t compiled_branch_count() const noexcept { return _compiled_branch_count; }
+
+        /**
+         **     Process thread part
+         **/
+
+        /**
+         *  \brief Switch to the last compiled branches, if any
+         *  \return true if the branches were changed
+         */
+        bool update_program() noexcept;
+
+        /**
+         *  \brief Return true if the circuit must be processed by process()
+         */
+        bool active() const noexcept;
+
+        /**
+         *  \brief Process a block
+         *  \param sample_count at most max_block_size
+         *  \param inputs interleaved input samples
+         *  \param outputs interleaved output samples
+         */
+        void process(std::size_t sample_count, const float inputs[], float outputs[]) noexcept;
+
+    private:
+        using node_set = std::unordered_set<const DSPJIT::compile_node_class*>;
+
+        static constexpr auto direct_input_term = std::numeric_limits<std::size_t>::max();
+
+        //  An output of the circuit is the sum of terms
+        struct term
+        {
+            std::size_t branch;     //<< Branch index, or direct_input_term
+            unsigned int output;    //<< Branch output or input channel
+        };
+
+        struct branch
+        {
+            DSPJIT::graph_execution_context *context;
+            std::unique_ptr<DSPJIT::compile_node_class> proxy_output;   //<< Collect the branch terms
+            std::vector<float> outputs;
+            std::size_t output_count;
+            bool skippable;                             //<< Can be skipped while the circuit input is silent
+            std::size_t silent_block_count{0u};         //<< Consecutive blocks with silent input and outputs
+        };
+
+        struct layout
+        {
+            std::vector<branch> branches{};
+            std::vector<std::vector<term>> output_terms{};   //<< Terms summed for each output
+        };
+
+        struct root
+        {
+            const DSPJIT::compile_node_class *node;
+            unsigned int output;
+        };
+
+        static void _collect_terms(
+            const DSPJIT::compile_node_class *node, unsigned int output_id,
+            std::vector<root>& roots, std::vector<std::size_t>& output_roots,
+            std::vector<const DSPJIT::compile_node_class*>& path);
+        using node_infos = std::unordered_map<const DSPJIT::compile_node_class*, node_info>;
+
+        node_info _node_info(const DSPJIT::compile_node_class& node) const;
+        static bool _is_skippable(
+            const node_set& nodes, const std::vector<const DSPJIT::compile_node_class*>& term_nodes,
+            const DSPJIT::compile_node_class& input, const node_infos& infos);
+        DSPJIT::graph_execution_context& _create_context();
+        DSPJIT::graph_execution_context& _select_context(const node_set& nodes, const std::vector<const DSPJIT::graph_execution_context*>& used_contexts);
+        void _register_static_chunks(DSPJIT::graph_execution_context& context, const node_set& nodes);
+        void _publish(std::unique_ptr<layout>&& new_layout);
+        void _collect_retired_layouts();
+        void _release_layout(layout *released_layout);
+        void _destroy_unused_contexts();
+
+        llvm::LLVMContext& _llvm_context;
+        const opt_level _opt_level;
+        const llvm::TargetOptions _target_options;
+        const std::size_t _input_count;
+        const std::size_t _output_count;
+        const configuration _config;
+
+        node_info_provider _node_info_provider{};
+        std::vector<std::unique_ptr<llvm::Module>> _library_modules{};
+        std::unordered_map<std::string, float> _global_constants{};
+        std::unordered_map<const DSPJIT::compile_node_class*, std::vector<uint8_t>> _static_chunks{};   //<< Registered in the new contexts
+        bool _ir_dump_enabled{false};
+
+        //  Branch contexts are destroyed once no layout which may be used by the processing thread refers to them
+        std::vector<std::unique_ptr<DSPJIT::graph_execution_context>> _contexts{};
+        std::unordered_map<const DSPJIT::graph_execution_context*, std::size_t> _context_layout_count{};  //<< Published and not released layouts
+        std::unordered_map<const DSPJIT::graph_execution_context*, node_set> _context_nodes{};
+        std::unordered_map<const DSPJIT::graph_execution_context*, node_set> _context_static_chunks{};   //<< Chunks registered in each context
+        std::size_t _compiled_branch_count{0u};
+
+        //  Layout hand over to the processing thread
+        std::atomic<layout*> _pending_layout{nullptr};
+        layout *_current_layout{nullptr};
+        spsc_queue<layout*, 16u> _retired_layouts{};
+
+        std::unique_ptr<task_pool> _task_pool{};
+    };
+}
+
+#endif
@@ -0,0 +1,94 @@
+#include <algorithm>
+
+#include <llvm/IR/DiagnosticInfo.h>
+#include <llvm/IR/Function.h>
+
+#include "optimization_remarks.h"
+
+namespace Gammou {
+
+    class optimization_remark_collector::handler : public llvm::DiagnosticHandler
+    {
+    public:
+        handler(std::unique_ptr<llvm::DiagnosticHandler>&& previous, std::vector<optimization_remark>& output)
+        :   _previous{std::move(previous)},
+            _output{output}
+        {
+        }
+
+        bool handleDiagnostics(const llvm::DiagnosticInfo& info) override
+        {
+            if (auto remark = llvm::dyn_cast<llvm::DiagnosticInfoOptimizationBase>(&info)) {
+                _collect(*remark);
+                return true;
+            }
+            else {
+                // Forward the other diagnostics (errors, warnings)
+                return _previous ? _previous->handleDiagnostics(info) : false;
+            }
+        }
+
+        bool isAnalysisRemarkEnabled(llvm::StringRef) const override { return true; }
+        bool isMissedOptRemarkEnabled(llvm::StringRef) const override { return true; }
+        bool isPassedOptRemarkEnabled(llvm::StringRef) const override { return true; }
+        bool isAnyRemarkEnabled() const override { return true; }
+
+        auto release_previous() noexcept { return std::move(_previous); }
+
+    private:
+        void _collect(const llvm::DiagnosticInfoOptimizationBase& remark)
+        {
+            optimization_remark result{};
+
+            if (remark.isPassed())
+                result.type = optimization_remark::kind::PASSED;
+            else if (remark.isMissed())
+                result.type = optimization_remark::kind::MISSED;
+            else
+                result.type = optimization_remark::kind::ANALYSIS;
+
+            result.pass = remark.getPassName().str();
+            result.name = remark.getRemarkName().str();
+            result.function = remark.getFunction().getName().str();
+            result.message = remark.getMsg();
+            result.symbols.push_back(result.function);
+
+            // Inlining remarks reference the involved functions in their arguments
+            for (const auto& arg : remark.getArgs()) {
+                if ((arg.Key == "Callee" || arg.Key == "Caller") &&
+                    std::find(result.symbols.begin(), result.symbols.end(), arg.Val) == result.symbols.end())
+                    result.symbols.push_back(arg.Val);
+            }
+
+            _output.emplace_back(std::move(result));
+        }
+
+        std::unique_ptr<llvm::DiagnosticHandler> _previous;
+        std::vector<optimization_remark>& _output;
+    };
+
+    optimization_remark_collector::optimization_remark_collector(
+        llvm::LLVMContext& context, std::vector<optimization_remark>& output)
+    :   _context{context}
+    {
+        _context.setDiagnosticHandler(
+            std::make_unique<handler>(_context.getDiagnosticHandler(), output));
+    }
+
+    optimization_remark_collector::~optimization_remark_collector() noexcept
+    {
+        auto current = _context.getDiagnosticHandler();
+        auto& collecting_handler = static_cast<handler&>(*current);
+        _context.setDiagnosticHandler(collecting_handler.release_previous());
+    }
+
+    const char *remark_kind_name(optimization_remark::kind type) noexcept
+    {
+        switch (type)
+        {
+            case optimization_remark::kind::PASSED:     return "passed";
+            case optimization_remark::kind::MISSED:     return "missed";
+            default:                                    return "analysis";
+        }
+    }
+}
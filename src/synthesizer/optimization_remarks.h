@@ -0,0 +1,55 @@
+#ifndef GAMMOU_OPTIMIZATION_REMARKS_H_
+#define GAMMOU_OPTIMIZATION_REMARKS_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <llvm/IR/DiagnosticHandler.h>
+#include <llvm/IR/LLVMContext.h>
+
+namespace Gammou {
+
+    /**
+     * \brief An optimization remark emitted by LLVM while compiling a circuit
+     */
+    struct optimization_remark
+    {
+        enum class kind
+        {
+            PASSED,     //<< An optimization was applied
+            MISSED,     //<< An optimization was attempted but failed (failed inlining, vectorization...)
+            ANALYSIS    //<< Additional information from an optimization pass
+        };
+
+        kind type{kind::ANALYSIS};
+        std::string pass{};
+        std::string name{};
+        std::string function{};
+        std::string message{};
+        std::vector<std::string> symbols{}; //<< Every function involved (function, callee, caller)
+    };
+
+    /**
+     * \brief Collect the optimization remarks emitted in an llvm context.
+     * The collecting diagnostic handler is installed for the collector lifetime,
+     * the previous handler is restored at destruction and still receive the other diagnostics.
+     */
+    class optimization_remark_collector
+    {
+    public:
+        optimization_remark_collector(llvm::LLVMContext& context, std::vector<optimization_remark>& output);
+        optimization_remark_collector(const optimization_remark_collector&) = delete;
+        optimization_remark_collector(optimization_remark_collector&&) = delete;
+        ~optimization_remark_collector() noexcept;
+
+    private:
+        class handler;
+
+        llvm::LLVMContext& _context;
+    };
+
+    const char *remark_kind_name(optimization_remark::kind type) noexcept;
+}
+
+#endif /* GAMMOU_OPTIMIZATION_REMARKS_H_ */
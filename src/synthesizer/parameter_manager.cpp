@@ -7,59 +7,133 @@
 namespace Gammou
 {
 
-    parameter_manager::parameter_manager(float sample_rate, float smooth_characteristic_time) noexcept
-        : _dt{1.f / sample_rate},
-          _smooth_characteristic_time{smooth_characteristic_time}
+    //  A parameter stops being processed when its value is this close to its setting (relative)
+    static constexpr auto convergence_threshold = 1e-5f;
+
+    parameter_manager::parameter_manager(
+        memory_arena& arena,
+        float sample_rate,
+        std::size_t capacity,
+        float smooth_characteristic_time)
+    :   _capacity{capacity},
+        _allocated{arena.allocate_array<std::atomic<bool>>(capacity)},
+        _parameter_normalized_settings{arena.allocate_array<std::atomic<float>>(capacity)},
+        _parameter_settings{arena.allocate_array<std::atomic<float>>(capacity)},
+        _parameter_values{arena.allocate_array<float>(capacity)},
+        _shape_scales{arena.allocate_array<std::atomic<float>>(capacity)},
+        _shape_bases{arena.allocate_array<std::atomic<float>>(capacity)},
+        _reset_requested{arena.allocate_array<std::atomic<bool>>(capacity)},
+        _active_slots{arena.allocate_array<uint32_t>(capacity)},
+        _queued{arena.allocate_array<std::atomic<bool>>(capacity)},
+        _ramp_lengths{arena.allocate_array<std::atomic<uint32_t>>(capacity)},
+        _pending_words{arena.allocate_array<std::atomic<uint64_t>>((capacity + pending_word_bits - 1u) / pending_word_bits)},
+        _notified{arena.allocate_array<std::atomic<bool>>(capacity)},
+        _active_params{arena.allocate_array<param_id>(capacity)},
+        _active_values{arena.allocate_array<float>(capacity)},
+        _active_targets{arena.allocate_array<float>(capacity)},
+        _active_coefficients{arena.allocate_array<float>(capacity)},
+        _active_steps{arena.allocate_array<float>(capacity)},
+        _active_remaining{arena.allocate_array<uint32_t>(capacity)},
+        _dt{1.f / sample_rate},
+        _smooth_characteristic_time{smooth_characteristic_time}
+    {
+        std::fill_n(_active_slots, capacity, no_active_slot);
+        _callbacks.reserve(capacity);
+        _free_params.reserve(capacity);
+        _update_smoothing();
+    }
+
+    std::size_t parameter_manager::memory_requirement(std::size_t capacity) noexcept
     {
+        //  Each array is cache line aligned in the arena
+        return
+            9u * capacity * sizeof(float) +
+            4u * capacity * sizeof(uint32_t) +
+            4u * capacity * sizeof(std::atomic<bool>) +
+            ((capacity + pending_word_bits - 1u) / pending_word_bits) * sizeof(uint64_t) +
+            19u * memory_arena::cache_line_size;
     }
 
     void parameter_manager::set_sample_rate(float sample_rate) noexcept
     {
         _dt = 1.f / sample_rate;
+        _update_smoothing();
     }
 
     void parameter_manager::set_smooth_characteristic_time(float tau) noexcept
     {
         _smooth_characteristic_time = tau;
+        _update_smoothing();
+    }
+
+    void parameter_manager::set_smoothing(smoothing mode) noexcept
+    {
+        _smoothing = mode;
     }
 
     void parameter_manager::set_parameter_shape_scale(param_id param, float scale) noexcept
     {
-        _shape_scales[param] = scale;
-        set_parameter_nomalized(param, _parameter_normalized_settings[param]);
+        _shape_scales[param].store(scale, std::memory_order_relaxed);
+        set_parameter_nomalized(param, _parameter_normalized_settings[param].load(std::memory_order_relaxed));
     }
 
     void parameter_manager::set_parameter_shape_base(param_id param, float base) noexcept
     {
-        _shape_bases[param] = base;
-        set_parameter_nomalized(param, _parameter_normalized_settings[param]);
+        _shape_bases[param].store(base, std::memory_order_relaxed);
+        set_parameter_nomalized(param, _parameter_normalized_settings[param].load(std::memory_order_relaxed));
     }
 
     float parameter_manager::get_parameter_shape_scale(param_id param) const noexcept
     {
-        return _shape_scales[param];
+        return _shape_scales[param].load(std::memory_order_relaxed);
     }
 
     float parameter_manager::get_parameter_shape_base(param_id param) const noexcept
     {
-        return _shape_bases[param];
+        return _shape_bases[param].load(std::memory_order_relaxed);
     }
 
     void parameter_manager::process_one_sample() noexcept
     {
-        const auto parameter_count = _parameter_values.size();
-        const auto factor = _smooth_characteristic_time / _dt;
-        const auto denominator = 1.f + factor;
+        _activate_changed_parameters();
+
+        const auto active_count = _active_count;
+
+        if (active_count == 0u)
+            return;
+
         /*
-         *  Each paramter is smoothed using a naive 1 pole low pass filter implementation.
+         *  Each paramter is smoothed using a naive 1 pole low pass filter implementation, or follows a linear ramp.
          *  It is not required to use a more precise numerical method since parameter are changing
          *  at subsonic frequencies.
+         *  Both are computed by the same branchless update (one of coefficient or step is zero), so that
+         *  this loop over the packed active parameters has no dependencies between iterations and is vectorized.
          */
-        for (auto i = 0u; i < parameter_count; ++i)
-        {
-            _parameter_values[i] =
-                (_parameter_settings[i] + factor * _parameter_values[i]) /
-                denominator;
+        for (auto i = 0u; i < active_count; ++i)
+            _active_values[i] += _active_coefficients[i] * (_active_targets[i] - _active_values[i]) + _active_steps[i];
+
+        //  Publish the values and retire the parameters which reached their setting
+        for (auto slot = 0u; slot < _active_count;) {
+            auto& published_value = _parameter_values[_active_params[slot]];
+            const auto value = _active_values[slot];
+            const auto target = _active_targets[slot];
+            const auto remaining = --_active_remaining[slot];
+
+            //  The one pole value can stop changing before reaching the threshold because of rounding
+            const auto converged =
+                (_active_coefficients[slot] != 0.f) ?
+                    (value == published_value ||
+                     std::abs(target - value) <= convergence_threshold * std::max(1.f, std::abs(target))) :
+                    remaining == 0u;
+
+            if (converged) {
+                published_value = target;
+                _deactivate_parameter(slot);
+            }
+            else {
+                published_value = value;
+                ++slot;
+            }
         }
     }
 
@@ -69,49 +143,54 @@ namespace Gammou
 
         if (_free_params.empty())
         {
-            new_id = _parameter_values.size();
-
-            //  Allocate memory and Set default shape and scales
-            _shape_scales.push_back(default_shape_scale);
-            _shape_bases.push_back(default_shape_base);
-            _parameter_normalized_settings.push_back(0.f);
-            _parameter_values.push_back(0.f);
-            _parameter_settings.push_back(0.f);
+            const auto parameter_count = _parameter_count.load(std::memory_order_relaxed);
+            if (parameter_count == _capacity)
+                throw std::length_error("parameter_manager : too many parameters");
+
+            new_id = static_cast<param_id>(parameter_count);
             _callbacks.emplace_back(control_changed_callback{});
+            _parameter_count.store(parameter_count + 1u, std::memory_order_release);
         }
         else
         {
-            new_id = _free_params.top();
-            _free_params.pop();
-
-            //  Set default shape and scales
-            _shape_bases[new_id] = default_shape_base;
-            _shape_scales[new_id] = default_shape_scale;
+            new_id = _free_params.back();
+            _free_params.pop_back();
         }
 
-        //  Set the initial parameter value
-        set_parameter_nomalized(new_id, initial_normalized_value);
+        //  Set default shape and scales
+        _shape_bases[new_id].store(default_shape_base, std::memory_order_relaxed);
+        _shape_scales[new_id].store(default_shape_scale, std::memory_order_relaxed);
+
+        //  The initial value is set without smoothing by the processing thread, which is the only one
+        //  writing the values. The parameter may still be active for its previous owner : it is retargeted
+        _update_setting(new_id, initial_normalized_value);
+        _reset_requested[new_id].store(true);
+        _mark_pending(new_id);
 
-        //  synchronize output value
-        _parameter_values[new_id] = _parameter_settings[new_id];
+        _allocated[new_id].store(true, std::memory_order_release);
 
         return parameter{*this, new_id};
     }
 
+    bool parameter_manager::is_allocated(param_id param) const noexcept
+    {
+        return param < _parameter_count.load(std::memory_order_acquire) &&
+            _allocated[param].load(std::memory_order_acquire);
+    }
+
     void parameter_manager::set_parameter_nomalized(param_id param, float value) noexcept
     {
-        const auto scale = _shape_scales[param];
-        const auto base = _shape_bases[param];
-        _parameter_normalized_settings[param] = value;
-        _parameter_settings[param] = scale * (powf(base, value) - 1.f) / (base - 1.f);
-        
-        if (auto& callback = _callbacks[param])
-            callback();
+        _change_setting(param, value, 0u);
+    }
+
+    void parameter_manager::set_parameter_ramp(param_id param, float value, std::size_t sample_count) noexcept
+    {
+        _change_setting(param, value, static_cast<uint32_t>(std::max<std::size_t>(1u, sample_count)));
     }
 
     float parameter_manager::get_parameter_nomalized(param_id param) const noexcept
     {
-        return _parameter_normalized_settings[param];
+        return _parameter_normalized_settings[param].load(std::memory_order_relaxed);
     }
 
     const float *parameter_manager::get_parameter_value_ptr(param_id param) const noexcept
@@ -124,10 +203,262 @@ namespace Gammou
         _callbacks[param] = callback;
     }
 
+    void parameter_manager::dispatch_control_changes()
+    {
+        const auto call =
+            [this](param_id param)
+            {
+                //  Clear the flag first so that a change during the callback is notified again
+                _notified[param].store(false, std::memory_order_relaxed);
+                if (auto& callback = _callbacks[param])
+                    callback();
+            };
+
+        _control_notifications.consume_all(call);
+
+        if (_notification_overflow.exchange(false, std::memory_order_acquire)) {
+            const auto parameter_count = _parameter_count.load(std::memory_order_relaxed);
+            for (auto param = 0u; param < parameter_count; ++param) {
+                if (_notified[param].load(std::memory_order_relaxed))
+                    call(param);
+            }
+        }
+    }
+
+    void parameter_manager::save_state(state_writer& writer) const
+    {
+        const auto parameter_count = _parameter_count.load();
+        writer.write<uint32_t>(static_cast<uint32_t>(parameter_count));
+        for (auto param = 0u; param < parameter_count; ++param) {
+            writer.write<uint8_t>(_allocated[param].load() ? 1u : 0u);
+            writer.write(_parameter_normalized_settings[param].load());
+            writer.write(_parameter_settings[param].load());
+            writer.write(_parameter_values[param]);
+        }
+
+        writer.write<uint32_t>(static_cast<uint32_t>(_active_count));
+        for (auto slot = 0u; slot < _active_count; ++slot) {
+            writer.write(_active_params[slot]);
+            writer.write(_active_values[slot]);
+            writer.write(_active_targets[slot]);
+            writer.write(_active_coefficients[slot]);
+            writer.write(_active_steps[slot]);
+            writer.write(_active_remaining[slot]);
+        }
+    }
+
+    void parameter_manager::load_state(state_reader& reader)
+    {
+        struct saved_parameter
+        {
+            uint8_t allocated;
+            float normalized_setting;
+            float setting;
+            float value;
+        };
+
+        struct saved_active_parameter
+        {
+            param_id param;
+            float value;
+            float target;
+            float coefficient;
+            float step;
+            uint32_t remaining;
+        };
+
+        //  Read everything before modifying the parameters, so that an invalid state leaves them untouched
+        const auto parameter_count = reader.read<uint32_t>();
+        if (parameter_count > _capacity)
+            throw std::invalid_argument("parameter_manager : invalid state");
+
+        std::vector<saved_parameter> parameters(parameter_count);
+        for (auto& p : parameters) {
+            p.allocated = reader.read<uint8_t>();
+            p.normalized_setting = reader.read<float>();
+            p.setting = reader.read<float>();
+            p.value = reader.read<float>();
+        }
+
+        const auto active_count = reader.read<uint32_t>();
+        if (active_count > parameter_count)
+            throw std::invalid_argument("parameter_manager : invalid state");
+
+        std::vector<saved_active_parameter> active_parameters(active_count);
+        for (auto& p : active_parameters) {
+            p.param = reader.read<param_id>();
+            p.value = reader.read<float>();
+            p.target = reader.read<float>();
+            p.coefficient = reader.read<float>();
+            p.step = reader.read<float>();
+            p.remaining = reader.read<uint32_t>();
+            if (p.param >= parameter_count)
+                throw std::invalid_argument("parameter_manager : invalid state");
+        }
+
+        const auto restored =
+            [&](param_id param)
+            {
+                return param < parameter_count && parameters[param].allocated && is_allocated(param);
+            };
+
+        //  Stop the smoothing of every parameter, then reactivate the saved active ones
+        for (auto slot = 0u; slot < _active_count; ++slot)
+            _active_slots[_active_params[slot]] = no_active_slot;
+        _active_count = 0u;
+
+        for (auto param = 0u; param < parameter_count; ++param) {
+            if (!restored(param))
+                continue;
+            _parameter_normalized_settings[param].store(parameters[param].normalized_setting);
+            _parameter_settings[param].store(parameters[param].setting);
+            _parameter_values[param] = parameters[param].value;
+            _reset_requested[param].store(false);
+            _notify_control_change(param);
+        }
+
+        for (const auto& p : active_parameters) {
+            if (!restored(p.param) || _active_slots[p.param] != no_active_slot)
+                continue;
+            const auto slot = static_cast<uint32_t>(_active_count++);
+            _active_slots[p.param] = slot;
+            _active_params[slot] = p.param;
+            _active_values[slot] = p.value;
+            _active_targets[slot] = p.target;
+            _active_coefficients[slot] = p.coefficient;
+            _active_steps[slot] = p.step;
+            _active_remaining[slot] = p.remaining;
+        }
+
+        _change_count.fetch_add(1u, std::memory_order_relaxed);
+    }
+
     void parameter_manager::_free_parameter(param_id param) noexcept
     {
-        _free_params.push(param);
+        _free_params.push_back(param);
+        _allocated[param].store(false, std::memory_order_release);
         _callbacks[param] = {};
     }
 
-} // namespace Gammou
\ No newline at end of file
+    void parameter_manager::_update_setting(param_id param, float value) noexcept
+    {
+        const auto scale = _shape_scales[param].load(std::memory_order_relaxed);
+        const auto base = _shape_bases[param].load(std::memory_order_relaxed);
+        _parameter_normalized_settings[param].store(value, std::memory_order_relaxed);
+        _parameter_settings[param].store(scale * (powf(base, value) - 1.f) / (base - 1.f));
+    }
+
+    void parameter_manager::_change_setting(param_id param, float value, uint32_t ramp_length) noexcept
+    {
+        _ramp_lengths[param].store(ramp_length);
+        _update_setting(param, value);
+        _mark_pending(param);
+        _change_count.fetch_add(1u, std::memory_order_relaxed);
+        _notify_control_change(param);
+    }
+
+    void parameter_manager::_mark_pending(param_id param) noexcept
+    {
+        //  The parameter will be activated by the processing thread, which will read the latest setting
+        if (_queued[param].exchange(true))
+            return;
+
+        if (!_changed_parameters.push(param)) {
+            _pending_words[param / pending_word_bits].fetch_or(
+                uint64_t{1u} << (param % pending_word_bits), std::memory_order_release);
+            _has_pending.store(true, std::memory_order_release);
+        }
+    }
+
+    void parameter_manager::_notify_control_change(param_id param) noexcept
+    {
+        //  Only one notification per parameter is queued until it is dispatched
+        if (!_notified[param].exchange(true, std::memory_order_acq_rel)) {
+            if (!_control_notifications.push(param))
+                _notification_overflow.store(true, std::memory_order_release);
+        }
+    }
+
+    void parameter_manager::_update_smoothing() noexcept
+    {
+        //  value += (setting - value) * dt / (dt + tau) : the division is only done here
+        _smoothing_coefficient = _dt / (_dt + _smooth_characteristic_time);
+        _ramp_sample_count =
+            std::max(1u, static_cast<uint32_t>(_smooth_characteristic_time / _dt));
+    }
+
+    void parameter_manager::_activate_changed_parameters() noexcept
+    {
+        _changed_parameters.consume_all(
+            [this](param_id param) { _activate_parameter(param); });
+
+        if (!_has_pending.load(std::memory_order_acquire))
+            return;
+
+        _has_pending.store(false, std::memory_order_relaxed);
+
+        const auto word_count = (_capacity + pending_word_bits - 1u) / pending_word_bits;
+        for (auto word_index = 0u; word_index < word_count; ++word_index) {
+            auto word = _pending_words[word_index].exchange(0u, std::memory_order_acquire);
+
+            for (auto bit = 0u; word != 0u; ++bit, word >>= 1u) {
+                if (word & 1u)
+                    _activate_parameter(word_index * pending_word_bits + bit);
+            }
+        }
+    }
+
+    void parameter_manager::_activate_parameter(param_id param) noexcept
+    {
+        //  Clear the flag before reading the setting, so that a later change is queued again
+        _queued[param].store(false);
+
+        auto slot = _active_slots[param];
+
+        //  A newly allocated parameter starts at its setting
+        if (_reset_requested[param].exchange(false)) {
+            _parameter_values[param] = _parameter_settings[param].load();
+            if (slot != no_active_slot)
+                _deactivate_parameter(slot);
+            return;
+        }
+
+        if (slot == no_active_slot) {
+            slot = static_cast<uint32_t>(_active_count++);
+            _active_slots[param] = slot;
+            _active_params[slot] = param;
+            _active_values[slot] = _parameter_values[param];
+        }
+
+        const auto requested_ramp_length = _ramp_lengths[param].load();
+        const auto target = _parameter_settings[param].load();
+        const auto linear =
+            requested_ramp_length != 0u || _smoothing == smoothing::LINEAR_RAMP;
+        const auto ramp_length =
+            requested_ramp_length != 0u ? requested_ramp_length : _ramp_sample_count;
+
+        _active_targets[slot] = target;
+        _active_coefficients[slot] = linear ? 0.f : _smoothing_coefficient;
+        _active_steps[slot] = linear ? (target - _active_values[slot]) / static_cast<float>(ramp_length) : 0.f;
+        _active_remaining[slot] = ramp_length;
+    }
+
+    void parameter_manager::_deactivate_parameter(std::size_t slot) noexcept
+    {
+        const auto last_slot = --_active_count;
+        _active_slots[_active_params[slot]] = no_active_slot;
+
+        //  Move the last active parameter to the freed slot
+        if (slot != last_slot) {
+            const auto moved_param = _active_params[last_slot];
+            _active_params[slot] = moved_param;
+            _active_values[slot] = _active_values[last_slot];
+            _active_targets[slot] = _active_targets[last_slot];
+            _active_coefficients[slot] = _active_coefficients[last_slot];
+            _active_steps[slot] = _active_steps[last_slot];
+            _active_remaining[slot] = _active_remaining[last_slot];
+            _active_slots[moved_param] = static_cast<uint32_t>(slot);
+        }
+    }
+
+} // namespace Gammou
@@ -1,14 +1,35 @@
 #ifndef GAMMOU_PARAMETER_MANAGER_H_
 #define GAMMOU_PARAMETER_MANAGER_H_
 
-#include <deque>
+#include <atomic>
 #include <algorithm>
-#include <stack>
+#include <cstdint>
 #include <limits>
 #include <functional>
+#include <vector>
+
+#include "utils/memory_arena.h"
+#include "utils/mpsc_queue.h"
+#include "utils/state_blob.h"
 
 namespace Gammou {
 
+    /**
+     * \class parameter_manager
+     * \brief Store the parameters values and smooth them toward their settings.
+     *
+     *  The values are stored in fixed capacity arrays allocated from the sound processing arena,
+     *  so that the value pointers stay valid. Only the parameters which are still moving toward
+     *  their setting are processed : they are kept packed in the active arrays.
+     *
+     *  Settings can be changed from any thread : the changes are passed to the processing thread
+     *  through a lock free queue, and the control changed callbacks are called later on the gui
+     *  thread by dispatch_control_changes(), at most once per parameter and per dispatch.
+     *
+     *  Threads : the parameters are allocated and freed, and their callbacks set and called, on the gui thread.
+     *  The settings, shapes and allocation flags are atomics which can be read and written from any thread.
+     *  The smoothed values are only written by the processing thread.
+     */
     class parameter_manager {
 
         static constexpr auto default_shape_scale = 1.0f;
@@ -18,6 +39,16 @@ namespace Gammou {
         using param_id = unsigned int;
         static constexpr param_id INVALID_PARAM = std::numeric_limits<param_id>::max();
         using control_changed_callback = std::function<void()>;
+        static constexpr std::size_t default_capacity = 1024u;
+
+        /**
+         *  \enum smoothing How the parameter values move toward their settings
+         */
+        enum class smoothing
+        {
+            ONE_POLE,       /** Exponential approach, with the smooth characteristic time as time constant **/
+            LINEAR_RAMP     /** Linear ramp lasting the smooth characteristic time **/
+        };
 
         /**
          * \class parameter
@@ -112,15 +143,56 @@ namespace Gammou {
             param_id _id;
         };
 
-        parameter_manager(float sample_rate, float smooth_characteristic_time = 0.05f) noexcept;
+        /**
+         *  \param arena memory used to store the parameters, \see memory_requirement
+         *  \param capacity the maximum number of parameters allocated at the same time
+         */
+        parameter_manager(
+            memory_arena& arena,
+            float sample_rate,
+            std::size_t capacity = default_capacity,
+            float smooth_characteristic_time = 0.05f);
+
+        /**
+         *  \brief Return the arena memory needed by a parameter manager handling capacity parameters
+         */
+        static std::size_t memory_requirement(std::size_t capacity) noexcept;
 
         void set_sample_rate(float sample_rate) noexcept;
         void set_smooth_characteristic_time(float tau) noexcept;
+        void set_smoothing(smoothing mode) noexcept;
         void process_one_sample() noexcept;
 
+        /**
+         *  \return the number of parameters still moving toward their setting
+         */
+        std::size_t active_parameter_count() const noexcept { return _active_count; }
+
+        /**
+         *  \throw std::length_error if capacity parameters are already allocated
+         */
         parameter allocate_parameter(float initial_normalized_value = 0.f);
 
+        /**
+         *  \return true if the parameter is currently owned by a parameter handle
+         */
+        bool is_allocated(param_id param) const noexcept;
+
+        /**
+         *  \brief Set the normalized setting of a parameter.
+         *  \note Can be called from any thread, the processing thread will use the new setting
+         *  at the next sample and the control changed callback is called by dispatch_control_changes()
+         */
         void set_parameter_nomalized(param_id param, float value) noexcept;
+
+        /**
+         *  \brief Set the normalized setting of a parameter, the value moving linearly toward it
+         *  during sample_count samples whatever the smoothing mode. Used for host automation,
+         *  with the block size as ramp length so that the setting is reached at the end of the block.
+         *  \note Several changes before the processing thread collects them are coalesced :
+         *  only the last one is applied
+         */
+        void set_parameter_ramp(param_id param, float value, std::size_t sample_count) noexcept;
         void set_parameter_shape_scale(param_id param, float scale) noexcept;
         void set_parameter_shape_base(param_id param, float base) noexcept;
 
@@ -131,18 +203,91 @@ namespace Gammou {
 
         void set_control_changed_callback(param_id param, control_changed_callback callback) noexcept;
 
+        /**
+         *  \brief Call the control changed callbacks of the parameters changed since the last call.
+         *  \note Must be called on the gui thread, typically at frame rate
+         */
+        void dispatch_control_changes();
+
+        /**
+         *  \brief Write the settings and smoothed values of the allocated parameters
+         */
+        void save_state(state_writer& writer) const;
+
+        /**
+         *  \brief Restore the settings and smoothed values written by save_state.
+         *  Only the parameters which are currently allocated are restored, and their control changes are notified.
+         *  \throw std::invalid_argument if the state is truncated or invalid
+         *  \note Must not be called while processing
+         */
+        void load_state(state_reader& reader);
+
+        /**
+         *  \brief Return a counter incremented each time a parameter setting is changed
+         */
+        unsigned int get_change_count() const noexcept
+        {
+            return _change_count.load(std::memory_order_relaxed);
+        }
+
     private:
+        static constexpr auto no_active_slot = std::numeric_limits<uint32_t>::max();
+        static constexpr auto pending_word_bits = 64u;
+
         void _free_parameter(param_id param) noexcept;
+        void _update_setting(param_id param, float value) noexcept;
+        void _change_setting(param_id param, float value, uint32_t ramp_length) noexcept;
+        void _mark_pending(param_id param) noexcept;
+        void _update_smoothing() noexcept;
+        void _activate_changed_parameters() noexcept;
+        void _notify_control_change(param_id param) noexcept;
+        void _activate_parameter(param_id param) noexcept;
+        void _deactivate_parameter(std::size_t slot) noexcept;
+
+        const std::size_t _capacity;
+        std::atomic<std::size_t> _parameter_count{0u};
+        std::vector<param_id> _free_params{};                   //<< Gui thread only
+
+        //  Per parameter arrays, indexed by param_id
+        std::atomic<bool> *_allocated;
+        std::atomic<float> *_parameter_normalized_settings;
+        std::atomic<float> *_parameter_settings;
+        float *_parameter_values;                               //<< Written by the processing thread only
+        std::atomic<float> *_shape_scales;
+        std::atomic<float> *_shape_bases;
+        std::atomic<bool> *_reset_requested;                    //<< Jump to the setting without smoothing on activation
+        uint32_t *_active_slots;
+        std::vector<control_changed_callback> _callbacks{};     //<< Gui thread only
+
+        //  Parameters whose setting changed, pushed by the control threads, collected by the processing thread.
+        //  A parameter is queued once until it is collected. When the queue is full, the parameter is marked
+        //  in the pending bitmask instead.
+        mpsc_queue<param_id, 1024u> _changed_parameters{};
+        std::atomic<bool> *_queued;
+        std::atomic<uint32_t> *_ramp_lengths;   //<< Requested ramp length, 0 for the smoothing mode
+        std::atomic<uint64_t> *_pending_words;
+        std::atomic<bool> _has_pending{false};
+
+        //  Parameters whose control changed callback must be called, coalesced by the notified flags
+        mpsc_queue<param_id, 1024u> _control_notifications{};
+        std::atomic<bool> *_notified;
+        std::atomic<bool> _notification_overflow{false};
+
+        //  Active parameters, packed so that smoothing loops are vectorized
+        std::size_t _active_count{0u};
+        param_id *_active_params;
+        float *_active_values;
+        float *_active_targets;
+        float *_active_coefficients;    //<< One pole coefficient, 0 for linear ramps
+        float *_active_steps;           //<< Linear ramp step, 0 for one pole smoothing
+        uint32_t *_active_remaining;
 
-        std::stack<unsigned int> _free_params;
-        std::deque<float> _parameter_normalized_settings{};
-        std::deque<float> _parameter_settings{};
-        std::deque<float> _parameter_values{};
-        std::deque<float> _shape_scales{};
-        std::deque<float> _shape_bases{};
-        std::deque< control_changed_callback> _callbacks{};
         float _dt;
         float _smooth_characteristic_time;
+        smoothing _smoothing{smoothing::ONE_POLE};
+        float _smoothing_coefficient{0.f};
+        uint32_t _ramp_sample_count{1u};
+        std::atomic<unsigned int> _change_count{0u};
     };
 
 
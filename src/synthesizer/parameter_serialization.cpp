@@ -28,6 +28,12 @@ namespace Gammou {
         if (desc.midi_control.has_value())
             synth.midi_assign_control(desc.midi_control.value(), param);
 
+        //  Keep the host automation mapping stable accross sessions
+        std::optional<unsigned int> automation_slot{};
+        optional_field_get_to(json, "automation_slot", automation_slot);
+        if (automation_slot.has_value())
+            synth.automation_assign_slot(automation_slot.value(), param);
+
         return param;
     }
 
@@ -43,6 +49,10 @@ namespace Gammou {
             desc.midi_control = control;
         nlohmann::json json;
         to_json(json, desc);
+
+        unsigned int automation_slot{};
+        if (synth.automation_assigned_to_slot(automation_slot, param))
+            json["automation_slot"] = automation_slot;
         return json;
     }
 }
\ No newline at end of file
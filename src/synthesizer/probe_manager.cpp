@@ -0,0 +1,111 @@
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "probe_manager.h"
+
+namespace Gammou
+{
+
+    probe_manager::probe_manager(memory_arena& arena, std::size_t capacity)
+    :   _capacity{capacity},
+        _taps{arena.allocate_array<tap>(capacity)}
+    {
+        _free_probes.reserve(capacity);
+        _retired_probes.reserve(capacity);
+    }
+
+    std::size_t probe_manager::memory_requirement(std::size_t capacity) noexcept
+    {
+        //  The ring indices and values are cache line aligned
+        return capacity * sizeof(tap) + memory_arena::cache_line_size;
+    }
+
+    probe_manager::probe probe_manager::allocate_probe()
+    {
+        probe_id new_id = INVALID_PROBE;
+
+        _reclaim_retired_probes();
+
+        if (_free_probes.empty())
+        {
+            if (_probe_count == _capacity)
+                throw std::length_error("probe_manager : too many probes");
+
+            new_id = static_cast<probe_id>(_probe_count++);
+        }
+        else
+        {
+            new_id = _free_probes.back();
+            _free_probes.pop_back();
+        }
+
+        //  Drop the samples pushed for the previous owner
+        auto& t = _taps[new_id];
+        t.ring.consume_all([](float) {});
+        t.decimation.store(1u, std::memory_order_relaxed);
+
+        return probe{*this, new_id};
+    }
+
+    void probe_manager::set_probe_decimation(probe_id id, unsigned int decimation) noexcept
+    {
+        _taps[id].decimation.store(std::clamp(decimation, 1u, max_decimation), std::memory_order_relaxed);
+    }
+
+    void probe_manager::push(tap *t, float sample) noexcept
+    {
+        if (++t->sample_counter < t->decimation.load(std::memory_order_relaxed))
+            return;
+
+        t->sample_counter = 0u;
+
+        //  The ring is only full when the reader went away : stop pushing until it reads again
+        if (!t->ring.push(sample))
+            t->listening.store(false, std::memory_order_relaxed);
+    }
+
+    void probe_manager::master_program_compiled() noexcept
+    {
+        _compiled_generation.store(++_last_compiled_generation, std::memory_order_release);
+    }
+
+    uint64_t probe_manager::compiled_generation() const noexcept
+    {
+        return _compiled_generation.load(std::memory_order_acquire);
+    }
+
+    void probe_manager::set_program_generation(uint64_t generation) noexcept
+    {
+        _program_generation.store(generation, std::memory_order_release);
+    }
+
+    void probe_manager::_free_probe(probe_id id) noexcept
+    {
+        _taps[id].listening.store(false, std::memory_order_relaxed);
+
+        //  The capacity was reserved
+        _retired_probes.push_back(retired_probe{id, _last_compiled_generation});
+    }
+
+    void probe_manager::_reclaim_retired_probes()
+    {
+        //  The programs compiled after a probe was freed do not use it
+        const auto program_generation = _program_generation.load(std::memory_order_acquire);
+        const auto reclaimable =
+            [program_generation](const retired_probe& p)
+            {
+                return p.generation < program_generation;
+            };
+
+        for (const auto& p : _retired_probes) {
+            if (reclaimable(p))
+                _free_probes.push_back(p.id);
+        }
+
+        _retired_probes.erase(
+            std::remove_if(_retired_probes.begin(), _retired_probes.end(), reclaimable),
+            _retired_probes.end());
+    }
+
+}
@@ -0,0 +1,177 @@
+#ifndef GAMMOU_PROBE_MANAGER_H_
+#define GAMMOU_PROBE_MANAGER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "utils/memory_arena.h"
+#include "utils/spsc_queue.h"
+
+namespace Gammou {
+
+    /**
+     * \class probe_manager
+     * \brief Store the probe rings, through which the sound processing thread passes signals to the gui.
+     *
+     *  A probe node pushes its input samples into a wait free ring, decimated or at full rate, which is read
+     *  by the gui to draw scopes and meters. Nothing is pushed while no one listens : a probe starts listening
+     *  when it is read, and stops by itself when its ring is full because the reader went away.
+     *
+     *  As the parameters, the probes are stored in a fixed capacity array allocated from the sound
+     *  processing arena, so that a compiled program can still push into a freed probe until it is replaced.
+     *  A freed probe is only reused once the processing thread runs a master circuit program compiled after
+     *  it was freed, so that the new owner does not receive the samples of the removed node.
+     *
+     *  Probes are only supported in the master circuit : in a polyphonic circuit every voice would push into
+     *  the same ring, and a freed probe could be reused while the previous polyphonic program still runs.
+     */
+    class probe_manager {
+    public:
+        using probe_id = unsigned int;
+        static constexpr probe_id INVALID_PROBE = std::numeric_limits<probe_id>::max();
+        static constexpr std::size_t default_capacity = 32u;
+        static constexpr std::size_t ring_size = 2048u;
+        static constexpr unsigned int max_decimation = 1024u;
+
+        /**
+         * \brief The data shared by a probe node and its reader
+         */
+        struct tap
+        {
+            std::atomic<bool> listening{false};     //<< Read by the compiled code before pushing
+            std::atomic<uint32_t> decimation{1u};
+            uint32_t sample_counter{0u};             //<< Only used by the sound processing thread
+            spsc_queue<float, ring_size> ring{};
+        };
+
+        /**
+         * \class probe
+         * \brief A probe handle, that manage its lifetime
+         */
+        class probe {
+            friend class probe_manager;
+        public:
+            probe(probe&& other) noexcept
+            :   _mgr{other._mgr}, _id{other._id}
+            {
+                other._id = INVALID_PROBE;
+            }
+
+            ~probe() noexcept
+            {
+                if (_id != INVALID_PROBE)
+                    _mgr._free_probe(_id);
+            }
+
+            /**
+             *  \brief Return the tap written by the probe node
+             */
+            tap& get_tap() const noexcept { return _mgr._taps[_id]; }
+
+            /**
+             *  \brief Push one sample out of decimation samples, in [1, max_decimation]
+             */
+            void set_decimation(unsigned int decimation) noexcept
+            {
+                _mgr.set_probe_decimation(_id, decimation);
+            }
+
+            unsigned int get_decimation() const noexcept
+            {
+                return get_tap().decimation.load(std::memory_order_relaxed);
+            }
+
+            /**
+             *  \brief Pass the samples pushed since the last call to func, and keep the probe listening.
+             *  \note Must be called from a single thread, typically the gui thread
+             */
+            template <typename Func>
+            void read(Func&& func)
+            {
+                auto& t = get_tap();
+                t.ring.consume_all(func);
+                t.listening.store(true, std::memory_order_relaxed);
+            }
+
+        private:
+            probe(probe_manager& mgr, probe_id id)
+            :   _mgr{mgr}, _id{id}
+            {}
+
+            probe(const probe&) = delete;
+            auto& operator=(const probe&) = delete;
+            auto& operator=(probe&&) = delete;
+
+            probe_manager& _mgr;
+            probe_id _id;
+        };
+
+        /**
+         *  \param arena memory used to store the probes, \see memory_requirement
+         *  \param capacity the maximum number of probes allocated at the same time
+         */
+        probe_manager(memory_arena& arena, std::size_t capacity = default_capacity);
+
+        /**
+         *  \brief Return the arena memory needed by a probe manager handling capacity probes
+         */
+        static std::size_t memory_requirement(std::size_t capacity) noexcept;
+
+        /**
+         *  \throw std::length_error if capacity probes are already allocated, or freed but possibly still
+         *  used by the running program
+         */
+        probe allocate_probe();
+
+        void set_probe_decimation(probe_id id, unsigned int decimation) noexcept;
+
+        /**
+         *  \brief Push a sample into a listening tap. Called by the compiled code of the probe nodes.
+         *  \note Must be called from the sound processing thread
+         */
+        static void push(tap *t, float sample) noexcept;
+
+        /**
+         *  \brief Notify that a master circuit program was compiled. The probes freed before can be reused
+         *  once the processing thread runs this program.
+         *  \note Must be called from the compilation thread, after the program was compiled
+         */
+        void master_program_compiled() noexcept;
+
+        /**
+         *  \brief Return the generation of the last compiled master circuit program
+         *  \note Must be read by the processing thread before updating the programs
+         */
+        uint64_t compiled_generation() const noexcept;
+
+        /**
+         *  \brief Set the generation of the master circuit program run by the processing thread
+         *  \param generation read by compiled_generation() before the programs were updated
+         */
+        void set_program_generation(uint64_t generation) noexcept;
+
+    private:
+        struct retired_probe
+        {
+            probe_id id;
+            uint64_t generation;    //<< Last compiled generation when the probe was freed
+        };
+
+        void _free_probe(probe_id id) noexcept;
+        void _reclaim_retired_probes();
+
+        const std::size_t _capacity;
+        std::size_t _probe_count{0u};
+        std::vector<probe_id> _free_probes{};
+        std::vector<retired_probe> _retired_probes{};     //<< Freed, possibly still used by the running program
+        uint64_t _last_compiled_generation{0u};
+        std::atomic<uint64_t> _compiled_generation{0u};
+        std::atomic<uint64_t> _program_generation{0u};
+        tap *_taps;
+    };
+
+}
+
+#endif
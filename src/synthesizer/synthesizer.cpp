@@ -1,11 +1,108 @@
 #include <algorithm>
+#include <cmath>
+#include <stdexcept>
 #include <llvm/Transforms/Utils/Cloning.h>
 #include <DSPJIT/log.h>
 
 #include "synthesizer.h"
+#include "utils/denormals.h"
+#include "utils/rt_check.h"
+#include "utils/rt_log.h"
+#include "utils/state_blob.h"
 
 namespace Gammou {
 
+    /**
+     *  Circuit controller transaction implementation
+     */
+    void synthesizer::circuit_controller::compile()
+    {
+        if (_transaction_depth > 0u)
+            _compile_requested = true;
+        else
+            _compile_and_notify();
+    }
+
+    void synthesizer::circuit_controller::begin_transaction() noexcept
+    {
+        _transaction_depth++;
+    }
+
+    void synthesizer::circuit_controller::commit_transaction()
+    {
+        if (_transaction_depth == 0u)
+            throw std::logic_error("circuit_controller::commit_transaction: no transaction was begun");
+
+        if (--_transaction_depth == 0u && _compile_requested) {
+            _compile_requested = false;
+            _compile_and_notify();
+        }
+    }
+
+    void synthesizer::circuit_controller::set_compile_callback(compile_callback callback)
+    {
+        _compile_callback = std::move(callback);
+    }
+
+    void synthesizer::circuit_controller::_compile_and_notify()
+    {
+        _compile();
+        if (_compile_callback)
+            _compile_callback();
+    }
+
+    synthesizer::compile_transaction::compile_transaction(synthesizer& synth) noexcept
+    :   _synthesizer{synth}
+    {
+        _synthesizer._master_circuit_controller.begin_transaction();
+        _synthesizer._polyphonic_circuit_controller.begin_transaction();
+    }
+
+    synthesizer::compile_transaction::~compile_transaction() noexcept
+    {
+        if (_committed)
+            return;
+
+        // Exceptions must not escape from a destructor which can be run during stack unwinding
+        try {
+            _synthesizer._master_circuit_controller.commit_transaction();
+        }
+        catch (const std::exception& e) {
+            LOG_ERROR("[synthesizer][compile transaction] Failed to compile master circuit: %s\n", e.what());
+        }
+
+        try {
+            _synthesizer._polyphonic_circuit_controller.commit_transaction();
+        }
+        catch (const std::exception& e) {
+            LOG_ERROR("[synthesizer][compile transaction] Failed to compile polyphonic circuit: %s\n", e.what());
+        }
+    }
+
+    void synthesizer::compile_transaction::commit()
+    {
+        if (_committed)
+            throw std::logic_error("compile_transaction::commit: the transaction was already committed");
+
+        _committed = true;
+
+        try {
+            _synthesizer._master_circuit_controller.commit_transaction();
+        }
+        catch (...) {
+            //  The polyphonic transaction must be ended too, only the first error is thrown
+            try {
+                _synthesizer._polyphonic_circuit_controller.commit_transaction();
+            }
+            catch (const std::exception& e) {
+                LOG_ERROR("[synthesizer][compile transaction] Failed to compile polyphonic circuit: %s\n", e.what());
+            }
+            throw;
+        }
+
+        _synthesizer._polyphonic_circuit_controller.commit_transaction();
+    }
+
     /**
      *  Circuit controllers implementation
      */
@@ -14,19 +111,28 @@ namespace Gammou {
     {
     }
 
-    void synthesizer::master_circuit_controller::compile()
+    void synthesizer::master_circuit_controller::_compile()
     {
         LOG_INFO("[synthesizer] Compile master circuit\n");
-        _synthesizer._master_circuit_context.compile({_synthesizer._from_polyphonic}, {_synthesizer._output});
+        _synthesizer._compile_circuit(
+            _synthesizer._master_circuit_context,
+            _synthesizer._from_polyphonic, _synthesizer._output,
+            _optimization_remarks);
+
+        //  The whole circuit is still needed by process_sample
+        _synthesizer._master_branches.compile(_synthesizer._from_polyphonic, _synthesizer._output);
+        _synthesizer._probe_manager.master_program_compiled();
     }
 
     void synthesizer::master_circuit_controller::register_static_memory_chunk(const DSPJIT::compile_node_class &node, std::vector<uint8_t> &&data)
     {
+        _synthesizer._master_branches.register_static_memory_chunk(node, data);
         _synthesizer._master_circuit_context.register_static_memory_chunk(node, std::move(data));
     }
 
     void synthesizer::master_circuit_controller::free_static_memory_chunk(const DSPJIT::compile_node_class &node)
     {
+        _synthesizer._master_branches.free_static_memory_chunk(node);
         _synthesizer._master_circuit_context.free_static_memory_chunk(node);
     }
 
@@ -35,10 +141,13 @@ namespace Gammou {
     {
     }
 
-    void synthesizer::polyphonic_circuit_controller::compile()
+    void synthesizer::polyphonic_circuit_controller::_compile()
     {
         LOG_INFO("[synthesizer] Compile polyphonic circuit\n");
-        _synthesizer._polyphonic_circuit_context.compile({_synthesizer._midi_input}, {_synthesizer._to_master});
+        _synthesizer._compile_circuit(
+            _synthesizer._polyphonic_circuit_context,
+            _synthesizer._midi_input, _synthesizer._to_master,
+            _optimization_remarks);
     }
 
     void synthesizer::polyphonic_circuit_controller::register_static_memory_chunk(const DSPJIT::compile_node_class &node, std::vector<uint8_t> &&data)
@@ -66,35 +175,104 @@ namespace Gammou {
         _polyphonic_circuit_context{
             DSPJIT::graph_execution_context_factory::build(
                 llvm_context, config.optimization_level, config.target_options, config.voice_count)},
+        _master_branches{
+            llvm_context, config.optimization_level, config.target_options,
+            voice_manager::polyphonic_to_master_channel_count, config.output_count,
+            config.master_branches_config},
+        _pipeline_block_size{std::max<std::size_t>(config.pipeline_block_size, 1u)},
+        _pipeline_polyphonic_buffers(2u * _pipeline_block_size * voice_manager::polyphonic_to_master_channel_count),
+        _pipeline_output(_pipeline_block_size * config.output_count),
         _from_polyphonic{0u, voice_manager::polyphonic_to_master_channel_count},
         _output{config.output_count, 0u},
         _midi_input{0u, voice_manager::midi_input_count},
         _to_master{voice_manager::polyphonic_to_master_channel_count, 0u},
-        _voice_manager{config.voice_count, _polyphonic_circuit_context},
+        _dsp_memory{
+            voice_manager::memory_requirement(config.voice_count) +
+            parameter_manager::memory_requirement(config.parameter_capacity) +
+            probe_manager::memory_requirement(config.probe_capacity),
+            config.use_huge_pages},
+        _voice_manager{config.voice_count, _polyphonic_circuit_context, _dsp_memory},
+        _voice_memory_cap{config.voice_memory_cap},
+        _voice_preparation_per_block{config.voice_preparation_per_block},
+        _prepared_voice_count{config.prepared_voice_count},
+        _voice_silence_threshold{config.voice_silence_threshold},
+        _voice_silence_hold{config.voice_silence_hold},
+        _voice_level_detection{config.voice_level_detection},
+        _voice_steal_fade{config.voice_steal_fade},
+        _sample_rate{config.sample_rate},
+        _load_governor{config.load_governor_config, config.voice_count},
+        _master_silence_threshold{config.master_silence_threshold},
+        _master_silence_hold{config.master_silence_hold},
         _master_circuit_controller{*this},
         _polyphonic_circuit_controller{*this},
-        _parameter_manager{config.sample_rate}
+        _parameter_manager{_dsp_memory, config.sample_rate, config.parameter_capacity},
+        _probe_manager{_dsp_memory, config.probe_capacity}
     {
+        _parameter_manager.set_smoothing(config.parameter_smoothing);
         std::fill_n(_midi_learn_map.begin(), _midi_learn_map.size(), parameter_manager::INVALID_PARAM);
+        std::fill_n(_automation_map.begin(), _automation_map.size(), parameter_manager::INVALID_PARAM);
+        set_max_voices(config.max_voices);
+        set_voice_steal_policy(config.voice_steal_policy, config.same_note_retrigger);
+        enable_load_governor(config.enable_load_governor);
+        enable_pipelined_processing(config.pipelined_processing);
         set_sample_rate(config.sample_rate);
     }
 
     void synthesizer::process_sample(const float input[], float output[]) noexcept
     {
+        realtime_scope rt_scope{};
         _process_one_sample(input, output);
+        _voice_manager.end_block(1u);
     }
 
     void synthesizer::process_buffer(std::size_t sample_count, const float[],float outputs[]) noexcept
     {
-        for (auto i = 0u; i < sample_count; ++i)
-            _process_one_sample(nullptr, outputs + i * _output_count);
+        realtime_scope rt_scope{};
+        const auto start = std::chrono::steady_clock::now();
+
+        if (_master_sleeping && !_master_must_wake_up()) {
+            std::fill_n(outputs, sample_count * _output_count, 0.f);
+        }
+        else {
+            _master_sleeping = false;
+            if (_pipelined) {
+                //  The voices blocks are ended by the pipeline steps
+                _process_pipelined(sample_count, outputs);
+            }
+            else {
+                if (_master_branches.active()) {
+                    _process_master_branches(sample_count, outputs);
+                }
+                else {
+                    for (auto i = 0u; i < sample_count; ++i)
+                        _process_one_sample(nullptr, outputs + i * _output_count);
+                }
+                _voice_manager.end_block(sample_count);
+            }
+            _update_master_tail(sample_count, outputs);
+        }
+
+        prepare_voices();
+
+        //  Adjust the voice budget to the processing load
+        const auto duration = std::chrono::steady_clock::now() - start;
+        if (_load_governor.end_block(duration, sample_count, _voice_manager.active_voice_count())) {
+            const auto budget = _load_governor.voice_budget();
+            _voice_manager.set_max_voices(budget);
+            _voice_manager.release_voices(budget);
+        }
+    }
+
+    void synthesizer::prepare_voices() noexcept
+    {
+        _voice_manager.prepare_free_voices(_voice_preparation_per_block, _prepared_voice_count);
     }
 
     void synthesizer::midi_note_on(uint8_t note, float velocity)
     {
-        if (!_voice_manager.note_on(note, velocity)) {
-            LOG_ERROR("[synthesizer][not on] No anymore free voice\n");
-        }
+        //  Dropped notes are also counted by the voice manager
+        if (!_voice_manager.note_on(note, velocity))
+            RT_LOG_DEBUG("[synthesizer] No voice available to play note %u\n", note);
     }
 
     void synthesizer::midi_note_off(uint8_t note, float velocity)
@@ -107,7 +285,7 @@ namespace Gammou {
         if (_midi_learning) {
             _midi_learn_map[control] = _learning_param;
             _midi_learning = false;
-            LOG_DEBUG("[synthesizer][midi learn] Midi control %u assigned to parameter %u\n", control, _learning_param);
+            RT_LOG_DEBUG("[synthesizer][midi learn] Midi control %u assigned to parameter %u\n", control, _learning_param);
         }
 
         auto param_id = _midi_learn_map[control];
@@ -119,9 +297,23 @@ namespace Gammou {
     {
         auto param = _parameter_manager.allocate_parameter(normalized_initial_value);
         midi_disassign(param);
+
+        //  The id may be reused : forget the slot of its previous owner
+        _automation_disassign(param.id());
+        automation_assign(param);
         return param;
     }
 
+    synthesizer::probe synthesizer::allocate_probe()
+    {
+        return _probe_manager.allocate_probe();
+    }
+
+    void synthesizer::dispatch_control_changes()
+    {
+        _parameter_manager.dispatch_control_changes();
+    }
+
     void synthesizer::midi_learn(const parameter& param)
     {
         LOG_DEBUG("[synthesizer][midi learn] start midi learn for parameter %u\n", param.id());
@@ -157,9 +349,73 @@ namespace Gammou {
         return false;
     }
 
+    bool synthesizer::automation_assign(const parameter& param) noexcept
+    {
+        _automation_disassign(param.id());
+
+        for (auto& slot_param : _automation_map) {
+            if (slot_param == parameter_manager::INVALID_PARAM || !_parameter_manager.is_allocated(slot_param)) {
+                slot_param = param.id();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void synthesizer::automation_assign_slot(unsigned int slot, const parameter& param) noexcept
+    {
+        if (slot < automation_slot_count) {
+            _automation_disassign(param.id());
+            _automation_map[slot] = param.id();
+        }
+    }
+
+    bool synthesizer::automation_assigned_to_slot(unsigned int& slot, const parameter& param) const noexcept
+    {
+        for (auto i = 0u; i < automation_slot_count; ++i) {
+            if (_automation_map[i] == param.id()) {
+                slot = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool synthesizer::automation_slot_used(unsigned int slot) const noexcept
+    {
+        if (slot >= automation_slot_count)
+            return false;
+        const auto param_id = _automation_map[slot];
+        return param_id != parameter_manager::INVALID_PARAM && _parameter_manager.is_allocated(param_id);
+    }
+
+    void synthesizer::automation_set(unsigned int slot, float value, std::size_t sample_count) noexcept
+    {
+        if (automation_slot_used(slot))
+            _parameter_manager.set_parameter_ramp(_automation_map[slot], value, sample_count);
+    }
+
+    float synthesizer::automation_get(unsigned int slot) const noexcept
+    {
+        if (automation_slot_used(slot))
+            return _parameter_manager.get_parameter_nomalized(_automation_map[slot]);
+        else
+            return 0.f;
+    }
+
+    void synthesizer::_automation_disassign(param_id param) noexcept
+    {
+        for (auto& slot_param : _automation_map) {
+            if (slot_param == param)
+                slot_param = parameter_manager::INVALID_PARAM;
+        }
+    }
+
     void synthesizer::add_library_module(std::unique_ptr<llvm::Module>&& m)
     {
         _master_circuit_context.add_library_module(llvm::CloneModule(*m));
+        _master_branches.add_library_module(llvm::CloneModule(*m));
         _polyphonic_circuit_context.add_library_module(std::move(m));
     }
 
@@ -170,6 +426,8 @@ namespace Gammou {
 
         _master_circuit_context.set_global_constant(_samplerate_symbol, samplerate);
         _master_circuit_context.set_global_constant(_sample_duration_symbol, sampleduration);
+        _master_branches.set_global_constant(_samplerate_symbol, samplerate);
+        _master_branches.set_global_constant(_sample_duration_symbol, sampleduration);
         _master_circuit_controller.compile();
 
         _polyphonic_circuit_context.set_global_constant(_samplerate_symbol, samplerate);
@@ -177,6 +435,26 @@ namespace Gammou {
         _polyphonic_circuit_controller.compile();
 
         _parameter_manager.set_sample_rate(samplerate);
+        _load_governor.set_sample_rate(samplerate);
+        _sample_rate = samplerate;
+
+        _voice_manager.set_silence_detection(
+            _voice_silence_threshold,
+            static_cast<unsigned int>(_voice_silence_hold * samplerate),
+            _voice_level_detection);
+        _voice_manager.set_steal_fade(static_cast<unsigned int>(_voice_steal_fade * samplerate));
+        _master_silence_hold_sample_count =
+            static_cast<std::size_t>(_master_silence_hold * samplerate);
+    }
+
+    const memory_arena::statistics& synthesizer::get_dsp_memory_statistics() const noexcept
+    {
+        return _dsp_memory.get_statistics();
+    }
+
+    bool synthesizer::bind_dsp_memory_to_current_thread() noexcept
+    {
+        return _dsp_memory.bind_to_current_numa_node();
     }
 
     void synthesizer::set_voice_mode(const voice_mode mode) noexcept
@@ -189,22 +467,288 @@ namespace Gammou {
         return _voice_manager.get_voice_mode();
     }
 
+    void synthesizer::set_max_voices(std::size_t max_voices) noexcept
+    {
+        const auto budget = std::min<std::size_t>(max_voices == 0u ? get_voice_count() : max_voices, get_voice_count());
+        _voice_manager.set_max_voices(budget);
+        _load_governor.set_max_voice_budget(budget);
+    }
+
+    void synthesizer::set_voice_steal_policy(steal_policy policy, bool same_note_retrigger) noexcept
+    {
+        _voice_manager.set_steal_policy(policy, same_note_retrigger);
+    }
+
+    void synthesizer::enable_load_governor(bool enable) noexcept
+    {
+        _load_governor.set_enabled(enable);
+    }
+
+    void synthesizer::enable_pipelined_processing(bool enable)
+    {
+        if (enable && !_pipeline_pool)
+            _pipeline_pool = std::make_unique<task_pool>(1u);
+
+        //  Start with a silent block
+        std::fill(_pipeline_polyphonic_buffers.begin(), _pipeline_polyphonic_buffers.end(), 0.f);
+        std::fill(_pipeline_output.begin(), _pipeline_output.end(), 0.f);
+        _pipeline_read_position = _pipeline_block_size;
+        _pipelined = enable;
+
+        LOG_INFO("[synthesizer] Pipelined processing %s\n", enable ? "enabled" : "disabled");
+    }
+
+    std::size_t synthesizer::get_latency() const noexcept
+    {
+        return _pipelined ? _pipeline_block_size : 0u;
+    }
+
+    load_governor::statistics synthesizer::get_load_statistics() const noexcept
+    {
+        return _load_governor.get_statistics();
+    }
+
+    void synthesizer::poll_load_governor_actions(const std::function<void(const load_governor::action&)>& callback)
+    {
+        _load_governor.consume_actions(callback);
+    }
+
+    static constexpr uint32_t state_magic = 0x54534d47u;  //  "GMST"
+    static constexpr uint32_t state_version = 1u;
+
+    std::vector<uint8_t> synthesizer::capture_reset_point()
+    {
+        if (_voice_manager.active_voice_count() != 0u)
+            throw std::logic_error("synthesizer::capture_reset_point : a voice is still active");
+
+        //  The node states can not be captured : the rendering must restart from initial states
+        _initialize_node_states();
+
+        state_writer writer{};
+
+        writer.write(state_magic);
+        writer.write(state_version);
+        writer.write<uint32_t>(_input_count);
+        writer.write<uint32_t>(_output_count);
+
+        _voice_manager.save_state(writer);
+        _parameter_manager.save_state(writer);
+
+        writer.write<uint64_t>(_master_silent_sample_count);
+        writer.write<uint8_t>(_master_sleeping ? 1u : 0u);
+        writer.write(_parameter_change_count);
+
+        writer.write<uint8_t>(_pipelined ? 1u : 0u);
+        if (_pipelined) {
+            writer.write_container(_pipeline_polyphonic_buffers);
+            writer.write_container(_pipeline_output);
+            writer.write<uint64_t>(_pipeline_voice_block);
+            writer.write<uint64_t>(_pipeline_read_position);
+        }
+
+        auto reset_point = writer.release();
+        LOG_INFO("[synthesizer] Captured a %zu bytes reset point\n", reset_point.size());
+        return reset_point;
+    }
+
+    void synthesizer::reset(const std::vector<uint8_t>& reset_point)
+    {
+        state_reader reader{reset_point.data(), reset_point.size()};
+
+        if (reader.read<uint32_t>() != state_magic || reader.read<uint32_t>() != state_version)
+            throw std::invalid_argument("synthesizer::reset : not a synthesizer state");
+        if (reader.read<uint32_t>() != _input_count || reader.read<uint32_t>() != _output_count)
+            throw std::invalid_argument("synthesizer::reset : state captured with another channel count");
+
+        _voice_manager.load_state(reader);
+        _parameter_manager.load_state(reader);
+
+        _master_silent_sample_count = static_cast<std::size_t>(reader.read<uint64_t>());
+        _master_sleeping = (reader.read<uint8_t>() != 0u);
+        _parameter_change_count = reader.read<unsigned int>();
+
+        //  The latency must not change
+        if ((reader.read<uint8_t>() != 0u) != _pipelined)
+            throw std::invalid_argument("synthesizer::reset : state captured with another processing mode");
+
+        if (_pipelined) {
+            reader.read_container(_pipeline_polyphonic_buffers, _pipeline_polyphonic_buffers.size());
+            reader.read_container(_pipeline_output, _pipeline_output.size());
+            const auto voice_block = reader.read<uint64_t>();
+            const auto read_position = reader.read<uint64_t>();
+            if (voice_block > 1u || read_position > _pipeline_block_size)
+                throw std::invalid_argument("synthesizer::reset : invalid state");
+            _pipeline_voice_block = static_cast<std::size_t>(voice_block);
+            _pipeline_read_position = static_cast<std::size_t>(read_position);
+        }
+
+        if (!reader.at_end())
+            throw std::invalid_argument("synthesizer::reset : invalid state");
+
+        _initialize_node_states();
+
+        LOG_INFO("[synthesizer] Reset to a %zu bytes reset point\n", reset_point.size());
+    }
+
+    void synthesizer::_initialize_node_states()
+    {
+        //  No voice is active : the free voices are initialized before being used
+        _voice_manager.invalidate_free_voices();
+        _master_circuit_context.initialize_state(0u);
+        _master_branches.initialize_states();
+    }
+
+    synthesizer::calibration_result synthesizer::calibrate_voice_count(float target_load)
+    {
+        //  Measure over a few blocks, after a warm up
+        constexpr auto measure_sample_count = 8192u;
+        calibration_result result{};
+
+        update_program();
+
+        const float master_input[voice_manager::polyphonic_to_master_channel_count] = {0.f};
+        std::vector<float> master_output(_output_count * master_branches::max_block_size);
+        const auto process_master =
+            [&]()
+            {
+                if (_master_branches.active()) {
+                    _polyphonic_buffer.fill(0.f);
+                    for (auto i = 0u; i < measure_sample_count; i += master_branches::max_block_size)
+                        _master_branches.process(master_branches::max_block_size, _polyphonic_buffer.data(), master_output.data());
+                }
+                else {
+                    for (auto i = 0u; i < measure_sample_count; ++i)
+                        _master_circuit_context.process(master_input, master_output.data());
+                }
+            };
+
+        process_master();
+        const auto start = std::chrono::steady_clock::now();
+        process_master();
+        result.master_sample_cost =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start) / measure_sample_count;
+
+        _voice_manager.measure_voice_cost(measure_sample_count);
+        result.voice_sample_cost = _voice_manager.measure_voice_cost(measure_sample_count);
+
+        const auto sample_period = std::chrono::duration<float, std::nano>{1e9f / _sample_rate};
+        const auto available_time = target_load * sample_period - result.master_sample_cost;
+
+        if (result.voice_sample_cost.count() == 0 || available_time.count() <= 0.f) {
+            result.suggested_voice_count = 1u;
+        }
+        else {
+            result.suggested_voice_count =
+                std::max<std::size_t>(1u, static_cast<std::size_t>(available_time / result.voice_sample_cost));
+        }
+
+        LOG_INFO("[synthesizer][calibrate] master : %lld ns/sample, voice : %lld ns/sample, suggested voice count : %zu\n",
+            static_cast<long long>(result.master_sample_cost.count()),
+            static_cast<long long>(result.voice_sample_cost.count()),
+            result.suggested_voice_count);
+
+        return result;
+    }
+
+    void synthesizer::set_master_node_info_provider(master_branches::node_info_provider provider)
+    {
+        _master_branches.set_node_info_provider(std::move(provider));
+    }
+
+    std::size_t synthesizer::get_master_branch_count() const noexcept
+    {
+        return _master_branches.compiled_branch_count();
+    }
+
     std::size_t synthesizer::get_voice_count() const noexcept
     {
         return _polyphonic_circuit_context.get_instance_count();
     }
 
+    void synthesizer::set_voice_memory_cap(std::size_t cap) noexcept
+    {
+        _voice_memory_cap = cap;
+        _update_voice_limit();
+    }
+
+    void synthesizer::set_voice_state_size(std::size_t size) noexcept
+    {
+        _voice_state_size = size;
+        _update_voice_limit();
+    }
+
+    voice_manager::pool_statistics synthesizer::get_voice_pool_statistics() const noexcept
+    {
+        return _voice_manager.get_pool_statistics();
+    }
+
+    voice_manager::initialization_statistics synthesizer::get_voice_initialization_statistics() const noexcept
+    {
+        return _voice_manager.get_initialization_statistics();
+    }
+
+    void synthesizer::_update_voice_limit() noexcept
+    {
+        const auto voice_count = get_voice_count();
+
+        if (_voice_memory_cap == 0u || _voice_state_size == 0u) {
+            _voice_manager.set_voice_limit(voice_count);
+        }
+        else {
+            const auto limit = std::min<std::size_t>(voice_count, _voice_memory_cap / _voice_state_size);
+            LOG_INFO("[synthesizer] Voice memory cap : at most %zu voices can be used\n", std::max<std::size_t>(limit, 1u));
+            _voice_manager.set_voice_limit(limit);
+        }
+    }
+
     void synthesizer::enable_ir_dump(bool enable)
     {
         _master_circuit_context.enable_ir_dump(enable);
+        _master_branches.enable_ir_dump(enable);
         _polyphonic_circuit_context.enable_ir_dump(enable);
     }
 
+    void synthesizer::enable_codegen_report(bool enable) noexcept
+    {
+        _codegen_report_enabled = enable;
+    }
+
     bool synthesizer::update_program() noexcept
     {
+        //  Read before the update : the master program run afterward is at least this recent
+        const auto probe_generation = _probe_manager.compiled_generation();
+
         const auto b1 = _master_circuit_context.update_program();
         const auto b2 = _polyphonic_circuit_context.update_program();
-        return b1 || b2; // use var in order to avoid lazy evaluation side efects
+        const auto b3 = _master_branches.update_program();
+        _probe_manager.set_program_generation(probe_generation);
+
+        //  Free voice states were initialized with the previous program
+        if (b2)
+            _voice_manager.invalidate_free_voices();
+
+        //  The new program may not be silent
+        if (b1 || b2 || b3) {
+            _master_sleeping = false;
+            _master_silent_sample_count = 0u;
+        }
+        return b1 || b2 || b3; // use var in order to avoid lazy evaluation side efects
+    }
+
+    void synthesizer::_compile_circuit(
+        DSPJIT::graph_execution_context& context,
+        DSPJIT::compile_node_class& input, DSPJIT::compile_node_class& output,
+        std::vector<optimization_remark>& remarks)
+    {
+        remarks.clear();
+
+        if (_codegen_report_enabled) {
+            optimization_remark_collector collector{_llvm_context, remarks};
+            context.compile({input}, {output});
+        }
+        else {
+            context.compile({input}, {output});
+        }
     }
 
     void synthesizer::_process_one_sample(const float[], float output[]) noexcept
@@ -220,4 +764,126 @@ namespace Gammou {
         //  Apply master processing
         _master_circuit_context.process(polyphonic_output, output);
     }
+
+    void synthesizer::_process_master_branches(std::size_t sample_count, float outputs[]) noexcept
+    {
+        constexpr auto channel_count = voice_manager::polyphonic_to_master_channel_count;
+
+        //  The voices are processed sample by sample, then the master branches process the whole block.
+        //  The master circuit thus see the parameter values at the end of each block
+        for (auto offset = 0u; offset < sample_count; offset += master_branches::max_block_size) {
+            const auto block_size = std::min<std::size_t>(master_branches::max_block_size, sample_count - offset);
+            _polyphonic_buffer.fill(0.f);
+
+            for (auto i = 0u; i < block_size; ++i) {
+                _parameter_manager.process_one_sample();
+                _voice_manager.process_one_sample(_polyphonic_buffer.data() + i * channel_count);
+            }
+
+            _master_branches.process(block_size, _polyphonic_buffer.data(), outputs + offset * _output_count);
+        }
+    }
+
+    void synthesizer::_process_master_block(std::size_t sample_count, const float polyphonic_buffer[], float outputs[]) noexcept
+    {
+        constexpr auto channel_count = voice_manager::polyphonic_to_master_channel_count;
+
+        if (_master_branches.active()) {
+            for (auto offset = 0u; offset < sample_count; offset += master_branches::max_block_size) {
+                _master_branches.process(
+                    std::min<std::size_t>(master_branches::max_block_size, sample_count - offset),
+                    polyphonic_buffer + offset * channel_count, outputs + offset * _output_count);
+            }
+        }
+        else {
+            for (auto i = 0u; i < sample_count; ++i)
+                _master_circuit_context.process(polyphonic_buffer + i * channel_count, outputs + i * _output_count);
+        }
+    }
+
+    void synthesizer::_process_pipelined(std::size_t sample_count, float outputs[]) noexcept
+    {
+        for (auto offset = 0u; offset < sample_count;) {
+            if (_pipeline_read_position == _pipeline_block_size)
+                _pipeline_step();
+
+            const auto count = std::min(sample_count - offset, _pipeline_block_size - _pipeline_read_position);
+            std::copy_n(
+                _pipeline_output.data() + _pipeline_read_position * _output_count,
+                count * _output_count, outputs + offset * _output_count);
+
+            _pipeline_read_position += count;
+            offset += count;
+        }
+    }
+
+    void synthesizer::_pipeline_step() noexcept
+    {
+        constexpr auto channel_count = voice_manager::polyphonic_to_master_channel_count;
+        const auto block_value_count = _pipeline_block_size * channel_count;
+        auto *voice_block = _pipeline_polyphonic_buffers.data() + _pipeline_voice_block * block_value_count;
+        const auto *master_block = _pipeline_polyphonic_buffers.data() + (1u - _pipeline_voice_block) * block_value_count;
+
+        //  Both programs read the parameter values while the tasks run : they are advanced for the whole block
+        //  before, and are constant during the block
+        for (auto i = 0u; i < _pipeline_block_size; ++i)
+            _parameter_manager.process_one_sample();
+
+        //  Render the voices of the next block while the master circuit processes the previous one
+        auto step =
+            [&](std::size_t task)
+            {
+                scoped_denormals_flush flush{};
+                realtime_scope rt_scope{};
+
+                if (task == 0u) {
+                    std::fill_n(voice_block, block_value_count, 0.f);
+                    for (auto i = 0u; i < _pipeline_block_size; ++i)
+                        _voice_manager.process_one_sample(voice_block + i * channel_count);
+                    _voice_manager.end_block(_pipeline_block_size);
+                }
+                else {
+                    _process_master_block(_pipeline_block_size, master_block, _pipeline_output.data());
+                }
+            };
+
+        _pipeline_pool->run(2u, step);
+        _pipeline_voice_block = 1u - _pipeline_voice_block;
+        _pipeline_read_position = 0u;
+    }
+
+    bool synthesizer::_master_must_wake_up() const noexcept
+    {
+        return
+            _voice_manager.active_voice_count() != 0u ||
+            _parameter_manager.get_change_count() != _parameter_change_count;
+    }
+
+    void synthesizer::_update_master_tail(std::size_t sample_count, const float outputs[]) noexcept
+    {
+        const auto change_count = _parameter_manager.get_change_count();
+
+        //  The master circuit can only be silent for good when it is not fed by any voice
+        if (_master_silence_hold_sample_count == 0u ||
+            _voice_manager.active_voice_count() != 0u ||
+            change_count != _parameter_change_count) {
+            _parameter_change_count = change_count;
+            _master_silent_sample_count = 0u;
+            return;
+        }
+
+        const auto value_count = sample_count * _output_count;
+        auto peak = 0.f;
+        for (auto i = 0u; i < value_count; ++i)
+            peak = std::max(peak, std::abs(outputs[i]));
+
+        if (peak > _master_silence_threshold) {
+            _master_silent_sample_count = 0u;
+        }
+        else {
+            _master_silent_sample_count += sample_count;
+            if (_master_silent_sample_count >= _master_silence_hold_sample_count)
+                _master_sleeping = true;
+        }
+    }
 }
\ No newline at end of file
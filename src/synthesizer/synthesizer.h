@@ -1,13 +1,19 @@
 #ifndef GAMMOU_SYNTHESIZER_H_
 #define GAMMOU_SYNTHESIZER_H_
 
+#include <functional>
 #include <memory>
 
 #include <DSPJIT/compile_node_class.h>
 #include <DSPJIT/graph_execution_context_factory.h>
 
+#include "load_governor.h"
+#include "master_branches.h"
+#include "optimization_remarks.h"
 #include "voice_manager.h"
 #include "parameter_manager.h"
+#include "probe_manager.h"
+#include "utils/task_pool.h"
 
 namespace Gammou
 {
@@ -16,18 +22,97 @@ namespace Gammou
         static constexpr auto _sample_duration_symbol = "_sample_duration";
 
     public:
+        //  Number of parameters that can be exposed to a plugin host for automation
+        static constexpr unsigned int automation_slot_count = 128u;
 
         class circuit_controller
         {
         public:
-            virtual void compile() =0;
+            /**
+             *  \brief Called after each circuit compilation
+             **/
+            using compile_callback = std::function<void(void)>;
+
+            virtual ~circuit_controller() noexcept = default;
+
+            /**
+             *  \brief Compile the circuit, or defer the compilation until the
+             *  current transaction is committed if one was begun
+             */
+            void compile();
+
+            /**
+             *  \brief Begin a compilation transaction: compile requests are deferred
+             *  and coalesced until the matching commit_transaction() call
+             *  \note Transactions can be nested, only the outermost commit compiles
+             */
+            void begin_transaction() noexcept;
+
+            /**
+             *  \brief Commit a compilation transaction. The circuit is compiled once
+             *  if at least one compilation was requested during the transaction
+             */
+            void commit_transaction();
+
             virtual void register_static_memory_chunk(const DSPJIT::compile_node_class& node, std::vector<uint8_t>&& data) =0;
             virtual void free_static_memory_chunk(const DSPJIT::compile_node_class& node) =0;
+
+            /**
+             *  \brief Return the optimization remarks collected during the last compilation
+             *  \note Remarks are only collected when the codegen report is enabled
+             */
+            const auto& get_optimization_remarks() const noexcept { return _optimization_remarks; }
+
+            /**
+             *  \brief Set the callback called each time the circuit was compiled
+             */
+            void set_compile_callback(compile_callback callback);
+
+        protected:
+            virtual void _compile() =0;
+
+            std::vector<optimization_remark> _optimization_remarks{};
+
+        private:
+            void _compile_and_notify();
+
+            compile_callback _compile_callback{};
+            unsigned int _transaction_depth{0u};
+            bool _compile_requested{false};
+        };
+
+        /**
+         *  \class compile_transaction
+         *  \brief Scoped compilation transaction on both master and polyphonic circuits.
+         *  Used to compile each circuit at most once while loading a patch or editing
+         *  several nodes at the same time.
+         *  If the transaction was not committed, it is committed by the destructor,
+         *  which logs the compilation errors as it can not throw them.
+         */
+        class compile_transaction
+        {
+        public:
+            explicit compile_transaction(synthesizer& synth) noexcept;
+            compile_transaction(const compile_transaction&) = delete;
+            compile_transaction(compile_transaction&&) = delete;
+            ~compile_transaction() noexcept;
+
+            /**
+             *  \brief Commit the transaction on both circuits, compiling them if it was requested
+             *  \throw The compilation errors. The transaction is committed on both circuits even then
+             */
+            void commit();
+
+        private:
+            synthesizer& _synthesizer;
+            bool _committed{false};
         };
 
         using opt_level = DSPJIT::graph_execution_context::opt_level;
         using parameter = parameter_manager::parameter;
+        using probe = probe_manager::probe;
         using voice_mode = voice_manager::mode;
+        using steal_policy = voice_manager::steal_policy;
 
         struct configuration
         {
@@ -37,6 +122,27 @@ namespace Gammou
             unsigned int voice_count{256u};
             opt_level optimization_level{opt_level::Aggressive};
             llvm::TargetOptions target_options{};
+            bool use_huge_pages{false};    //<< Back the dsp memory arena with huge pages. It holds the voice, parameter and probe data, not the node states
+            std::size_t voice_memory_cap{0u};   //<< Maximum voice states memory in bytes, 0 for no limit
+            std::size_t voice_preparation_per_block{2u};    //<< Maximum voice states initialized by prepare_voices()
+            std::size_t prepared_voice_count{4u};           //<< Number of free voices kept initialized in advance
+            float voice_silence_threshold{voice_manager::voice_disappearance_treshold_default};
+            float voice_silence_hold{0.45f};                //<< Silence duration (s) before a voice is stopped
+            voice_manager::level_detection voice_level_detection{voice_manager::level_detection::PEAK};
+            float master_silence_threshold{0.00001f};
+            float master_silence_hold{1.f};                 //<< Silence duration (s) before master processing is skipped, 0 to never skip it
+            std::size_t max_voices{0u};                     //<< Maximum number of voices played at the same time, 0 for voice_count
+            steal_policy voice_steal_policy{steal_policy::OLDEST};
+            bool same_note_retrigger{false};
+            float voice_steal_fade{0.005f};                 //<< Fade out duration (s) of the stolen voices
+            bool enable_load_governor{true};
+            std::size_t parameter_capacity{parameter_manager::default_capacity};
+            parameter_manager::smoothing parameter_smoothing{parameter_manager::smoothing::ONE_POLE};
+            std::size_t probe_capacity{probe_manager::default_capacity};
+            load_governor::configuration load_governor_config{};
+            master_branches::configuration master_branches_config{};
+            bool pipelined_processing{false};               //<< Midi events and parameters are then applied per pipeline block
+            std::size_t pipeline_block_size{128u};          //<< Latency added by the pipelined processing, in samples
         };
 
         /**
@@ -93,6 +199,20 @@ namespace Gammou
          */
         circuit_controller& get_polyphonic_circuit_controller() noexcept { return _polyphonic_circuit_controller; }
 
+        /**
+         *  \brief Set the provider of the master circuit nodes properties, used to decide whether the
+         *  master circuit branches are worth being processed in parallel and can be skipped on silence.
+         *  Taken into account at the next master circuit compilation
+         *  \see master_branches
+         */
+        void set_master_node_info_provider(master_branches::node_info_provider provider);
+
+        /**
+         *  \brief Return the number of master circuit branches processed in parallel, 0 if the
+         *  master circuit is processed as a whole
+         */
+        std::size_t get_master_branch_count() const noexcept;
+
         /**
          *  \brief Set the samplerate and recompile circuits
          */
@@ -114,14 +234,140 @@ namespace Gammou
          */
         voice_mode get_voice_mode() const noexcept;
 
+        /**
+         *  \brief Set the maximum number of voices played at the same time.
+         *  When this budget is reached, a playing voice is stolen to play the new note.
+         *  \param max_voices the voice budget, 0 for get_voice_count()
+         */
+        void set_max_voices(std::size_t max_voices) noexcept;
+
+        /**
+         *  \brief Set how a voice is chosen when a note is played and the voice budget is exhausted
+         *  \param same_note_retrigger if true, a note played again reuse the voice already playing it
+         */
+        void set_voice_steal_policy(steal_policy policy, bool same_note_retrigger = false) noexcept;
+
+        /**
+         *  \brief Enable/disable the voice budget reduction when the processing is too slow
+         *  \see load_governor
+         */
+        void enable_load_governor(bool enable = true) noexcept;
+
+        /**
+         *  \brief Enable/disable the pipelined processing : process_buffer renders the voices of the next
+         *  block on a worker thread while the master circuit processes the current one. This nearly doubles
+         *  the available cpu time, at the cost of one block of latency (see get_latency()).
+         *  In this mode, the midi events are applied at pipeline block boundaries (every pipeline_block_size samples),
+         *  and the parameters are advanced before each block : they keep their end of block value during the block,
+         *  both in the voices and in the master circuit.
+         *  \note Must not be called while the sound is processed
+         */
+        void enable_pipelined_processing(bool enable = true);
+
+        /**
+         *  \brief Return true if the pipelined processing is enabled
+         */
+        bool pipelined_processing_enabled() const noexcept { return _pipelined; }
+
+        /**
+         *  \brief Return the latency added by the processing, in samples
+         */
+        std::size_t get_latency() const noexcept;
+
+        /**
+         *  \brief Return the processing load measured by the load governor
+         */
+        load_governor::statistics get_load_statistics() const noexcept;
+
+        /**
+         *  \brief Pass the actions taken by the load governor since the last call to callback.
+         *  \note Must not be called from the sound processing thread
+         */
+        void poll_load_governor_actions(const std::function<void(const load_governor::action&)>& callback);
+
+        struct calibration_result
+        {
+            std::chrono::nanoseconds master_sample_cost{0};     //<< Time needed to compute one master sample
+            std::chrono::nanoseconds voice_sample_cost{0};      //<< Time needed to compute one sample of one voice
+            std::size_t suggested_voice_count{0u};
+        };
+
+        /**
+         *  \brief Measure the cost of the current patch on this machine and suggest a voice count
+         *  \param target_load the fraction of the sample period that the processing may use
+         *  \note Alter the master circuit state : must not be called while the sound is processed
+         */
+        calibration_result calibrate_voice_count(float target_load = 0.7f);
+
+        /**
+         *  \brief Reinitialize the node states and capture the runtime state of the synthesizer in a binary blob :
+         *  voices bookkeeping, parameter settings and smoothed values, master tail detection and pipeline buffers.
+         *  This is a reset point, not a checkpoint : the node states are owned by the execution contexts and
+         *  can not be captured, so they are reinitialized instead, which cuts the tails of the master circuit.
+         *  A blob is only meant to be restored by the same build, on the same machine, with the same patch loaded.
+         *  \throw std::logic_error if a voice is still active
+         *  \note Must not be called while the sound is processed
+         */
+        std::vector<uint8_t> capture_reset_point();
+
+        /**
+         *  \brief Go back to a reset point captured by capture_reset_point(). The node states are reinitialized :
+         *  the rendering after reset() is identical to the rendering after capture_reset_point().
+         *  \throw std::invalid_argument if the blob is invalid or was captured with another configuration.
+         *  The state is unspecified when an exception is thrown.
+         *  \note Must not be called while the sound is processed
+         */
+        void reset(const std::vector<uint8_t>& reset_point);
+
 
         std::size_t get_voice_count() const noexcept;
 
+        /**
+         *  \brief Limit the memory used by the voice states : the number of voices
+         *  that can be used is limited to cap / voice state size.
+         *  \param cap the memory cap in bytes, 0 for no limit
+         *  \see set_voice_state_size
+         */
+        void set_voice_memory_cap(std::size_t cap) noexcept;
+
+        /**
+         *  \brief Set the estimated state size of one voice, used to enforce the voice memory cap
+         */
+        void set_voice_state_size(std::size_t size) noexcept;
+
+        /**
+         *  \brief Return the voice pool usage (peak polyphony, used voices)
+         */
+        voice_manager::pool_statistics get_voice_pool_statistics() const noexcept;
+
+        /**
+         *  \brief Return how voice states were initialized and the worst note on duration
+         */
+        voice_manager::initialization_statistics get_voice_initialization_statistics() const noexcept;
+
+        /**
+         * \brief Return the statistics of the memory arena used by the sound processing
+         */
+        const memory_arena::statistics& get_dsp_memory_statistics() const noexcept;
+
+        /**
+         * \brief Move the memory used by the sound processing to the numa node of the calling thread.
+         * \note Slow : to be called once from the sound processing thread, before processing
+         * \see memory_arena::bind_to_current_numa_node
+         */
+        bool bind_dsp_memory_to_current_thread() noexcept;
+
         /**
          * \brief Enable/disable the IR code dump to logs
          */
         void enable_ir_dump(bool enable = true);
 
+        /**
+         * \brief Enable/disable the optimization remarks collection at each compilation
+         * \see circuit_controller::get_optimization_remarks()
+         */
+        void enable_codegen_report(bool enable = true) noexcept;
+
         /**
          **
          **    Process thread part
@@ -145,7 +391,13 @@ namespace Gammou
             float output[]) noexcept;
 
         /**
-         *  \brief compute N output samples using N input samples
+         *  \brief compute N output samples using N input samples.
+         *  The voices silence is checked over the whole buffer. When no voice is active
+         *  and the master output has decayed, the master circuit is not processed anymore
+         *  and zeros are output until a voice is played, a parameter or the program change.
+         *  When the master circuit is split in branches, they are processed in parallel by blocks
+         *  of master_branches::max_block_size samples.
+         *  \see enable_pipelined_processing
          *  \param sample_count the number of sample to be computed
          *  \param inputs input buffer [ch0, ch1, ..., chN, ch0, ch1, ..., chN, ...]
          *  \param outputs output buffer [ch0, ch1, ..., chN, ch0, ch1, ..., chN, ...]
@@ -156,7 +408,16 @@ namespace Gammou
             float outputs[]) noexcept;
 
         /**
-         *  \brief handle a midi note on event
+         *  \brief Initialize the states of a few free voices, so that note on events
+         *  do not have to do it on the critical path.
+         *  \note Called by process_buffer. Must be called once per block by the
+         *  backends using process_sample.
+         */
+        void prepare_voices() noexcept;
+
+        /**
+         *  \brief handle a midi note on event. A voice is stolen when the voice budget is exhausted,
+         *  the notes which could not be played are counted in get_voice_pool_statistics()
          *  \param note midi note played in [0, 127]
          *  \param velocity midi velocity in [0., 1.]
          */
@@ -183,6 +444,20 @@ namespace Gammou
          */
         parameter allocate_parameter(float initial_value = 0.f);
 
+        /**
+         *  \brief allocate a new probe, used by a probe node to pass a signal to the gui
+         *  \note Probe nodes are only supported in the master circuit, \see probe_manager
+         *  \throw std::length_error if every probe is already allocated
+         */
+        probe allocate_probe();
+
+        /**
+         *  \brief Call the control changed callbacks of the parameters changed since the last call
+         *  (by the gui or by midi control changes). Several changes of a parameter result in one call.
+         *  \note Must be called on the gui thread, typically at frame rate
+         */
+        void dispatch_control_changes();
+
         /**
          *  \brief Assign this parameter to the next midi control whose value change
          *  \param param the parameter to be linked to a midi control
@@ -211,20 +486,71 @@ namespace Gammou
          */
         bool midi_assigned_to_control(uint8_t& control, const parameter& param) const noexcept;
 
+        /**
+         *  \brief Assign a parameter to the first free automation slot. Parameters are assigned
+         *  a slot when they are allocated.
+         *  \return false if every slot is already used
+         */
+        bool automation_assign(const parameter& param) noexcept;
+
+        /**
+         *  \brief Assign a parameter to a given automation slot, used to restore the slots of a patch.
+         *  The parameter previously assigned to this slot, if any, loses it.
+         */
+        void automation_assign_slot(unsigned int slot, const parameter& param) noexcept;
+
+        /**
+         *  \param slot reference used to return the automation slot of the parameter if any
+         *  \return true if the parameter is assigned to an automation slot
+         */
+        bool automation_assigned_to_slot(unsigned int& slot, const parameter& param) const noexcept;
+
+        /**
+         *  \return true if a parameter is assigned to this automation slot
+         */
+        bool automation_slot_used(unsigned int slot) const noexcept;
+
+        /**
+         *  \brief Apply an automation value : the parameter assigned to the slot, if any, ramps
+         *  linearly to the new normalized value during sample_count samples
+         */
+        void automation_set(unsigned int slot, float value, std::size_t sample_count) noexcept;
+
+        /**
+         *  \return the normalized setting of the parameter assigned to the slot, 0 if the slot is unused
+         */
+        float automation_get(unsigned int slot) const noexcept;
+
     private:
         using param_id = parameter_manager::param_id;
 
         void _process_one_sample(const float[], float output[]) noexcept;
+        void _process_master_branches(std::size_t sample_count, float outputs[]) noexcept;
+        void _process_master_block(std::size_t sample_count, const float polyphonic_buffer[], float outputs[]) noexcept;
+        void _process_pipelined(std::size_t sample_count, float outputs[]) noexcept;
+        void _pipeline_step() noexcept;
+        bool _master_must_wake_up() const noexcept;
+        void _update_master_tail(std::size_t sample_count, const float outputs[]) noexcept;
+        void _initialize_node_states();
+        void _update_voice_limit() noexcept;
+        void _automation_disassign(param_id param) noexcept;
+
+        void _compile_circuit(
+            DSPJIT::graph_execution_context& context,
+            DSPJIT::compile_node_class& input, DSPJIT::compile_node_class& output,
+            std::vector<optimization_remark>& remarks);
 
         class master_circuit_controller : public circuit_controller
         {
         public:
             master_circuit_controller(synthesizer&);
 
-            void compile() override;
             void register_static_memory_chunk(const DSPJIT::compile_node_class& node, std::vector<uint8_t>&& data) override;
             void free_static_memory_chunk(const DSPJIT::compile_node_class& node) override;
 
+        protected:
+            void _compile() override;
+
         private:
             synthesizer& _synthesizer;
         };
@@ -234,10 +560,12 @@ namespace Gammou
         public:
             polyphonic_circuit_controller(synthesizer&);
 
-            void compile() override;
             void register_static_memory_chunk(const DSPJIT::compile_node_class& node, std::vector<uint8_t>&& data) override;
             void free_static_memory_chunk(const DSPJIT::compile_node_class& node) override;
 
+        protected:
+            void _compile() override;
+
         private:
             synthesizer& _synthesizer;
         };
@@ -246,6 +574,7 @@ namespace Gammou
         friend class polyphonic_circuit_controler;
 
         llvm::LLVMContext& _llvm_context;
+        bool _codegen_report_enabled{false};
         const unsigned int _input_count;
         const unsigned int _output_count;
 
@@ -253,6 +582,19 @@ namespace Gammou
         DSPJIT::graph_execution_context _master_circuit_context;
         DSPJIT::graph_execution_context _polyphonic_circuit_context;
 
+        //  Master circuit branches processed in parallel by process_buffer
+        master_branches _master_branches;
+        std::array<float, master_branches::max_block_size * voice_manager::polyphonic_to_master_channel_count> _polyphonic_buffer;
+
+        //  Pipelined processing : the voices render a block while the master circuit processes the previous one
+        std::unique_ptr<task_pool> _pipeline_pool{};
+        bool _pipelined{false};
+        const std::size_t _pipeline_block_size;
+        std::vector<float> _pipeline_polyphonic_buffers;    //<< Two blocks : rendered by the voices, read by the master circuit
+        std::vector<float> _pipeline_output;
+        std::size_t _pipeline_voice_block{0u};               //<< Index of the block rendered by the voices
+        std::size_t _pipeline_read_position{0u};
+
         //  Master circuit internal nodes
         DSPJIT::compile_node_class _from_polyphonic;
         DSPJIT::compile_node_class _output;
@@ -265,14 +607,41 @@ namespace Gammou
         master_circuit_controller _master_circuit_controller;
         polyphonic_circuit_controller _polyphonic_circuit_controller;
 
+        //  Memory used by the sound processing, pre-faulted at construction
+        memory_arena _dsp_memory;
+
         //  Voice management
         voice_manager _voice_manager;
+        std::size_t _voice_memory_cap;
+        std::size_t _voice_state_size{0u};
+        std::size_t _voice_preparation_per_block;
+        std::size_t _prepared_voice_count;
+        float _voice_silence_threshold;
+        float _voice_silence_hold;
+        voice_manager::level_detection _voice_level_detection;
+        float _voice_steal_fade;
+        float _sample_rate;
+
+        //  Voice budget adjustment under overload
+        load_governor _load_governor;
+
+        //  Master tail detection
+        float _master_silence_threshold;
+        float _master_silence_hold;
+        std::size_t _master_silence_hold_sample_count{0u};
+        std::size_t _master_silent_sample_count{0u};
+        bool _master_sleeping{false};
+        unsigned int _parameter_change_count{0u};
 
         //  Parameter management
         parameter_manager _parameter_manager;
         std::array<param_id, 256u> _midi_learn_map;
         bool _midi_learning{false};
         param_id _learning_param;
+        std::array<param_id, automation_slot_count> _automation_map;
+
+        //  Signal probes
+        probe_manager _probe_manager;
     };
 
 } // namespace Gammou
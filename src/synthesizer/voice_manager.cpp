@@ -1,7 +1,9 @@
 
+#include <algorithm>
 #include <DSPJIT/log.h>
 
 #include "voice_manager.h"
+#include "utils/rt_log.h"
 
 namespace Gammou
 {
@@ -20,9 +22,20 @@ namespace Gammou
 
     voice_manager::voice_manager(
         std::size_t voice_count,
-        DSPJIT::graph_execution_context& polyphonic_context)
-    :   _voice_lifetime(voice_count, 0u),
-        _midi_input_values(voice_count * midi_input_count, 0.f),
+        DSPJIT::graph_execution_context& polyphonic_context,
+        memory_arena& arena)
+    :   _midi_input_values(voice_count * midi_input_count, 0.f, arena_allocator<float>{arena}),
+        _voice_peak(voice_count, 0.f, arena_allocator<float>{arena}),
+        _voice_energy(voice_count, 0.f, arena_allocator<float>{arena}),
+        _voice_level(voice_count, 0.f, arena_allocator<float>{arena}),
+        _voice_lifetime(voice_count, 0u, arena_allocator<unsigned int>{arena}),
+        _voice_state_dirty(voice_count, 1u, arena_allocator<uint8_t>{arena}),
+        _voice_gain(voice_count, 1.f, arena_allocator<float>{arena}),
+        _voice_fade_step(voice_count, 0.f, arena_allocator<float>{arena}),
+        _voice_start_order(voice_count, 0u, arena_allocator<uint32_t>{arena}),
+        _max_voices{voice_count},
+        _voices(arena_allocator<voice_store::value_type>{arena}),
+        _voice_limit{voice_count},
         _polyphonic_context{polyphonic_context}
     {
         _voices.reserve(voice_count);
@@ -30,8 +43,201 @@ namespace Gammou
             _voices.emplace_back(0u, i);
         _on_voice_end = _voices.begin();
         _active_voices_end = _voices.begin();
+        _pool_end = _voices.begin();
+        _note_voice_index.fill(no_voice_index);
     }
 
+    std::size_t voice_manager::memory_requirement(std::size_t voice_count) noexcept
+    {
+        //  Each array is cache line aligned in the arena
+        return
+            voice_count * midi_input_count * sizeof(float) +
+            5u * voice_count * sizeof(float) +
+            voice_count * sizeof(unsigned int) +
+            voice_count * sizeof(uint8_t) +
+            voice_count * sizeof(uint32_t) +
+            voice_count * sizeof(voice_store::value_type) +
+            10u * memory_arena::cache_line_size;
+    }
+
+    void voice_manager::set_voice_limit(std::size_t limit) noexcept
+    {
+        _voice_limit = std::clamp<std::size_t>(limit, 1u, _voices.size());
+    }
+
+    void voice_manager::set_max_voices(std::size_t max_voices) noexcept
+    {
+        _max_voices = std::clamp<std::size_t>(max_voices, 1u, _voices.size());
+    }
+
+    void voice_manager::set_steal_policy(steal_policy policy, bool same_note_retrigger) noexcept
+    {
+        _steal_policy = policy;
+        _same_note_retrigger = same_note_retrigger;
+    }
+
+    void voice_manager::set_steal_fade(unsigned int fade_sample_count) noexcept
+    {
+        _steal_fade_sample_count = fade_sample_count;
+    }
+
+    voice_manager::pool_statistics voice_manager::get_pool_statistics() const noexcept
+    {
+        voice_store::const_iterator begin = _voices.begin();
+        return {
+            _voices.size(),
+            static_cast<std::size_t>(std::distance(begin, voice_store::const_iterator{_pool_end})),
+            static_cast<std::size_t>(std::distance(begin, voice_store::const_iterator{_active_voices_end})),
+            _peak_active_count,
+            _prepared_voice_count,
+            _stolen_count,
+            _dropped_count
+        };
+    }
+
+    voice_manager::initialization_statistics voice_manager::get_initialization_statistics() const noexcept
+    {
+        return _initialization_statistics;
+    }
+
+    void voice_manager::prepare_free_voices(std::size_t max_count, std::size_t prepared_target) noexcept
+    {
+        //  Clean the voices which were stopped, the next allocated ones first
+        for (auto it = _active_voices_end; it != _pool_end && max_count != 0u; ++it) {
+            const auto voice = it->second;
+            if (_voice_state_dirty[voice]) {
+                _initialize_voice_state(voice);
+                _prepared_voice_count++;
+                _initialization_statistics.background_count++;
+                max_count--;
+            }
+        }
+
+        //  Grow the pool in advance so that a polyphony increase does not initialize on note on
+        while (max_count != 0u && _prepared_voice_count < prepared_target && _pool_end != _voices.end() &&
+            static_cast<std::size_t>(std::distance(_voices.begin(), _pool_end)) < _voice_limit.load()) {
+            _initialize_voice_state((_pool_end++)->second);
+            _prepared_voice_count++;
+            _initialization_statistics.background_count++;
+            max_count--;
+        }
+    }
+
+    void voice_manager::invalidate_free_voices() noexcept
+    {
+        for (auto it = _active_voices_end; it != _pool_end; ++it)
+            _voice_state_dirty[it->second] = 1u;
+        _prepared_voice_count = 0u;
+    }
+
+    void voice_manager::save_state(state_writer& writer) const
+    {
+        voice_store::const_iterator begin = _voices.begin();
+        const auto offset_of =
+            [begin](voice_store::const_iterator it)
+            {
+                return static_cast<uint32_t>(std::distance(begin, it));
+            };
+
+        writer.write<uint32_t>(static_cast<uint32_t>(_voices.size()));
+        writer.write(_mode);
+        writer.write(_note_on_count);
+        writer.write<uint64_t>(_fading_voice_count);
+        writer.write<uint64_t>(_stolen_count);
+        writer.write<uint64_t>(_dropped_count);
+        writer.write<uint64_t>(_peak_active_count);
+        writer.write(_note_voice_index);
+
+        //  std::pair is not trivially copyable
+        for (const auto& [n, v] : _voices) {
+            writer.write(n);
+            writer.write(v);
+        }
+        writer.write(offset_of(_on_voice_end));
+        writer.write(offset_of(_active_voices_end));
+        writer.write(offset_of(_pool_end));
+
+        writer.write_container(_midi_input_values);
+        writer.write_container(_voice_peak);
+        writer.write_container(_voice_energy);
+        writer.write_container(_voice_level);
+        writer.write_container(_voice_lifetime);
+        writer.write_container(_voice_gain);
+        writer.write_container(_voice_fade_step);
+        writer.write_container(_voice_start_order);
+    }
+
+    void voice_manager::load_state(state_reader& reader)
+    {
+        const auto voice_count = _voices.size();
+        if (reader.read<uint32_t>() != voice_count)
+            throw std::invalid_argument("voice_manager : state saved with another voice count");
+
+        //  Read everything before modifying the voice manager, so that an invalid state leaves it untouched
+        const auto voice_mode = reader.read<mode>();
+        const auto note_on_count = reader.read<uint32_t>();
+        const auto fading_voice_count = reader.read<uint64_t>();
+        const auto stolen_count = reader.read<uint64_t>();
+        const auto dropped_count = reader.read<uint64_t>();
+        const auto peak_active_count = reader.read<uint64_t>();
+        const auto note_voice_index = reader.read<std::array<uint32_t, 128u>>();
+
+        std::vector<voice_store::value_type> voices(voice_count);
+        for (auto& [n, v] : voices) {
+            n = reader.read<note>();
+            v = reader.read<voice>();
+        }
+        const auto on_voice_end = reader.read<uint32_t>();
+        const auto active_voices_end = reader.read<uint32_t>();
+        const auto pool_end = reader.read<uint32_t>();
+
+        if (!(on_voice_end == 0u && active_voices_end == 0u && pool_end <= voice_count) || fading_voice_count != 0u ||
+            (voice_mode != mode::POLYPHONIC && voice_mode != mode::LEGATO))
+            throw std::invalid_argument("voice_manager : invalid state");
+
+        std::vector<uint8_t> seen(voice_count, 0u);
+        for (const auto& [n, v] : voices) {
+            if (v >= voice_count || seen[v]++ != 0u || n >= note_voice_index.size())
+                throw std::invalid_argument("voice_manager : invalid state");
+        }
+
+        for (const auto index : note_voice_index) {
+            if (index != no_voice_index)
+                throw std::invalid_argument("voice_manager : invalid state");
+        }
+
+        reader.read_container(_midi_input_values, _midi_input_values.size());
+        reader.read_container(_voice_peak, voice_count);
+        reader.read_container(_voice_energy, voice_count);
+        reader.read_container(_voice_level, voice_count);
+        reader.read_container(_voice_lifetime, voice_count);
+        reader.read_container(_voice_gain, voice_count);
+        reader.read_container(_voice_fade_step, voice_count);
+        reader.read_container(_voice_start_order, voice_count);
+
+        _mode = voice_mode;
+        _note_on_count = note_on_count;
+        _fading_voice_count = static_cast<std::size_t>(fading_voice_count);
+        _stolen_count = static_cast<std::size_t>(stolen_count);
+        _dropped_count = static_cast<std::size_t>(dropped_count);
+        _peak_active_count = static_cast<std::size_t>(peak_active_count);
+        _note_voice_index = note_voice_index;
+
+        std::copy(voices.begin(), voices.end(), _voices.begin());
+        _on_voice_end = _voices.begin() + on_voice_end;
+        _active_voices_end = _voices.begin() + active_voices_end;
+        _pool_end = _voices.begin() + pool_end;
+
+        //  The node states are owned by the execution context and can not be restored
+        invalidate_free_voices();
+    }
+
+    void voice_manager::set_silence_detection(float threshold, unsigned int hold_sample_count, level_detection detection) noexcept
+    {
+        _voice_disappearance_treshold = threshold;
+        _voice_disappearance_sample_count = std::max(hold_sample_count, 1u);
+        _level_detection = detection;
+    }
 
     void voice_manager::set_voice_mode(mode m)
     {
@@ -48,17 +254,20 @@ namespace Gammou
         if (_mode == mode::LEGATO) {
             auto it = _find_on_voice();
             if (it != _on_voice_end) {
-                it->first = n;
+                _set_on_voice_note(it, n);
                 _setup_voice(it->second, n, velocity);
                 return true;
             }
             // else : no voice are on : allocate a voice
         }
 
-        if (_allocate_voice(n, velocity))
-            return true;
-        else
-            return false;
+        const auto start = std::chrono::steady_clock::now();
+        const auto allocated = _retrigger_voice(n, velocity) || _allocate_voice(n, velocity);
+        const auto duration = std::chrono::steady_clock::now() - start;
+
+        _initialization_statistics.max_note_on_duration =
+            std::max<std::chrono::nanoseconds>(_initialization_statistics.max_note_on_duration, duration);
+        return allocated;
     }
 
     bool voice_manager::note_off(note n)
@@ -75,12 +284,151 @@ namespace Gammou
         }
     }
 
+    bool voice_manager::_has_free_voice() const noexcept
+    {
+        return _active_voices_end != _pool_end ||
+            (_pool_end != _voices.end() &&
+             static_cast<std::size_t>(std::distance(voice_store::const_iterator{_voices.begin()}, voice_store::const_iterator{_pool_end})) < _voice_limit.load());
+    }
+
+    void voice_manager::release_voices(std::size_t max_voices) noexcept
+    {
+        while (_sounding_voice_count() > max_voices) {
+            if (!_steal_voice(steal_policy::QUIETEST, false))
+                break;
+        }
+    }
+
+    std::chrono::nanoseconds voice_manager::measure_voice_cost(std::size_t sample_count)
+    {
+        if (!_has_free_voice() || sample_count == 0u)
+            return std::chrono::nanoseconds{0};
+
+        if (_active_voices_end == _pool_end)
+            _pool_end++;
+
+        //  Play a note on the next free voice without activating it
+        const auto voice = _active_voices_end->second;
+        const auto midi_input = _get_voice_midi_input(voice);
+        float output[polyphonic_to_master_channel_count];
+
+        //  The voice state will be dirty after the measure
+        if (!_voice_state_dirty[voice])
+            _prepared_voice_count--;
+        _setup_voice(voice, 69u, 1.f);
+        _initialize_voice_state(voice);
+
+        const auto start = std::chrono::steady_clock::now();
+        for (auto i = 0u; i < sample_count; ++i)
+            _polyphonic_context.process(voice, midi_input, output);
+        const auto duration = std::chrono::steady_clock::now() - start;
+
+        midi_input[gate] = 0.f;
+        _voice_state_dirty[voice] = 1u;
+
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(duration) / sample_count;
+    }
+
+    std::size_t voice_manager::_sounding_voice_count() const noexcept
+    {
+        return active_voice_count() - _fading_voice_count;
+    }
+
+    bool voice_manager::_steal_voice(steal_policy policy, bool voice_needed) noexcept
+    {
+        auto victim = _select_victim(policy);
+        if (victim == _active_voices_end)
+            return false;
+
+        const auto voice = victim->second;
+
+        if (victim < _on_voice_end) {
+            _get_voice_midi_input(voice)[gate] = 0.f;
+            _voice_off(victim);
+            victim = _on_voice_end;
+        }
+
+        _stolen_count++;
+
+        if (_steal_fade_sample_count == 0u || (voice_needed && !_has_free_voice())) {
+            //  The new note needs this voice right now : no fade
+            _voice_stop(victim);
+        }
+        else {
+            //  The voice keeps being processed while fading out, \see end_block
+            _voice_gain[voice] = 1.f;
+            _voice_fade_step[voice] = 1.f / static_cast<float>(_steal_fade_sample_count);
+            _fading_voice_count++;
+        }
+
+        return true;
+    }
+
+    voice_manager::voice_store::iterator voice_manager::_select_victim(steal_policy policy) noexcept
+    {
+        auto victim = _active_voices_end;
+
+        switch (policy) {
+
+            case steal_policy::OLDEST:
+            {
+                //  Released voices are stolen first
+                uint32_t max_age = 0u;
+                for (auto it = _on_voice_end; it != _active_voices_end; ++it) {
+                    const auto age = _note_on_count - _voice_start_order[it->second];
+                    if (_voice_fade_step[it->second] == 0.f && (victim == _active_voices_end || age > max_age)) {
+                        victim = it;
+                        max_age = age;
+                    }
+                }
+
+                if (victim == _active_voices_end) {
+                    for (auto it = _voices.begin(); it != _on_voice_end; ++it) {
+                        const auto age = _note_on_count - _voice_start_order[it->second];
+                        if (victim == _active_voices_end || age > max_age) {
+                            victim = it;
+                            max_age = age;
+                        }
+                    }
+                }
+            }
+            break;
+
+            case steal_policy::QUIETEST:
+            {
+                auto min_level = 0.f;
+                for (auto it = _voices.begin(); it != _active_voices_end; ++it) {
+                    const auto level = _voice_level[it->second];
+                    if (_voice_fade_step[it->second] == 0.f && (victim == _active_voices_end || level < min_level)) {
+                        victim = it;
+                        min_level = level;
+                    }
+                }
+            }
+            break;
+
+            case steal_policy::NONE:
+            break;
+        }
+
+        return victim;
+    }
+
+    voice_manager::voice_store::iterator voice_manager::_find_released_voice(note n) noexcept
+    {
+        for (auto it = _on_voice_end; it != _active_voices_end; ++it) {
+            if (it->first == n && _voice_fade_step[it->second] == 0.f)
+                return it;
+        }
+        return _active_voices_end;
+    }
+
     void voice_manager::process_one_sample(float output[])
     {
         for (auto i = 0u; i < polyphonic_to_master_channel_count; ++i)
             output[i] = 0.f;
 
-        for (auto it = _voices.begin(); it != _active_voices_end;) {
+        for (auto it = _voices.begin(); it != _active_voices_end; ++it) {
             const auto voice = it->second;
 
             // Compute voice output
@@ -92,24 +440,68 @@ namespace Gammou
                 _get_voice_midi_input(it->second),
                 out_tmp);
 
-            //  add
-            for (auto i = 0u; i < polyphonic_to_master_channel_count; ++i)
+            //  fade out the stolen voices
+            const auto fade_step = _voice_fade_step[voice];
+            if (fade_step != 0.f) {
+                const auto gain = _voice_gain[voice];
+                for (auto i = 0u; i < polyphonic_to_master_channel_count; ++i)
+                    out_tmp[i] *= gain;
+                _voice_gain[voice] = std::max(0.f, gain - fade_step);
+            }
+
+            //  add and accumulate the voice level, checked at the end of the block
+            auto peak = _voice_peak[voice];
+            auto energy = _voice_energy[voice];
+            for (auto i = 0u; i < polyphonic_to_master_channel_count; ++i) {
                 output[i] += out_tmp[i];
+                peak = std::max(peak, std::abs(out_tmp[i]));
+                energy += out_tmp[i] * out_tmp[i];
+            }
+            _voice_peak[voice] = peak;
+            _voice_energy[voice] = energy;
+        }
+    }
 
-            //  voice disappearance detection
-            auto max_voice_value =
-                *std::max_element(
-                    out_tmp, out_tmp + polyphonic_to_master_channel_count,
-                    [](const auto& s1, const auto& s2) { return std::abs(s1) < std::abs(s2); });
+    void voice_manager::end_block(std::size_t sample_count) noexcept
+    {
+        if (sample_count == 0u)
+            return;
 
-            if (std::abs(max_voice_value) <= _voice_disappearance_treshold) {
-                if (0u == --_voice_lifetime[voice]) {
-                    LOG_DEBUG("[synthesizer][process one sample] Shut down voice %u\n", voice);
-                    if (it < _on_voice_end)
+        //  Compare squared levels to avoid a square root per voice
+        const auto threshold = _voice_disappearance_treshold;
+        const auto energy_threshold =
+            threshold * threshold * static_cast<float>(sample_count * polyphonic_to_master_channel_count);
+
+        for (auto it = _voices.begin(); it != _active_voices_end;) {
+            const auto voice = it->second;
+            const auto silent = (_level_detection == level_detection::PEAK) ?
+                _voice_peak[voice] <= threshold :
+                _voice_energy[voice] <= energy_threshold;
+
+            _voice_level[voice] = _voice_peak[voice];
+            _voice_peak[voice] = 0.f;
+            _voice_energy[voice] = 0.f;
+
+            //  Stolen voices are stopped as soon as they are faded out
+            if (_voice_fade_step[voice] != 0.f && _voice_gain[voice] == 0.f) {
+                _voice_stop(it);
+                continue;
+            }
+
+            if (silent) {
+                if (_voice_lifetime[voice] <= sample_count) {
+                    RT_LOG_DEBUG("[voice manager][end block] Shut down voice %u\n", voice);
+                    if (it < _on_voice_end) {
+                        //  The voice is moved at the end of the on voices before being stopped
                         _voice_off(it);
-                    _voice_stop(it);
+                        _voice_stop(_on_voice_end);
+                    }
+                    else {
+                        _voice_stop(it);
+                    }
                     continue;
                 }
+                _voice_lifetime[voice] -= static_cast<unsigned int>(sample_count);
             }
             else {
                 _voice_lifetime[voice] = _voice_disappearance_sample_count;
@@ -119,21 +511,83 @@ namespace Gammou
         }
     }
 
+    bool voice_manager::_retrigger_voice(note n, float velocity)
+    {
+        auto it = _find_note_on_voice(n);
+
+        if (it != _on_voice_end) {
+            if (_same_note_retrigger) {
+                _setup_voice(it->second, n, velocity);
+                return true;
+            }
+            else {
+                //  A note can not be on twice : release the voice which is already playing it
+                _get_voice_midi_input(it->second)[gate] = 0.f;
+                _voice_off(it);
+                return false;
+            }
+        }
+        else if (_same_note_retrigger) {
+            it = _find_released_voice(n);
+            if (it != _active_voices_end) {
+                //  Put the released voice back in the on voices
+                std::iter_swap(it, _on_voice_end);
+                it = _on_voice_end++;
+                _set_on_voice_note(it, n);
+                _setup_voice(it->second, n, velocity);
+                _voice_start_order[it->second] = _note_on_count++;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     bool voice_manager::_allocate_voice(note n, float velocity)
     {
-        //  if there is a free voice
-        if (_active_voices_end != _voices.end()) {
+        //  Keep the polyphony under the budget
+        if (_sounding_voice_count() >= _max_voices.load() || !_has_free_voice()) {
+            if (!_steal_voice(_steal_policy, true)) {
+                _dropped_count++;
+                return false;
+            }
+        }
+
+        //  if the pool is empty, grow it with a never used voice if the limit allows it
+        if (_active_voices_end == _pool_end && _pool_end != _voices.end() &&
+            static_cast<std::size_t>(std::distance(_voices.begin(), _pool_end)) < _voice_limit.load())
+            _pool_end++;
+
+        //  if there is a free voice in the pool
+        if (_active_voices_end != _pool_end) {
+            //  Prefer a voice which was already initialized by prepare_free_voices
+            const auto prepared_it = _find_prepared_voice();
+            if (prepared_it != _pool_end)
+                std::iter_swap(prepared_it, _active_voices_end);
+
             const auto free_it = _active_voices_end;
             const auto voice = free_it->second;
 
             // Initialize the voice when it is not active
             _setup_voice(voice, n, velocity);
-            _polyphonic_context.initialize_state(voice);
+            if (_voice_state_dirty[voice]) {
+                _initialize_voice_state(voice);
+                _initialization_statistics.note_on_count++;
+            }
+            else {
+                _prepared_voice_count--;
+            }
+            //  The voice state will be altered by processing
+            _voice_state_dirty[voice] = 1u;
 
             _active_voices_end++;
             auto allocated_place_it = _on_voice_end++;
             std::iter_swap(free_it, allocated_place_it);
-            allocated_place_it->first = n;
+            _set_on_voice_note(allocated_place_it, n);
+            _voice_start_order[voice] = _note_on_count++;
+
+            _peak_active_count = std::max<std::size_t>(
+                _peak_active_count, std::distance(_voices.begin(), _active_voices_end));
             return true;
         }
         else {
@@ -148,25 +602,59 @@ namespace Gammou
         midi_input[pitch] = note_frequencies[n];
         midi_input[attack] = velocity;
         _voice_lifetime[v] = _voice_disappearance_sample_count;
+        _voice_peak[v] = 0.f;
+        _voice_energy[v] = 0.f;
+        _voice_level[v] = 0.f;
+    }
+
+    void voice_manager::_initialize_voice_state(voice v)
+    {
+        _polyphonic_context.initialize_state(v);
+        _voice_state_dirty[v] = 0u;
+    }
+
+    voice_manager::voice_store::iterator voice_manager::_find_prepared_voice()
+    {
+        if (_prepared_voice_count == 0u)
+            return _pool_end;
+
+        for (auto it = _active_voices_end; it != _pool_end; ++it) {
+            if (!_voice_state_dirty[it->second])
+                return it;
+        }
+        return _pool_end;
     }
 
     void voice_manager::_voice_off(voice_store::iterator it)
     {
+        _note_voice_index[it->first] = no_voice_index;
         std::iter_swap(it, --_on_voice_end);
+
+        //  Another on voice was moved at this place
+        if (it != _on_voice_end)
+            _note_voice_index[it->first] = _index_of(it);
     }
 
     void voice_manager::_voice_stop(voice_store::iterator it)
     {
+        const auto voice = it->second;
+        if (_voice_fade_step[voice] != 0.f) {
+            _voice_fade_step[voice] = 0.f;
+            _voice_gain[voice] = 1.f;
+            _fading_voice_count--;
+        }
+
+        //  Return the voice to the pool : it will be the next allocated voice
         std::iter_swap(it, --_active_voices_end);
     }
 
     voice_manager::voice_store::iterator voice_manager::_find_note_on_voice(note n)
     {
-        for (auto it = _voices.begin(); it != _on_voice_end; ++it) {
-            if (it->first == n)
-                return it;
-        }
-        return _on_voice_end;
+        const auto index = _note_voice_index[n];
+        if (index == no_voice_index)
+            return _on_voice_end;
+        else
+            return _voices.begin() + index;
     }
 
     voice_manager::voice_store::iterator voice_manager::_find_on_voice()
@@ -176,4 +664,12 @@ namespace Gammou
         else
             return _on_voice_end;
     }
+
+    void voice_manager::_set_on_voice_note(voice_store::iterator it, note n) noexcept
+    {
+        if (_note_voice_index[it->first] == _index_of(it))
+            _note_voice_index[it->first] = no_voice_index;
+        it->first = n;
+        _note_voice_index[n] = _index_of(it);
+    }
 }
\ No newline at end of file
@@ -1,18 +1,26 @@
 #ifndef GAMMOU_VOICE_MANAGER_H_
 #define GAMMOU_VOICE_MANAGER_H_
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <limits>
 #include <numeric>
 #include <unordered_map>
 #include <vector>
 
 #include <DSPJIT/graph_execution_context.h>
 
+#include "utils/memory_arena.h"
+#include "utils/state_blob.h"
+
 namespace Gammou
 {
     class voice_manager
     {
     public:
         static constexpr auto voice_disappearance_treshold_default = 0.0003f;
+        static constexpr auto voice_disappearance_sample_count_default = 20000u;
         static constexpr auto polyphonic_to_master_channel_count = 2u;
 
         /**
@@ -32,13 +40,144 @@ namespace Gammou
             LEGATO
         };
 
+        /**
+         *  \enum level_detection How the voice output level is measured over a block
+         */
+        enum class level_detection
+        {
+            PEAK,
+            RMS
+        };
+
+        /**
+         *  \enum steal_policy How a voice is chosen to play a new note when the voice budget is exhausted
+         */
+        enum class steal_policy
+        {
+            NONE,       /** Drop the new note **/
+            OLDEST,     /** Steal the oldest released voice, or the oldest held voice if none are released **/
+            QUIETEST    /** Steal the voice whose output was the quietest during the last block **/
+        };
+
         using note = uint8_t;
         using voice = uint32_t;
-        using voice_store = std::vector<std::pair<note, voice>>;
+        using voice_store = std::vector<std::pair<note, voice>, arena_allocator<std::pair<note, voice>>>;
 
+        /**
+         *  \param voice_count the maximum number of voice that can be played at the same time
+         *  \param polyphonic_context the context used to process the voices
+         *  \param arena the memory used to store the voices data, \see memory_requirement
+         */
         voice_manager(
             std::size_t voice_count,
-            DSPJIT::graph_execution_context& polyphonic_context);
+            DSPJIT::graph_execution_context& polyphonic_context,
+            memory_arena& arena);
+
+        /**
+         *  \brief Return the arena memory needed by a voice manager handling voice_count voices
+         */
+        static std::size_t memory_requirement(std::size_t voice_count) noexcept;
+
+        /**
+         *  \brief Voice pool usage
+         */
+        struct pool_statistics
+        {
+            std::size_t capacity{0u};       //<< Maximum number of voices (voice_count)
+            std::size_t pool_size{0u};      //<< Number of voices that were used at least once
+            std::size_t active_count{0u};   //<< Number of voices currently processed
+            std::size_t peak_count{0u};     //<< Maximum number of voices processed at the same time
+            std::size_t prepared_count{0u}; //<< Number of free voices whose state is already initialized
+            std::size_t stolen_count{0u};   //<< Number of voices stolen to play a new note
+            std::size_t dropped_count{0u};  //<< Number of notes which could not be played
+        };
+
+        /**
+         *  \brief Voice state initialization counters
+         */
+        struct initialization_statistics
+        {
+            std::size_t background_count{0u};       //<< Voice states initialized by prepare_free_voices
+            std::size_t note_on_count{0u};          //<< Voice states that had to be initialized by a note on
+            std::chrono::nanoseconds max_note_on_duration{0};   //<< Worst note on duration
+        };
+
+        /**
+         *  \brief Limit the number of distinct voices that can be used, in [1, voice_count].
+         *  The voice pool grows on demand until this limit is reached.
+         *  \note Can be called concurrently with the note events and processing
+         */
+        void set_voice_limit(std::size_t limit) noexcept;
+
+        /**
+         *  \brief Set the maximum number of voices played at the same time, in [1, voice_count].
+         *  When this budget is reached, a voice is stolen according to the steal policy.
+         *  \note Can be called concurrently with the note events and processing
+         */
+        void set_max_voices(std::size_t max_voices) noexcept;
+
+        /**
+         *  \param policy how the stolen voice is chosen
+         *  \param same_note_retrigger if true, a note played again reuse the voice that is already playing it
+         */
+        void set_steal_policy(steal_policy policy, bool same_note_retrigger) noexcept;
+
+        /**
+         *  \brief Set the duration of the fade out applied on the stolen voices
+         */
+        void set_steal_fade(unsigned int fade_sample_count) noexcept;
+
+        /**
+         *  \brief Fade out the quietest voices until at most max_voices voices are sounding
+         *  \note Must be called on the processing thread, between two samples
+         */
+        void release_voices(std::size_t max_voices) noexcept;
+
+        /**
+         *  \brief Measure the average time needed to process one sample of one voice,
+         *  playing a note on a free voice during sample_count samples.
+         *  \note Must not be called while the voices are processed
+         *  \return the time per sample, or 0 if no voice was free
+         */
+        std::chrono::nanoseconds measure_voice_cost(std::size_t sample_count);
+
+        pool_statistics get_pool_statistics() const noexcept;
+        initialization_statistics get_initialization_statistics() const noexcept;
+
+        /**
+         *  \brief Initialize the state of at most max_count free voices, so that
+         *  the following note on do not have to do it.
+         *  The pool is also grown in advance, under the voice limit, until
+         *  prepared_target voices are ready.
+         *  \note Must be called on the processing thread, between two samples
+         */
+        void prepare_free_voices(std::size_t max_count, std::size_t prepared_target) noexcept;
+
+        /**
+         *  \brief Mark every free voice state as needing an initialization.
+         *  Must be called when the polyphonic program was changed.
+         */
+        void invalidate_free_voices() noexcept;
+
+        /**
+         *  \brief Write the voices bookkeeping : notes, pool layout and per voice levels and fades
+         *  \note The node states are not written : it is only used when no voice is active
+         */
+        void save_state(state_writer& writer) const;
+
+        /**
+         *  \brief Restore the voices bookkeeping written by save_state, the free voices are invalidated.
+         *  \throw std::invalid_argument if the state is truncated or was saved with another voice count
+         *  \note Must not be called while the voices are processed
+         */
+        void load_state(state_reader& reader);
+
+        /**
+         *  \brief Configure the silent voices detection : a voice is stopped when its
+         *  output level stayed under threshold during hold_sample_count samples.
+         *  \note The level is measured over each processed block, \see end_block
+         */
+        void set_silence_detection(float threshold, unsigned int hold_sample_count, level_detection detection) noexcept;
 
         void set_voice_mode(mode);
         voice_manager::mode get_voice_mode() const noexcept;
@@ -46,13 +185,41 @@ namespace Gammou
         bool note_off(note);
         void process_one_sample(float output[]);
 
+        /**
+         *  \brief Measure the voices output level over the last sample_count processed samples,
+         *  and stop the voices which have been silent for long enough.
+         */
+        void end_block(std::size_t sample_count) noexcept;
+
+        std::size_t active_voice_count() const noexcept
+        {
+            return static_cast<std::size_t>(std::distance(
+                voice_store::const_iterator{_voices.begin()}, voice_store::const_iterator{_active_voices_end}));
+        }
+
     private:
+        static constexpr auto no_voice_index = std::numeric_limits<uint32_t>::max();
+
+        bool _retrigger_voice(note n, float velocity);
         bool _allocate_voice(note n, float velocity);
+        bool _has_free_voice() const noexcept;
+        bool _steal_voice(steal_policy policy, bool voice_needed) noexcept;
+        voice_store::iterator _select_victim(steal_policy policy) noexcept;
+        std::size_t _sounding_voice_count() const noexcept;
+        voice_store::iterator _find_released_voice(note n) noexcept;
         void _setup_voice(voice, note, float velocity);
         void _voice_off(voice_store::iterator it);
         void _voice_stop(voice_store::iterator it);
+        void _initialize_voice_state(voice v);
+        voice_store::iterator _find_prepared_voice();
         voice_store::iterator _find_note_on_voice(note n);
         voice_store::iterator _find_on_voice();
+        void _set_on_voice_note(voice_store::iterator it, note n) noexcept;
+
+        inline uint32_t _index_of(voice_store::iterator it) const noexcept
+        {
+            return static_cast<uint32_t>(std::distance(voice_store::const_iterator{_voices.begin()}, voice_store::const_iterator{it}));
+        }
 
         inline auto _get_voice_midi_input(voice voice) noexcept
         {
@@ -61,15 +228,49 @@ namespace Gammou
         }
 
         //  Midi input values are stored here for every running voices
-        std::vector<float> _midi_input_values;
+        std::vector<float, arena_allocator<float>> _midi_input_values;
 
-        unsigned int _voice_disappearance_sample_count{20000u};
+        //  Voice output level accumulated over the current block
+        std::vector<float, arena_allocator<float>> _voice_peak;
+        std::vector<float, arena_allocator<float>> _voice_energy;
+        //  Voice output peak during the last block
+        std::vector<float, arena_allocator<float>> _voice_level;
+
+        unsigned int _voice_disappearance_sample_count{voice_disappearance_sample_count_default};
         float _voice_disappearance_treshold{voice_disappearance_treshold_default};
-        std::vector<unsigned int> _voice_lifetime;
+        level_detection _level_detection{level_detection::PEAK};
+        std::vector<unsigned int, arena_allocator<unsigned int>> _voice_lifetime;
+
+        //  Set when the voice state must be initialized before being used again
+        std::vector<uint8_t, arena_allocator<uint8_t>> _voice_state_dirty;
+        std::size_t _prepared_voice_count{0u};
+        initialization_statistics _initialization_statistics{};
+
+        //  Voice stealing
+        std::vector<float, arena_allocator<float>> _voice_gain;
+        std::vector<float, arena_allocator<float>> _voice_fade_step;       //<< Non zero when the voice is fading out
+        std::vector<uint32_t, arena_allocator<uint32_t>> _voice_start_order;
+        uint32_t _note_on_count{0u};
+        std::size_t _fading_voice_count{0u};
+        std::atomic<std::size_t> _max_voices;
+        steal_policy _steal_policy{steal_policy::OLDEST};
+        bool _same_note_retrigger{false};
+        unsigned int _steal_fade_sample_count{220u};
+        std::size_t _stolen_count{0u};
+        std::size_t _dropped_count{0u};
+
+        //  Index in _voices of the on voice playing each note
+        std::array<uint32_t, 128u> _note_voice_index;
 
-        voice_store _voices{};
+        //  voices = [on voices | off but still active voices | free pooled voices | never used voices]
+        //  The voices are only taken from the never used part when the pool is empty,
+        //  so that the voice states memory which is touched grows with the actual polyphony.
+        voice_store _voices;
         voice_store::iterator _on_voice_end;
         voice_store::iterator _active_voices_end;
+        voice_store::iterator _pool_end;
+        std::atomic<std::size_t> _voice_limit;
+        std::size_t _peak_active_count{0u};
         mode _mode{mode::POLYPHONIC};
 
         DSPJIT::graph_execution_context& _polyphonic_context;
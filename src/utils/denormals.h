@@ -0,0 +1,76 @@
+#ifndef GAMMOU_DENORMALS_H_
+#define GAMMOU_DENORMALS_H_
+
+#include <cstdint>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define GAMMOU_DENORMALS_SSE
+#elif defined(__aarch64__)
+#define GAMMOU_DENORMALS_AARCH64
+#endif
+
+namespace Gammou {
+
+    /**
+     * \class scoped_denormals_flush
+     * \brief Make the calling thread flush denormal floats to zero (FTZ, and DAZ on x86)
+     *  during its lifetime, and restore the previous floating point mode afterward.
+     *
+     *  Decaying filter states reach the denormal range where arithmetic is much slower :
+     *  the sound processing must always run under this guard.
+     */
+    class scoped_denormals_flush {
+    public:
+        scoped_denormals_flush() noexcept
+        {
+#if defined(GAMMOU_DENORMALS_SSE)
+            _previous_mode = _mm_getcsr();
+            _mm_setcsr(_previous_mode | flush_mode_bits);
+#elif defined(GAMMOU_DENORMALS_AARCH64)
+            asm volatile("mrs %0, fpcr" : "=r"(_previous_mode));
+            asm volatile("msr fpcr, %0" : : "r"(_previous_mode | flush_mode_bits));
+#endif
+        }
+
+        ~scoped_denormals_flush() noexcept
+        {
+#if defined(GAMMOU_DENORMALS_SSE)
+            _mm_setcsr(_previous_mode);
+#elif defined(GAMMOU_DENORMALS_AARCH64)
+            asm volatile("msr fpcr, %0" : : "r"(_previous_mode));
+#endif
+        }
+
+        scoped_denormals_flush(const scoped_denormals_flush&) = delete;
+        scoped_denormals_flush& operator=(const scoped_denormals_flush&) = delete;
+
+        /**
+         *  \brief Return true if denormals are flushed on the calling thread
+         */
+        static bool enabled() noexcept
+        {
+#if defined(GAMMOU_DENORMALS_SSE)
+            return (_mm_getcsr() & flush_mode_bits) == flush_mode_bits;
+#elif defined(GAMMOU_DENORMALS_AARCH64)
+            uint64_t mode;
+            asm volatile("mrs %0, fpcr" : "=r"(mode));
+            return (mode & flush_mode_bits) == flush_mode_bits;
+#else
+            return true;    //  Unknown platform : nothing can be done
+#endif
+        }
+
+    private:
+#if defined(GAMMOU_DENORMALS_SSE)
+        static constexpr unsigned int flush_mode_bits = 0x8040u;    //<< MXCSR FTZ | DAZ
+        unsigned int _previous_mode;
+#elif defined(GAMMOU_DENORMALS_AARCH64)
+        static constexpr uint64_t flush_mode_bits = uint64_t{1u} << 24u;   //<< FPCR FZ
+        uint64_t _previous_mode;
+#endif
+    };
+
+}
+
+#endif
@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <sys/syscall.h>
+#endif
+
+#include <DSPJIT/log.h>
+
+#include "memory_arena.h"
+
+namespace Gammou {
+
+    static std::size_t round_up(std::size_t value, std::size_t multiple) noexcept
+    {
+        return ((value + multiple - 1u) / multiple) * multiple;
+    }
+
+#ifdef _WIN32
+
+    void memory_arena::_map(std::size_t capacity, bool use_huge_pages)
+    {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+
+        //  Large pages require the SeLockMemoryPrivilege, fallback to regular pages if not granted
+        const auto large_page_size = GetLargePageMinimum();
+        if (use_huge_pages && large_page_size != 0u) {
+            const auto size = round_up(capacity, large_page_size);
+            _base = static_cast<std::byte*>(
+                VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE));
+
+            if (_base != nullptr) {
+                _statistics.capacity = size;
+                _statistics.page_size = large_page_size;
+                _statistics.memory_backing = backing::HUGE_PAGES;
+                return;
+            }
+        }
+
+        const auto size = round_up(capacity, info.dwPageSize);
+        _base = static_cast<std::byte*>(
+            VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+
+        if (_base == nullptr)
+            throw std::bad_alloc{};
+
+        _statistics.capacity = size;
+        _statistics.page_size = info.dwPageSize;
+        _statistics.memory_backing = backing::REGULAR_PAGES;
+    }
+
+    memory_arena::~memory_arena() noexcept
+    {
+        VirtualFree(_base, 0u, MEM_RELEASE);
+    }
+
+#else
+
+    static constexpr std::size_t huge_page_size = 2u * 1024u * 1024u;
+
+    void memory_arena::_map(std::size_t capacity, bool use_huge_pages)
+    {
+        const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        void *base = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+        //  Explicit huge pages are only available if the system reserved some (vm.nr_hugepages)
+        if (use_huge_pages) {
+            const auto size = round_up(capacity, huge_page_size);
+            base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+            if (base != MAP_FAILED) {
+                _base = static_cast<std::byte*>(base);
+                _statistics.capacity = size;
+                _statistics.page_size = huge_page_size;
+                _statistics.memory_backing = backing::HUGE_PAGES;
+                return;
+            }
+        }
+#endif
+
+        const auto size = round_up(capacity, use_huge_pages ? huge_page_size : page_size);
+
+        if (use_huge_pages) {
+            //  Transparent huge pages can only back huge page aligned ranges : over allocate, then trim
+            base = mmap(nullptr, size + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+            if (base == MAP_FAILED)
+                throw std::bad_alloc{};
+
+            const auto address = reinterpret_cast<std::uintptr_t>(base);
+            const auto head = round_up(address, huge_page_size) - address;
+
+            if (head != 0u)
+                munmap(base, head);
+            munmap(static_cast<std::byte*>(base) + head + size, huge_page_size - head);
+            base = static_cast<std::byte*>(base) + head;
+        }
+        else {
+            base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+            if (base == MAP_FAILED)
+                throw std::bad_alloc{};
+        }
+
+        _base = static_cast<std::byte*>(base);
+        _statistics.capacity = size;
+        _statistics.page_size = page_size;
+        _statistics.memory_backing = backing::REGULAR_PAGES;
+
+#ifdef MADV_HUGEPAGE
+        //  The advice succeeds even when transparent huge pages are disabled : the backing is checked after prefault
+        if (use_huge_pages && madvise(base, size, MADV_HUGEPAGE) == 0)
+            _statistics.memory_backing = backing::TRANSPARENT_HUGE_PAGES_REQUESTED;
+#endif
+    }
+
+    memory_arena::~memory_arena() noexcept
+    {
+        munmap(_base, _statistics.capacity);
+    }
+
+#endif
+
+    void memory_arena::_check_transparent_huge_pages() noexcept
+    {
+#ifdef __linux__
+        if (_statistics.memory_backing != backing::TRANSPARENT_HUGE_PAGES_REQUESTED)
+            return;
+
+        //  Find the mapping of the region and read how much of it is backed by transparent huge pages
+        std::ifstream smaps{"/proc/self/smaps"};
+        const auto base = reinterpret_cast<std::uintptr_t>(_base);
+        bool in_region = false;
+        std::string line;
+
+        while (std::getline(smaps, line)) {
+            std::uintptr_t start = 0u;
+            std::uintptr_t end = 0u;
+            std::size_t huge_kb = 0u;
+
+            if (std::sscanf(line.c_str(), "%" SCNxPTR "-%" SCNxPTR " ", &start, &end) == 2) {
+                in_region = (start <= base && base < end);
+            }
+            else if (in_region && std::sscanf(line.c_str(), "AnonHugePages: %zu kB", &huge_kb) == 1) {
+                if (huge_kb != 0u) {
+                    _statistics.page_size = huge_page_size;
+                    _statistics.memory_backing = backing::TRANSPARENT_HUGE_PAGES;
+                }
+                return;
+            }
+        }
+#endif
+    }
+
+    memory_arena::memory_arena(std::size_t capacity, bool use_huge_pages)
+    {
+        _map(std::max<std::size_t>(capacity, 1u), use_huge_pages);
+        _prefault();
+        _check_transparent_huge_pages();
+
+        LOG_INFO("[memory arena] Mapped %zu KB using %s\n",
+            _statistics.capacity / 1024u, memory_backing_name(_statistics.memory_backing));
+    }
+
+    void *memory_arena::allocate(std::size_t size, std::size_t alignment)
+    {
+        const auto address = reinterpret_cast<std::uintptr_t>(_base) + _statistics.used;
+        const auto padding = (alignment - (address % alignment)) % alignment;
+
+        if (_statistics.used + padding + size > _statistics.capacity)
+            throw std::bad_alloc{};
+
+        auto *block = _base + _statistics.used + padding;
+        _statistics.used += padding + size;
+        _statistics.allocation_count++;
+        return block;
+    }
+
+    bool memory_arena::bind_to_current_numa_node() noexcept
+    {
+#if defined(__linux__) && defined(SYS_getcpu) && defined(SYS_mbind)
+        //  Use the syscalls directly to avoid a libnuma dependency
+        constexpr int mpol_preferred = 1;
+        constexpr unsigned int mpol_mf_move = 1u << 1u;
+        constexpr auto max_node = 8u * sizeof(unsigned long);
+
+        unsigned int cpu = 0u;
+        unsigned int node = 0u;
+
+        if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0 || node >= max_node)
+            return false;
+
+        const unsigned long node_mask = 1ul << node;
+        if (syscall(SYS_mbind, _base, _statistics.capacity, mpol_preferred, &node_mask, max_node, mpol_mf_move) != 0)
+            return false;
+
+        _statistics.numa_node = static_cast<int>(node);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void memory_arena::_prefault() noexcept
+    {
+        //  Touch every page : the pages are then placed on the numa node of the calling thread.
+        //  The smallest page size is used as transparent huge pages are not guaranteed.
+        constexpr std::size_t prefault_stride = 4096u;
+        for (std::size_t offset = 0u; offset < _statistics.capacity; offset += prefault_stride)
+            reinterpret_cast<volatile std::byte*>(_base)[offset] = std::byte{0};
+    }
+
+    const char *memory_backing_name(memory_arena::backing backing) noexcept
+    {
+        switch (backing)
+        {
+            case memory_arena::backing::HUGE_PAGES: return "huge pages";
+            case memory_arena::backing::TRANSPARENT_HUGE_PAGES: return "transparent huge pages";
+            case memory_arena::backing::TRANSPARENT_HUGE_PAGES_REQUESTED: return "regular pages (transparent huge pages requested)";
+            default: return "regular pages";
+        }
+    }
+
+}
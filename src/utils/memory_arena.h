@@ -0,0 +1,134 @@
+#ifndef GAMMOU_MEMORY_ARENA_H_
+#define GAMMOU_MEMORY_ARENA_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+
+namespace Gammou {
+
+    /**
+     * \class memory_arena
+     * \brief A fixed capacity memory region for the memory used while processing sound.
+     *
+     *  The region can be backed by huge pages when available (explicit huge pages, then transparent
+     *  huge pages, then regular pages) in order to reduce TLB misses. This is only worth it for regions
+     *  of several huge pages, and reserves memory which may be scarce : it must be requested.
+     *  The region is fully pre-faulted at creation so that the sound processing thread never page
+     *  faults when using it.
+     *  Allocations are cache line aligned by default and are never freed individually :
+     *  the whole region is released with the arena.
+     */
+    class memory_arena {
+    public:
+        static constexpr std::size_t cache_line_size = 64u;
+
+        enum class backing
+        {
+            HUGE_PAGES,                 //<< Explicit huge pages (MAP_HUGETLB, MEM_LARGE_PAGES)
+            TRANSPARENT_HUGE_PAGES,     //<< Regular mapping, found backed by transparent huge pages after prefault
+            TRANSPARENT_HUGE_PAGES_REQUESTED,   //<< Transparent huge pages advice given, but no huge page was observed
+            REGULAR_PAGES
+        };
+
+        struct statistics
+        {
+            std::size_t capacity{0u};           //<< Usable size of the region in bytes
+            std::size_t used{0u};               //<< Allocated bytes, including alignment padding
+            std::size_t allocation_count{0u};
+            std::size_t page_size{0u};          //<< Size of the pages backing the region
+            backing memory_backing{backing::REGULAR_PAGES};
+            int numa_node{-1};                  //<< Numa node the region was bound to, -1 if unbound
+        };
+
+        /**
+         * \param capacity minimum size of the region in bytes, rounded up to the page size
+         * \param use_huge_pages try to use huge pages to back the region
+         * \throw std::bad_alloc if no memory can be mapped
+         */
+        explicit memory_arena(std::size_t capacity, bool use_huge_pages = false);
+        memory_arena(const memory_arena&) = delete;
+        memory_arena(memory_arena&&) = delete;
+        ~memory_arena() noexcept;
+
+        /**
+         * \brief Allocate a block from the arena
+         * \param alignment must be a power of two
+         * \throw std::bad_alloc if the arena is exhausted
+         */
+        void *allocate(std::size_t size, std::size_t alignment = cache_line_size);
+
+        /**
+         * \brief Allocate an array of zero initialized trivial values
+         */
+        template <typename T>
+        T *allocate_array(std::size_t count, std::size_t alignment = cache_line_size)
+        {
+            auto *array = static_cast<T*>(allocate(count * sizeof(T), std::max(alignof(T), alignment)));
+            std::uninitialized_value_construct_n(array, count);
+            return array;
+        }
+
+        /**
+         * \brief Move the region pages to the numa node of the calling thread,
+         *  in order to keep memory local to the thread processing sound.
+         * \note This is slow and must not be called while processing sound. Does nothing
+         *  on platforms or systems without numa support.
+         * \return true if the region was bound to the current numa node
+         */
+        bool bind_to_current_numa_node() noexcept;
+
+        const statistics& get_statistics() const noexcept { return _statistics; }
+
+    private:
+        void _map(std::size_t capacity, bool use_huge_pages);
+        void _prefault() noexcept;
+        void _check_transparent_huge_pages() noexcept;
+
+        std::byte *_base{nullptr};
+        statistics _statistics{};
+    };
+
+    /**
+     * \brief Standard allocator adapter allocating from a memory arena.
+     *  Deallocation is a no-op : containers using it must not be grown repeatedly.
+     */
+    template <typename T>
+    class arena_allocator {
+    public:
+        using value_type = T;
+
+        explicit arena_allocator(memory_arena& arena) noexcept
+        :   _arena{&arena}
+        {}
+
+        template <typename U>
+        arena_allocator(const arena_allocator<U>& other) noexcept
+        :   _arena{other.arena()}
+        {}
+
+        T *allocate(std::size_t count)
+        {
+            return static_cast<T*>(
+                _arena->allocate(count * sizeof(T), std::max(alignof(T), memory_arena::cache_line_size)));
+        }
+
+        void deallocate(T*, std::size_t) noexcept {}
+
+        memory_arena *arena() const noexcept { return _arena; }
+
+        template <typename U>
+        bool operator==(const arena_allocator<U>& other) const noexcept { return _arena == other.arena(); }
+        template <typename U>
+        bool operator!=(const arena_allocator<U>& other) const noexcept { return _arena != other.arena(); }
+
+    private:
+        memory_arena *_arena;
+    };
+
+    const char *memory_backing_name(memory_arena::backing backing) noexcept;
+
+}
+
+#endif /* GAMMOU_MEMORY_ARENA_H_ */
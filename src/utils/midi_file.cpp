@@ -0,0 +1,242 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include "midi_file.h"
+
+namespace Gammou {
+
+    static constexpr auto default_tempo = 500000u;  //  Microseconds per quarter note (120 bpm)
+
+    struct tick_event
+    {
+        uint64_t tick;
+        std::size_t order;          //<< Keep the file order of simultaneous events
+        uint32_t tempo;             //<< New tempo for tempo changes, 0 for channel messages
+        std::array<uint8_t, 3u> data;
+        uint8_t size;
+    };
+
+    /**
+     * \brief Bound checked big endian reader
+     */
+    class midi_reader {
+    public:
+        midi_reader(const uint8_t *data, std::size_t size) noexcept
+        :   _cursor{data}, _end{data + size}
+        {}
+
+        bool at_end() const noexcept { return _cursor == _end; }
+
+        uint8_t peek() const
+        {
+            _check(1u);
+            return *_cursor;
+        }
+
+        uint8_t read_byte()
+        {
+            _check(1u);
+            return *_cursor++;
+        }
+
+        uint32_t read_big_endian(std::size_t byte_count)
+        {
+            _check(byte_count);
+            uint32_t value = 0u;
+            for (auto i = 0u; i < byte_count; ++i)
+                value = (value << 8u) | *_cursor++;
+            return value;
+        }
+
+        uint32_t read_variable_length()
+        {
+            uint32_t value = 0u;
+            for (auto i = 0u; i < 4u; ++i) {
+                const auto byte = read_byte();
+                value = (value << 7u) | (byte & 0x7Fu);
+                if ((byte & 0x80u) == 0u)
+                    return value;
+            }
+            throw std::invalid_argument("midi file : invalid variable length quantity");
+        }
+
+        const uint8_t *read_bytes(std::size_t count)
+        {
+            _check(count);
+            const auto *bytes = _cursor;
+            _cursor += count;
+            return bytes;
+        }
+
+        void skip(std::size_t count)
+        {
+            read_bytes(count);
+        }
+
+    private:
+        void _check(std::size_t count) const
+        {
+            if (count > static_cast<std::size_t>(_end - _cursor))
+                throw std::invalid_argument("midi file : truncated file");
+        }
+
+        const uint8_t *_cursor;
+        const uint8_t *_end;
+    };
+
+    static std::size_t channel_message_size(uint8_t status) noexcept
+    {
+        switch (status >> 4u)
+        {
+            case 0xCu:  //  Program change
+            case 0xDu:  //  Channel pressure
+                return 2u;
+            default:
+                return 3u;
+        }
+    }
+
+    static void read_track(midi_reader& track, std::vector<tick_event>& events)
+    {
+        uint64_t tick = 0u;
+        uint8_t running_status = 0u;
+
+        while (!track.at_end()) {
+            tick += track.read_variable_length();
+
+            auto status = track.peek();
+            if (status & 0x80u)
+                track.read_byte();
+            else if (running_status != 0u)
+                status = running_status;  //  Running status : the data byte is not consumed
+            else
+                throw std::invalid_argument("midi file : data byte without status");
+
+            if (status == 0xFFu) {
+                //  Meta event
+                const auto type = track.read_byte();
+                const auto length = track.read_variable_length();
+
+                if (type == 0x2Fu) {         //  End of track
+                    track.skip(length);
+                    return;
+                }
+                else if (type == 0x51u && length == 3u) {  //  Set tempo
+                    const auto tempo = track.read_big_endian(3u);
+                    events.push_back({tick, events.size(), std::max(tempo, 1u), {}, 0u});
+                }
+                else {
+                    track.skip(length);
+                }
+            }
+            else if (status == 0xF0u || status == 0xF7u) {
+                //  System exclusive
+                track.skip(track.read_variable_length());
+            }
+            else if (status >= 0xF0u) {
+                throw std::invalid_argument("midi file : unexpected system message in track");
+            }
+            else {
+                running_status = status;
+                const auto size = channel_message_size(status);
+                tick_event event{tick, events.size(), 0u, {status, 0u, 0u}, static_cast<uint8_t>(size)};
+                for (auto i = 1u; i < size; ++i)
+                    event.data[i] = track.read_byte() & 0x7Fu;
+                events.push_back(event);
+            }
+        }
+    }
+
+    std::vector<midi_file_event> parse_midi_file(const uint8_t *data, std::size_t size)
+    {
+        midi_reader file{data, size};
+
+        //  Header chunk
+        if (std::memcmp(file.read_bytes(4u), "MThd", 4u) != 0)
+            throw std::invalid_argument("midi file : invalid header");
+
+        const auto header_length = file.read_big_endian(4u);
+        if (header_length < 6u)
+            throw std::invalid_argument("midi file : invalid header");
+
+        const auto format = file.read_big_endian(2u);
+        const auto track_count = file.read_big_endian(2u);
+        const auto division = file.read_big_endian(2u);
+        file.skip(header_length - 6u);
+
+        if (format > 1u)
+            throw std::invalid_argument("midi file : only formats 0 and 1 are handled");
+
+        //  Ticks per quarter note, or SMPTE frames per second and ticks per frame
+        const bool smpte_division = (division & 0x8000u) != 0u;
+        double seconds_per_smpte_tick = 0.;
+        if (smpte_division) {
+            const auto frame_rate = -static_cast<int8_t>(division >> 8u);
+            const auto ticks_per_frame = division & 0xFFu;
+            if (frame_rate <= 0 || ticks_per_frame == 0u)
+                throw std::invalid_argument("midi file : invalid time division");
+            //  29 means 29.97 fps
+            const auto fps = (frame_rate == 29) ? 29.97 : static_cast<double>(frame_rate);
+            seconds_per_smpte_tick = 1. / (fps * ticks_per_frame);
+        }
+        else if (division == 0u) {
+            throw std::invalid_argument("midi file : invalid time division");
+        }
+
+        //  Track chunks, unknown chunks are skipped
+        std::vector<tick_event> events{};
+        for (auto track_index = 0u; track_index < track_count && !file.at_end();) {
+            const auto *chunk_type = file.read_bytes(4u);
+            const auto chunk_length = file.read_big_endian(4u);
+            const auto *chunk_data = file.read_bytes(chunk_length);
+
+            if (std::memcmp(chunk_type, "MTrk", 4u) == 0) {
+                midi_reader track{chunk_data, chunk_length};
+                read_track(track, events);
+                track_index++;
+            }
+        }
+
+        std::stable_sort(events.begin(), events.end(),
+            [](const tick_event& a, const tick_event& b) { return a.tick < b.tick; });
+
+        //  Convert the ticks to seconds according to the tempo map
+        std::vector<midi_file_event> result{};
+        result.reserve(events.size());
+
+        uint32_t tempo = default_tempo;
+        uint64_t last_tick = 0u;
+        double time = 0.;
+
+        for (const auto& event : events) {
+            const auto delta = static_cast<double>(event.tick - last_tick);
+            time += smpte_division ?
+                delta * seconds_per_smpte_tick :
+                delta * static_cast<double>(tempo) * 1e-6 / static_cast<double>(division);
+            last_tick = event.tick;
+
+            if (event.tempo != 0u)
+                tempo = event.tempo;
+            else
+                result.push_back({time, event.data, event.size});
+        }
+
+        return result;
+    }
+
+    std::vector<midi_file_event> load_midi_file(const std::filesystem::path& path)
+    {
+        std::ifstream stream{path, std::ios::binary};
+        if (!stream.is_open())
+            throw std::invalid_argument("midi file : unable to open the specified path");
+
+        const std::vector<uint8_t> data{
+            std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{}};
+
+        return parse_midi_file(data.data(), data.size());
+    }
+
+}
@@ -0,0 +1,36 @@
+#ifndef GAMMOU_MIDI_FILE_H_
+#define GAMMOU_MIDI_FILE_H_
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace Gammou {
+
+    /**
+     * \brief A channel message read from a midi file
+     */
+    struct midi_file_event
+    {
+        double time;                    //<< Seconds from the beginning of the file
+        std::array<uint8_t, 3u> data;   //<< Status and data bytes
+        uint8_t size;
+    };
+
+    /**
+     * \brief Read the channel messages of a Standard Midi File (format 0 or 1), with their time in seconds
+     *  according to the tempo map. The tracks are merged and the events sorted by time.
+     *  System exclusive and meta events other than tempo changes are ignored.
+     * \throw std::invalid_argument if the file can not be read or is not a valid midi file
+     */
+    std::vector<midi_file_event> load_midi_file(const std::filesystem::path& path);
+
+    /**
+     * \brief Parse an in memory Standard Midi File, \see load_midi_file
+     */
+    std::vector<midi_file_event> parse_midi_file(const uint8_t *data, std::size_t size);
+
+}
+
+#endif /* GAMMOU_MIDI_FILE_H_ */
@@ -0,0 +1,111 @@
+#ifndef GAMMOU_MPSC_QUEUE_H_
+#define GAMMOU_MPSC_QUEUE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace Gammou {
+
+    /**
+     * \class mpsc_queue
+     * \brief A fixed capacity, lock free, multiple producers single consumer queue.
+     *
+     *  Each cell carries a sequence number telling whether it is ready to be written or read,
+     *  so that producers only contend on the write index. Push and pop never allocate nor lock.
+     *  When the queue is full, push fails and the value is dropped.
+     * \tparam Capacity must be a power of two
+     */
+    template <typename T, std::size_t Capacity>
+    class mpsc_queue {
+        static_assert((Capacity & (Capacity - 1u)) == 0u, "Capacity must be a power of two");
+        static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+
+    public:
+        static constexpr std::size_t cache_line_size = 64u;
+
+        mpsc_queue() noexcept
+        {
+            for (auto i = 0u; i < Capacity; ++i)
+                _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        mpsc_queue(const mpsc_queue&) = delete;
+        mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+        /**
+         * \brief Push a value, from any producer thread
+         * \return false if the queue was full
+         */
+        bool push(const T& value) noexcept
+        {
+            auto write_index = _write_index.load(std::memory_order_relaxed);
+
+            for (;;) {
+                auto& c = _cells[write_index & (Capacity - 1u)];
+                const auto sequence = c.sequence.load(std::memory_order_acquire);
+                const auto diff =
+                    static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(write_index);
+
+                if (diff == 0) {
+                    //  The cell is free : try to reserve it
+                    if (_write_index.compare_exchange_weak(write_index, write_index + 1u, std::memory_order_relaxed)) {
+                        c.value = value;
+                        c.sequence.store(write_index + 1u, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0) {
+                    //  The cell was not read yet : the queue is full
+                    return false;
+                }
+                else {
+                    //  Another producer took this cell
+                    write_index = _write_index.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * \brief Pop a value, from the consumer thread
+         * \return false if the queue was empty
+         */
+        bool pop(T& value) noexcept
+        {
+            auto& c = _cells[_read_index & (Capacity - 1u)];
+
+            if (c.sequence.load(std::memory_order_acquire) != _read_index + 1u)
+                return false;
+
+            value = c.value;
+            c.sequence.store(_read_index + Capacity, std::memory_order_release);
+            _read_index++;
+            return true;
+        }
+
+        /**
+         * \brief Pop every available value and pass them to func, from the consumer thread
+         */
+        template <typename Func>
+        void consume_all(Func&& func)
+        {
+            T value;
+            while (pop(value))
+                func(value);
+        }
+
+    private:
+        struct cell {
+            std::atomic<std::size_t> sequence;
+            T value;
+        };
+
+        alignas(cache_line_size) std::atomic<std::size_t> _write_index{0u};
+        alignas(cache_line_size) std::size_t _read_index{0u};
+        alignas(cache_line_size) std::array<cell, Capacity> _cells{};
+    };
+
+}
+
+#endif /* GAMMOU_MPSC_QUEUE_H_ */
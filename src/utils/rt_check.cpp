@@ -0,0 +1,209 @@
+
+#ifdef GAMMOU_ENABLE_RT_CHECKS
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "denormals.h"
+#include "rt_check.h"
+
+#ifdef __linux__
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <time.h>
+#endif
+
+namespace Gammou {
+
+    //  Only the first violations are reported with a stack trace, the following ones are only counted
+    static constexpr auto max_reported_violations = 32u;
+    static constexpr auto max_stack_depth = 48;
+
+    //  The initial exec model is used so that reading these from the intercepted functions never calls
+    //  __tls_get_addr, which may allocate, when this code is loaded as a module
+#if defined(__GNUC__)
+#define GAMMOU_RT_CHECK_TLS_MODEL __attribute__((tls_model("initial-exec")))
+#else
+#define GAMMOU_RT_CHECK_TLS_MODEL
+#endif
+
+    static thread_local unsigned int realtime_depth GAMMOU_RT_CHECK_TLS_MODEL = 0u;
+    static thread_local bool reporting GAMMOU_RT_CHECK_TLS_MODEL = false;
+    static std::atomic<std::size_t> violations{0u};
+
+    static void print_message(const char *message) noexcept;
+    static void print_stack_trace() noexcept;
+
+    realtime_scope::realtime_scope() noexcept
+    {
+        if (realtime_depth++ == 0u && !scoped_denormals_flush::enabled())
+            report_violation("denormals are not flushed to zero");
+    }
+
+    realtime_scope::~realtime_scope() noexcept
+    {
+        realtime_depth--;
+    }
+
+    void realtime_scope::report_violation(const char *what) noexcept
+    {
+        if (realtime_depth == 0u || reporting)
+            return;
+
+        //  Reporting does forbidden things as well : they must not be reported
+        reporting = true;
+
+        const auto index = violations.fetch_add(1u) + 1u;
+
+        if (index <= max_reported_violations) {
+            char message[256];
+            std::snprintf(message, sizeof(message),
+                "[rt check] Real time safety violation #%zu : %s\n", index, what);
+            print_message(message);
+            print_stack_trace();
+
+            if (index == max_reported_violations)
+                print_message("[rt check] Further violations will only be counted\n");
+        }
+
+        reporting = false;
+    }
+
+    std::size_t realtime_scope::violation_count() noexcept
+    {
+        return violations.load();
+    }
+
+#ifdef __linux__
+
+    /*
+     *  The intercepted functions forward to the next definition, found with dlsym.
+     *  The allocation functions are intercepted in rt_check_allocations.cpp.
+     */
+
+    static void *next_function(std::atomic<void*>& cache, const char *name) noexcept
+    {
+        auto function = cache.load(std::memory_order_relaxed);
+        if (function == nullptr) {
+            function = dlsym(RTLD_NEXT, name);
+            cache.store(function, std::memory_order_relaxed);
+        }
+        return function;
+    }
+
+    #define GAMMOU_NEXT_FUNCTION(name)                                                          \
+        reinterpret_cast<decltype(&::name)>(                                                    \
+            [] { static std::atomic<void*> cache{nullptr}; return Gammou::next_function(cache, #name); }())
+
+    static void print_message(const char *message) noexcept
+    {
+        std::fputs(message, stderr);
+    }
+
+    static void print_stack_trace() noexcept
+    {
+        void *frames[max_stack_depth];
+        const auto depth = backtrace(frames, max_stack_depth);
+        //  Skip this function and report_violation
+        backtrace_symbols_fd(frames + 2, depth - 2, 2);
+    }
+
+    //  backtrace loads libgcc when it is first called : do it early
+    static const auto backtrace_initialized =
+        []()
+        {
+            void *frame;
+            return backtrace(&frame, 1) >= 0;
+        }();
+
+#else
+
+    static void print_message(const char *message) noexcept
+    {
+        std::fputs(message, stderr);
+    }
+
+    static void print_stack_trace() noexcept
+    {
+        //  Stack traces are only available on linux
+    }
+
+#endif
+
+}
+
+#ifdef __linux__
+
+extern "C" {
+
+/*
+ *  Locks
+ */
+
+    int pthread_mutex_lock(pthread_mutex_t *mutex)
+    {
+        Gammou::realtime_scope::report_violation("pthread_mutex_lock");
+        return GAMMOU_NEXT_FUNCTION(pthread_mutex_lock)(mutex);
+    }
+
+    int pthread_rwlock_rdlock(pthread_rwlock_t *lock)
+    {
+        Gammou::realtime_scope::report_violation("pthread_rwlock_rdlock");
+        return GAMMOU_NEXT_FUNCTION(pthread_rwlock_rdlock)(lock);
+    }
+
+    int pthread_rwlock_wrlock(pthread_rwlock_t *lock)
+    {
+        Gammou::realtime_scope::report_violation("pthread_rwlock_wrlock");
+        return GAMMOU_NEXT_FUNCTION(pthread_rwlock_wrlock)(lock);
+    }
+
+    int pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex)
+    {
+        Gammou::realtime_scope::report_violation("pthread_cond_wait");
+        return GAMMOU_NEXT_FUNCTION(pthread_cond_wait)(cond, mutex);
+    }
+
+/*
+ *  Blocking system calls
+ */
+
+    ssize_t read(int fd, void *buffer, size_t size)
+    {
+        Gammou::realtime_scope::report_violation("read");
+        return GAMMOU_NEXT_FUNCTION(read)(fd, buffer, size);
+    }
+
+    ssize_t write(int fd, const void *buffer, size_t size)
+    {
+        Gammou::realtime_scope::report_violation("write");
+        return GAMMOU_NEXT_FUNCTION(write)(fd, buffer, size);
+    }
+
+    int fsync(int fd)
+    {
+        Gammou::realtime_scope::report_violation("fsync");
+        return GAMMOU_NEXT_FUNCTION(fsync)(fd);
+    }
+
+    int nanosleep(const struct timespec *duration, struct timespec *remaining)
+    {
+        Gammou::realtime_scope::report_violation("nanosleep");
+        return GAMMOU_NEXT_FUNCTION(nanosleep)(duration, remaining);
+    }
+
+    int clock_nanosleep(clockid_t clock, int flags, const struct timespec *duration, struct timespec *remaining)
+    {
+        Gammou::realtime_scope::report_violation("clock_nanosleep");
+        return GAMMOU_NEXT_FUNCTION(clock_nanosleep)(clock, flags, duration, remaining);
+    }
+
+}
+
+#endif
+
+#endif /* GAMMOU_ENABLE_RT_CHECKS */
@@ -0,0 +1,53 @@
+#ifndef GAMMOU_RT_CHECK_H_
+#define GAMMOU_RT_CHECK_H_
+
+#include <cstddef>
+
+namespace Gammou {
+
+    /**
+     * \class realtime_scope
+     * \brief Mark the calling thread as running real time code during the scope lifetime.
+     *
+     *  When built with GAMMOU_ENABLE_RT_CHECKS, memory allocations, lock acquisitions and blocking
+     *  system calls made by a thread inside a realtime scope are reported with a stack trace, as well
+     *  as entering a scope without denormals being flushed to zero.
+     *  Otherwise this does nothing and costs nothing.
+     *
+     *  The allocations are only checked in the executables (rt_check_allocations.cpp) : the vst2 plugin,
+     *  loaded by a host, can not intercept the host allocator and only checks the locks and the system calls.
+     */
+    class realtime_scope {
+    public:
+#ifdef GAMMOU_ENABLE_RT_CHECKS
+        realtime_scope() noexcept;
+        ~realtime_scope() noexcept;
+#else
+        realtime_scope() noexcept = default;
+#endif
+        realtime_scope(const realtime_scope&) = delete;
+        realtime_scope& operator=(const realtime_scope&) = delete;
+
+        /**
+         *  \brief Report a violation if the calling thread is inside a realtime scope
+         *  \param what a description of the forbidden operation
+         */
+#ifdef GAMMOU_ENABLE_RT_CHECKS
+        static void report_violation(const char *what) noexcept;
+#else
+        static void report_violation(const char *) noexcept {}
+#endif
+
+        /**
+         *  \brief Return the number of violations since the program started
+         */
+#ifdef GAMMOU_ENABLE_RT_CHECKS
+        static std::size_t violation_count() noexcept;
+#else
+        static std::size_t violation_count() noexcept { return 0u; }
+#endif
+    };
+
+}
+
+#endif
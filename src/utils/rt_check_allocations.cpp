@@ -0,0 +1,92 @@
+#ifdef GAMMOU_ENABLE_RT_CHECKS
+
+/*
+ *  The allocation functions can only be interposed by the executable : a module loaded by a host,
+ *  as the vst2 plugin, can not replace the host allocator. This file is therefore only built into
+ *  the executables, and the vst2 plugin only checks the locks and the blocking system calls.
+ */
+
+#include <cstdlib>
+#include <new>
+
+#include "rt_check.h"
+
+#ifdef __linux__
+
+/*
+ *  glibc exports its allocator under internal names : they are used directly so that
+ *  dlsym, which may allocate, is not called by the allocation functions.
+ */
+
+extern "C" {
+    void *__libc_malloc(size_t);
+    void *__libc_calloc(size_t, size_t);
+    void *__libc_realloc(void*, size_t);
+    void __libc_free(void*);
+
+    void *malloc(size_t size)
+    {
+        Gammou::realtime_scope::report_violation("malloc");
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t count, size_t size)
+    {
+        Gammou::realtime_scope::report_violation("calloc");
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *ptr, size_t size)
+    {
+        Gammou::realtime_scope::report_violation("realloc");
+        return __libc_realloc(ptr, size);
+    }
+
+    void free(void *ptr)
+    {
+        if (ptr != nullptr)
+            Gammou::realtime_scope::report_violation("free");
+        __libc_free(ptr);
+    }
+
+}
+
+#else
+
+/*
+ *  Elsewhere only the c++ allocations are intercepted
+ */
+
+void *operator new(std::size_t size)
+{
+    Gammou::realtime_scope::report_violation("operator new");
+    if (auto ptr = std::malloc(size))
+        return ptr;
+    throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size)
+{
+    Gammou::realtime_scope::report_violation("operator new[]");
+    if (auto ptr = std::malloc(size))
+        return ptr;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void *ptr) noexcept
+{
+    if (ptr != nullptr)
+        Gammou::realtime_scope::report_violation("operator delete");
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    if (ptr != nullptr)
+        Gammou::realtime_scope::report_violation("operator delete[]");
+    std::free(ptr);
+}
+
+#endif
+
+#endif /* GAMMOU_ENABLE_RT_CHECKS */
@@ -0,0 +1,102 @@
+
+#include <chrono>
+#include <cstdarg>
+#include <stdexcept>
+
+#include "rt_log.h"
+
+namespace Gammou {
+
+    //  Period at which the background thread writes the messages
+    static constexpr auto drain_period = std::chrono::milliseconds{10};
+
+    realtime_logger& realtime_logger::instance()
+    {
+        static realtime_logger logger{};
+        return logger;
+    }
+
+    realtime_logger::~realtime_logger()
+    {
+        stop();
+    }
+
+    void realtime_logger::start(std::FILE *output)
+    {
+        if (_running)
+            return;
+
+        _output = output;
+        _running = true;
+        _drain_thread = std::thread{
+            [this]()
+            {
+                while (_running) {
+                    std::this_thread::sleep_for(drain_period);
+                    _drain();
+                }
+            }};
+    }
+
+    void realtime_logger::start(const std::filesystem::path& path)
+    {
+        if (_running)
+            return;
+
+        auto output = std::fopen(path.string().c_str(), "w");
+        if (output == nullptr)
+            throw std::runtime_error("realtime_logger : failed to open " + path.string());
+
+        start(output);
+        _owns_output = true;
+    }
+
+    void realtime_logger::stop()
+    {
+        if (!_running)
+            return;
+
+        _running = false;
+        _drain_thread.join();
+        _drain();
+
+        if (_owns_output)
+            std::fclose(_output);
+        _output = nullptr;
+        _owns_output = false;
+    }
+
+    void realtime_logger::log(level message_level, const char *format, ...) noexcept
+    {
+        if (message_level < _min_level.load(std::memory_order_relaxed))
+            return;
+
+        message msg;
+
+        va_list args;
+        va_start(args, format);
+        std::vsnprintf(msg.text, max_message_size, format, args);
+        va_end(args);
+
+        if (!_ring.push(msg))
+            _dropped_count.fetch_add(1u, std::memory_order_relaxed);
+    }
+
+    void realtime_logger::_drain() noexcept
+    {
+        _ring.consume_all(
+            [this](const message& msg)
+            {
+                std::fputs(msg.text, _output);
+            });
+
+        const auto dropped_count = _dropped_count.load(std::memory_order_relaxed);
+        if (dropped_count != _reported_dropped_count) {
+            std::fprintf(_output, "[realtime logger] %zu messages dropped\n", dropped_count - _reported_dropped_count);
+            _reported_dropped_count = dropped_count;
+        }
+
+        std::fflush(_output);
+    }
+
+}
@@ -0,0 +1,114 @@
+#ifndef GAMMOU_RT_LOG_H_
+#define GAMMOU_RT_LOG_H_
+
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+
+#include "mpsc_queue.h"
+
+#if defined(__GNUC__)
+#define GAMMOU_PRINTF_FORMAT(format_index, first_arg_index) \
+    __attribute__((format(printf, format_index, first_arg_index)))
+#else
+#define GAMMOU_PRINTF_FORMAT(format_index, first_arg_index)
+#endif
+
+namespace Gammou {
+
+    /**
+     * \class realtime_logger
+     * \brief A logger which can be used on the sound processing thread.
+     *
+     *  Messages are formatted by the caller into a preallocated lock free ring, and written
+     *  to the output by a background thread. Logging never allocates, locks or blocks :
+     *  when the ring is full the message is dropped and counted.
+     *  Messages are kept in the ring until the logger is started.
+     */
+    class realtime_logger {
+    public:
+        //  Short names : DEBUG and ERROR are macros on some platforms
+        enum class level
+        {
+            DBG, INFO, WARN, ERR
+        };
+
+        static constexpr std::size_t max_message_size = 248u;
+        static constexpr std::size_t ring_capacity = 512u;
+
+        static realtime_logger& instance();
+
+        realtime_logger(const realtime_logger&) = delete;
+        realtime_logger& operator=(const realtime_logger&) = delete;
+        ~realtime_logger();
+
+        /**
+         *  \brief Start writing the messages to output from the background thread.
+         *  Does nothing if the logger is already started
+         */
+        void start(std::FILE *output = stdout);
+
+        /**
+         *  \brief Start writing the messages to a file
+         *  \throw std::runtime_error if the file can't be opened
+         */
+        void start(const std::filesystem::path& path);
+
+        /**
+         *  \brief Write the pending messages and stop the background thread
+         */
+        void stop();
+
+        /**
+         *  \brief Set the minimum level of the logged messages
+         */
+        void set_level(level min_level) noexcept { _min_level = min_level; }
+
+        /**
+         *  \brief Format a message and queue it, from any thread
+         *  \note Long messages are truncated to max_message_size
+         */
+        void log(level message_level, const char *format, ...) noexcept GAMMOU_PRINTF_FORMAT(3, 4);
+
+        /**
+         *  \brief Return the number of messages dropped because the ring was full
+         */
+        std::size_t dropped_count() const noexcept { return _dropped_count.load(std::memory_order_relaxed); }
+
+    private:
+        struct message
+        {
+            char text[max_message_size];
+        };
+
+        realtime_logger() = default;
+
+        void _drain() noexcept;
+
+        mpsc_queue<message, ring_capacity> _ring{};
+#ifdef NDEBUG
+        std::atomic<level> _min_level{level::INFO};
+#else
+        std::atomic<level> _min_level{level::DBG};
+#endif
+        std::atomic<std::size_t> _dropped_count{0u};
+        std::size_t _reported_dropped_count{0u};
+
+        std::FILE *_output{nullptr};
+        bool _owns_output{false};
+        std::thread _drain_thread{};
+        std::atomic<bool> _running{false};
+    };
+
+}
+
+/*
+ *  Logging macros for the real time paths, \see realtime_logger
+ */
+#define RT_LOG_DEBUG(...)   ::Gammou::realtime_logger::instance().log(::Gammou::realtime_logger::level::DBG, __VA_ARGS__)
+#define RT_LOG_INFO(...)    ::Gammou::realtime_logger::instance().log(::Gammou::realtime_logger::level::INFO, __VA_ARGS__)
+#define RT_LOG_WARNING(...) ::Gammou::realtime_logger::instance().log(::Gammou::realtime_logger::level::WARN, __VA_ARGS__)
+#define RT_LOG_ERROR(...)   ::Gammou::realtime_logger::instance().log(::Gammou::realtime_logger::level::ERR, __VA_ARGS__)
+
+#endif
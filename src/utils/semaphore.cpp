@@ -0,0 +1,90 @@
+
+#include <cerrno>
+#include <climits>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "semaphore.h"
+
+namespace Gammou {
+
+#if defined(_WIN32)
+
+    semaphore::semaphore()
+    :   _handle{CreateSemaphoreA(nullptr, 0, LONG_MAX, nullptr)}
+    {
+        if (_handle == nullptr)
+            throw std::runtime_error("semaphore : unable to create the semaphore");
+    }
+
+    semaphore::~semaphore()
+    {
+        CloseHandle(_handle);
+    }
+
+    void semaphore::release(std::size_t count) noexcept
+    {
+        ReleaseSemaphore(_handle, static_cast<LONG>(count), nullptr);
+    }
+
+    void semaphore::acquire() noexcept
+    {
+        WaitForSingleObject(_handle, INFINITE);
+    }
+
+#elif defined(__APPLE__)
+
+    semaphore::semaphore()
+    :   _semaphore{dispatch_semaphore_create(0)}
+    {
+        if (_semaphore == nullptr)
+            throw std::runtime_error("semaphore : unable to create the semaphore");
+    }
+
+    semaphore::~semaphore()
+    {
+        dispatch_release(_semaphore);
+    }
+
+    void semaphore::release(std::size_t count) noexcept
+    {
+        for (auto i = 0u; i < count; ++i)
+            dispatch_semaphore_signal(_semaphore);
+    }
+
+    void semaphore::acquire() noexcept
+    {
+        dispatch_semaphore_wait(_semaphore, DISPATCH_TIME_FOREVER);
+    }
+
+#else
+
+    semaphore::semaphore()
+    {
+        if (sem_init(&_semaphore, 0, 0u) != 0)
+            throw std::runtime_error("semaphore : unable to create the semaphore");
+    }
+
+    semaphore::~semaphore()
+    {
+        sem_destroy(&_semaphore);
+    }
+
+    void semaphore::release(std::size_t count) noexcept
+    {
+        for (auto i = 0u; i < count; ++i)
+            sem_post(&_semaphore);
+    }
+
+    void semaphore::acquire() noexcept
+    {
+        while (sem_wait(&_semaphore) != 0 && errno == EINTR)
+            ;
+    }
+
+#endif
+
+}
@@ -0,0 +1,44 @@
+#ifndef GAMMOU_SEMAPHORE_H_
+#define GAMMOU_SEMAPHORE_H_
+
+#include <cstddef>
+
+#if defined(_WIN32)
+#elif defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#else
+#include <semaphore.h>
+#endif
+
+namespace Gammou {
+
+    /**
+     * \class semaphore
+     * \brief A counting semaphore, released without taking any lock.
+     *
+     *  Release only makes a system call when a thread is waiting (futex based on linux).
+     */
+    class semaphore {
+    public:
+        semaphore();
+        ~semaphore();
+
+        semaphore(const semaphore&) = delete;
+        semaphore& operator=(const semaphore&) = delete;
+
+        void release(std::size_t count = 1u) noexcept;
+        void acquire() noexcept;
+
+    private:
+#if defined(_WIN32)
+        void *_handle;
+#elif defined(__APPLE__)
+        dispatch_semaphore_t _semaphore;
+#else
+        sem_t _semaphore;
+#endif
+    };
+
+}
+
+#endif /* GAMMOU_SEMAPHORE_H_ */
@@ -0,0 +1,84 @@
+#ifndef GAMMOU_SPSC_QUEUE_H_
+#define GAMMOU_SPSC_QUEUE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace Gammou {
+
+    /**
+     * \class spsc_queue
+     * \brief A fixed capacity, wait free, single producer single consumer queue.
+     *
+     *  Used to pass values out of (or into) the sound processing thread : push and pop
+     *  never allocate nor lock. When the queue is full, push fails and the value is dropped.
+     * \tparam Capacity must be a power of two
+     */
+    template <typename T, std::size_t Capacity>
+    class spsc_queue {
+        static_assert((Capacity & (Capacity - 1u)) == 0u, "Capacity must be a power of two");
+        static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+
+    public:
+        static constexpr std::size_t cache_line_size = 64u;
+
+        /**
+         * \brief Push a value, from the producer thread
+         * \return false if the queue was full
+         */
+        bool push(const T& value) noexcept
+        {
+            const auto write_index = _write_index.load(std::memory_order_relaxed);
+
+            if (write_index - _read_index.load(std::memory_order_acquire) == Capacity)
+                return false;
+
+            _values[write_index & (Capacity - 1u)] = value;
+            _write_index.store(write_index + 1u, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * \brief Pop a value, from the consumer thread
+         * \return false if the queue was empty
+         */
+        bool pop(T& value) noexcept
+        {
+            const auto read_index = _read_index.load(std::memory_order_relaxed);
+
+            if (read_index == _write_index.load(std::memory_order_acquire))
+                return false;
+
+            value = _values[read_index & (Capacity - 1u)];
+            _read_index.store(read_index + 1u, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * \brief Pop every available value and pass them to func, from the consumer thread
+         */
+        template <typename Func>
+        void consume_all(Func&& func)
+        {
+            T value;
+            while (pop(value))
+                func(value);
+        }
+
+        bool empty() const noexcept
+        {
+            return _read_index.load(std::memory_order_acquire) == _write_index.load(std::memory_order_acquire);
+        }
+
+    private:
+        //  Indices are on distinct cache lines to avoid false sharing between producer and consumer
+        alignas(cache_line_size) std::atomic<std::size_t> _write_index{0u};
+        alignas(cache_line_size) std::atomic<std::size_t> _read_index{0u};
+        alignas(cache_line_size) std::array<T, Capacity> _values{};
+    };
+
+}
+
+#endif /* GAMMOU_SPSC_QUEUE_H_ */
@@ -0,0 +1,98 @@
+#ifndef GAMMOU_STATE_BLOB_H_
+#define GAMMOU_STATE_BLOB_H_
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace Gammou {
+
+    /**
+     * \class state_writer
+     * \brief Append trivially copyable values to a binary blob, in the native byte order.
+     *  Used to snapshot the runtime state of the synthesizer : a blob is only meant to be
+     *  restored on the same machine and build.
+     */
+    class state_writer {
+    public:
+        template <typename T>
+        void write(const T& value)
+        {
+            write_array(&value, 1u);
+        }
+
+        template <typename T>
+        void write_array(const T *values, std::size_t count)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+            const auto *bytes = reinterpret_cast<const uint8_t*>(values);
+            _data.insert(_data.end(), bytes, bytes + count * sizeof(T));
+        }
+
+        template <typename TContainer>
+        void write_container(const TContainer& container)
+        {
+            write<uint64_t>(container.size());
+            write_array(container.data(), container.size());
+        }
+
+        std::vector<uint8_t> release() noexcept { return std::move(_data); }
+
+    private:
+        std::vector<uint8_t> _data{};
+    };
+
+    /**
+     * \class state_reader
+     * \brief Read the values written by a state_writer
+     * \throw std::invalid_argument when reading past the end of the blob
+     */
+    class state_reader {
+    public:
+        state_reader(const uint8_t *data, std::size_t size) noexcept
+        :   _data{data}, _size{size}
+        {}
+
+        template <typename T>
+        T read()
+        {
+            T value;
+            read_array(&value, 1u);
+            return value;
+        }
+
+        template <typename T>
+        void read_array(T *values, std::size_t count)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+            const auto byte_count = count * sizeof(T);
+            if (byte_count > _size - _position)
+                throw std::invalid_argument("state_reader : truncated state");
+            std::memcpy(values, _data + _position, byte_count);
+            _position += byte_count;
+        }
+
+        /**
+         *  \brief Read a container written by write_container, whose size must be expected_size
+         */
+        template <typename TContainer>
+        void read_container(TContainer& container, std::size_t expected_size)
+        {
+            if (read<uint64_t>() != expected_size)
+                throw std::invalid_argument("state_reader : incompatible state");
+            read_array(container.data(), expected_size);
+        }
+
+        bool at_end() const noexcept { return _position == _size; }
+
+    private:
+        const uint8_t *_data;
+        std::size_t _size;
+        std::size_t _position{0u};
+    };
+
+}
+
+#endif
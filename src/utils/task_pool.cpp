@@ -0,0 +1,160 @@
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include "task_pool.h"
+
+namespace Gammou {
+
+    //  Longest time an idle worker spins waiting for a new batch before sleeping
+    static constexpr std::chrono::nanoseconds max_spin_duration = std::chrono::microseconds{500};
+
+    static constexpr auto index_bits = 24u;
+    static constexpr auto index_mask = (uint64_t{1u} << index_bits) - 1u;
+    static constexpr auto generation_mask = uint64_t{0xFFFFu};
+
+    static inline uint64_t make_range(unsigned int generation, std::size_t next, std::size_t end) noexcept
+    {
+        return ((generation & generation_mask) << (2u * index_bits)) | (uint64_t{next} << index_bits) | uint64_t{end};
+    }
+
+    static inline void cpu_relax() noexcept
+    {
+#if defined(__SSE2__) || defined(_M_X64)
+        _mm_pause();
+#endif
+    }
+
+    task_pool::task_pool(std::size_t worker_count)
+    :   _ranges{std::make_unique<task_range[]>(worker_count + 1u)}
+    {
+        _workers.reserve(worker_count);
+        for (auto i = 0u; i < worker_count; ++i)
+            _workers.emplace_back([this, i]() { _worker_loop(i + 1u); });
+    }
+
+    task_pool::~task_pool()
+    {
+        _running = false;
+        _generation++;
+        _wake_semaphore.release(_sleeping_count.exchange(0u));
+
+        for (auto& worker : _workers)
+            worker.join();
+    }
+
+    void task_pool::_run(std::size_t task_count, task_function function, void *context) noexcept
+    {
+        if (task_count == 0u)
+            return;
+
+        const auto participant_count = _workers.size() + 1u;
+        const auto generation = _generation.load(std::memory_order_relaxed) + 1u;
+
+        _function = function;
+        _context = context;
+        _done_count.store(0u, std::memory_order_relaxed);
+
+        for (auto i = 0u; i < participant_count; ++i) {
+            _ranges[i].state.store(
+                make_range(
+                    generation,
+                    task_count * i / participant_count,
+                    task_count * (i + 1u) / participant_count),
+                std::memory_order_relaxed);
+        }
+
+        //  Publish the batch, and wake up the workers which went to sleep.
+        //  A worker registered as sleeping after the exchange will see the new generation
+        _generation.store(generation);
+        if (const auto sleeping_count = _sleeping_count.exchange(0u); sleeping_count != 0u)
+            _wake_semaphore.release(sleeping_count);
+
+        _execute_tasks(0u, generation);
+
+        while (_done_count.load(std::memory_order_acquire) != task_count)
+            cpu_relax();
+    }
+
+    void task_pool::_worker_loop(std::size_t participant)
+    {
+        using clock = std::chrono::steady_clock;
+
+        auto seen_generation = _generation.load();
+        std::chrono::nanoseconds average_wait{0};
+        std::chrono::nanoseconds spin_duration{0};
+
+        for (;;) {
+            //  Wait for a new batch : spin first, then sleep
+            const auto wait_start = clock::now();
+            const auto spin_end = wait_start + spin_duration;
+            while (_generation.load() == seen_generation && clock::now() < spin_end)
+                cpu_relax();
+
+            if (_generation.load() == seen_generation) {
+                _sleeping_count.fetch_add(1u);
+
+                if (_generation.load() == seen_generation) {
+                    _wake_semaphore.acquire();
+                }
+                else {
+                    //  A batch was published meanwhile : withdraw, unless the sleeping workers were already
+                    //  counted by the publisher, in which case the semaphore is released for this worker
+                    auto sleeping_count = _sleeping_count.load();
+                    while (sleeping_count != 0u && !_sleeping_count.compare_exchange_weak(sleeping_count, sleeping_count - 1u))
+                        ;
+                    if (sleeping_count == 0u)
+                        _wake_semaphore.acquire();
+                }
+            }
+
+            if (!_running)
+                return;
+
+            //  Spin a bit longer than the usual wait between the batches, but do not spin at all when they are
+            //  too far apart : the cpu time would be wasted while the wake up latency is small compared to the wait
+            average_wait = (3 * average_wait + (clock::now() - wait_start)) / 4;
+            spin_duration = (average_wait < max_spin_duration) ?
+                std::min(max_spin_duration, average_wait + average_wait / 4) : std::chrono::nanoseconds{0};
+
+            seen_generation = _generation.load();
+            _execute_tasks(participant, seen_generation);
+        }
+    }
+
+    void task_pool::_execute_tasks(std::size_t participant, unsigned int generation) noexcept
+    {
+        const auto participant_count = _workers.size() + 1u;
+        const auto range_generation = generation & generation_mask;
+        std::size_t done_count = 0u;
+
+        //  Own range first, then steal from the others
+        for (auto i = 0u; i < participant_count; ++i) {
+            auto& range = _ranges[(participant + i) % participant_count];
+            auto state = range.state.load(std::memory_order_acquire);
+
+            for (;;) {
+                const auto next = (state >> index_bits) & index_mask;
+                const auto end = state & index_mask;
+
+                //  The range belongs to another batch, or is exhausted
+                if ((state >> (2u * index_bits)) != range_generation || next >= end)
+                    break;
+
+                if (range.state.compare_exchange_weak(state, state + (uint64_t{1u} << index_bits), std::memory_order_acq_rel)) {
+                    _function(_context, static_cast<std::size_t>(next));
+                    done_count++;
+                    state = range.state.load(std::memory_order_acquire);
+                }
+            }
+        }
+
+        if (done_count != 0u)
+            _done_count.fetch_add(done_count, std::memory_order_release);
+    }
+
+}
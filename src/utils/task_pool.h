@@ -0,0 +1,94 @@
+#ifndef GAMMOU_TASK_POOL_H_
+#define GAMMOU_TASK_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "semaphore.h"
+
+namespace Gammou {
+
+    /**
+     * \class task_pool
+     * \brief A fixed set of worker threads running batches of indexed tasks, used to split
+     *  the processing of a block among several cores.
+     *
+     *  The tasks of a batch are split in one range per participant (the workers and the calling
+     *  thread). Each participant claims the tasks of its own range and, when it is exhausted,
+     *  steals the remaining tasks of the other ranges. Claiming a task is a compare and swap on
+     *  the range, which also holds the batch generation so that a late worker can not claim a task
+     *  of another batch. Running a batch never allocates.
+     *
+     *  Idle policy : between batches the workers spin for a short time, so that consecutive
+     *  blocks are picked up without waking any thread, then sleep on a semaphore until the next batch.
+     *  The spin adapts to the average time between batches : a bit longer than this time when it is under
+     *  500 us, and no spin at all otherwise (large blocks), so that idle workers do not burn cpu time.
+     *  Publishing a batch never takes a lock : the calling thread only releases the semaphore, once per
+     *  sleeping worker, which costs a system call only when some worker actually sleeps.
+     */
+    class task_pool {
+    public:
+        /**
+         *  \param worker_count number of threads created in addition to the calling thread
+         */
+        explicit task_pool(std::size_t worker_count);
+        ~task_pool();
+
+        task_pool(const task_pool&) = delete;
+        task_pool& operator=(const task_pool&) = delete;
+
+        std::size_t worker_count() const noexcept { return _workers.size(); }
+
+        /**
+         *  \brief Run func(0), ..., func(task_count - 1) on the workers and the calling thread,
+         *  and return when every task is done.
+         *  \note Must not be called concurrently from several threads. At most 2^24 tasks
+         */
+        template <typename Func>
+        void run(std::size_t task_count, Func& func) noexcept
+        {
+            _run(
+                task_count,
+                [](void *context, std::size_t task) { (*static_cast<Func*>(context))(task); },
+                &func);
+        }
+
+    private:
+        using task_function = void (*)(void*, std::size_t);
+        static constexpr std::size_t cache_line_size = 64u;
+
+        /*
+         *  The tasks of a participant : [next, end) packed with the batch generation
+         *  | generation (16 bits) | next (24 bits) | end (24 bits) |
+         */
+        struct alignas(cache_line_size) task_range
+        {
+            std::atomic<uint64_t> state{0u};
+        };
+
+        void _run(std::size_t task_count, task_function function, void *context) noexcept;
+        void _worker_loop(std::size_t participant);
+        void _execute_tasks(std::size_t participant, unsigned int generation) noexcept;
+
+        std::vector<std::thread> _workers{};
+        std::unique_ptr<task_range[]> _ranges;
+
+        //  Current batch
+        task_function _function{nullptr};
+        void *_context{nullptr};
+        std::atomic<std::size_t> _done_count{0u};
+        std::atomic<unsigned int> _generation{0u};
+        std::atomic<bool> _running{true};
+
+        //  Sleeping workers
+        semaphore _wake_semaphore{};
+        std::atomic<std::size_t> _sleeping_count{0u};   //<< Workers which will wait on the semaphore
+    };
+
+}
+
+#endif
@@ -0,0 +1,89 @@
+#include <limits>
+#include <stdexcept>
+
+#include "wav_writer.h"
+
+namespace Gammou {
+
+    static constexpr uint16_t WAVE_FMT_FLOAT = 0x0003u;
+    static constexpr auto header_size = 44u;
+
+    static void write_le(std::ofstream& stream, uint32_t value, std::size_t byte_count)
+    {
+        for (auto i = 0u; i < byte_count; ++i)
+            stream.put(static_cast<char>((value >> (8u * i)) & 0xFFu));
+    }
+
+    wav_writer::wav_writer(const std::filesystem::path& path, unsigned int sample_rate, unsigned int channel_count)
+    :   _stream{path, std::ios::binary | std::ios::trunc},
+        _sample_rate{sample_rate},
+        _channel_count{channel_count}
+    {
+        if (!_stream.is_open())
+            throw std::invalid_argument("wav writer : unable to create the specified path");
+        if (channel_count == 0u)
+            throw std::invalid_argument("wav writer : no channel");
+
+        //  Written again with the actual sizes by close()
+        _write_header();
+    }
+
+    wav_writer::~wav_writer() noexcept
+    {
+        try {
+            close();
+        }
+        catch (...) {}
+    }
+
+    void wav_writer::write(const float samples[], std::size_t frame_count)
+    {
+        //  As the wav loader, assume a little endian host
+        _stream.write(
+            reinterpret_cast<const char*>(samples),
+            static_cast<std::streamsize>(frame_count * _channel_count * sizeof(float)));
+        _frame_count += frame_count;
+
+        if (!_stream.good())
+            throw std::runtime_error("wav writer : write failure");
+    }
+
+    void wav_writer::close()
+    {
+        if (!_stream.is_open())
+            return;
+
+        _stream.seekp(0);
+        _write_header();
+        _stream.close();
+
+        if (_stream.fail())
+            throw std::runtime_error("wav writer : write failure");
+    }
+
+    void wav_writer::_write_header()
+    {
+        const auto byte_per_block = _channel_count * sizeof(float);
+        const auto data_size = static_cast<uint64_t>(_frame_count) * byte_per_block;
+
+        if (data_size > std::numeric_limits<uint32_t>::max() - header_size)
+            throw std::runtime_error("wav writer : file is too large");
+
+        _stream.write("RIFF", 4);
+        write_le(_stream, static_cast<uint32_t>(data_size + header_size - 8u), 4u);
+        _stream.write("WAVE", 4);
+
+        _stream.write("fmt ", 4);
+        write_le(_stream, 16u, 4u);
+        write_le(_stream, WAVE_FMT_FLOAT, 2u);
+        write_le(_stream, _channel_count, 2u);
+        write_le(_stream, _sample_rate, 4u);
+        write_le(_stream, static_cast<uint32_t>(_sample_rate * byte_per_block), 4u);
+        write_le(_stream, static_cast<uint32_t>(byte_per_block), 2u);
+        write_le(_stream, 32u, 2u);
+
+        _stream.write("data", 4);
+        write_le(_stream, static_cast<uint32_t>(data_size), 4u);
+    }
+
+}
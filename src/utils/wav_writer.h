@@ -0,0 +1,52 @@
+#ifndef GAMMOU_WAV_WRITER_H_
+#define GAMMOU_WAV_WRITER_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+
+namespace Gammou {
+
+    /**
+     * \class wav_writer
+     * \brief Write interleaved samples to a 32 bits float wav file, as they are produced.
+     *  The header sizes are updated by close(), called by the destructor if needed.
+     */
+    class wav_writer {
+    public:
+        /**
+         * \throw std::invalid_argument if the file can not be created
+         */
+        wav_writer(const std::filesystem::path& path, unsigned int sample_rate, unsigned int channel_count);
+        ~wav_writer() noexcept;
+
+        wav_writer(const wav_writer&) = delete;
+        wav_writer& operator=(const wav_writer&) = delete;
+
+        /**
+         * \param samples interleaved samples [ch0, ch1, ..., chN, ch0, ch1, ..., chN, ...]
+         * \param frame_count number of samples per channel
+         * \throw std::runtime_error on write failure
+         */
+        void write(const float samples[], std::size_t frame_count);
+
+        /**
+         * \brief Complete the file header and close the file
+         * \throw std::runtime_error on write failure, or if the file is too large
+         */
+        void close();
+
+        std::size_t get_frame_count() const noexcept { return _frame_count; }
+
+    private:
+        void _write_header();
+
+        std::ofstream _stream;
+        const unsigned int _sample_rate;
+        const unsigned int _channel_count;
+        std::size_t _frame_count{0u};
+    };
+
+}
+
+#endif /* GAMMOU_WAV_WRITER_H_ */
@@ -0,0 +1,175 @@
+/*
+ *  Compare the waveguide node state layouts : the delay stored after the queues (previous layout),
+ *  the hot variables declared before the queues (current layout), and the
+ *  hot variables padded to a cache line before the queues.
+ *
+ *  The node code is the one of packages/waveguides/waveguide/process.c. As in a polyphonic circuit,
+ *  one state per voice is allocated in a single block and every state is processed at each sample.
+ *
+ *  Build and run from the repository root :
+ *      cc -O2 -Isrc/packages/common -Isrc/packages/waveguides/common_libs \
+ *          tools/state_layout_benchmark.c src/packages/waveguides/common_libs/sample_queue.c -lm
+ *      ./a.out [voice count] [sample count]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <synthesizer_def.h>
+#include <sample_queue.h>
+
+const float _sample_rate = 48000.f;
+const float _sample_duration = 1.f / 48000.f;
+
+//  Waveguide state parameters (packages/waveguides/waveguide/plugin.json)
+#define STATE_MAX_DELAY_MS 210u
+#define STATE_MAX_SAMPLE_RATE 48000u
+#define QUEUE_SIZE (STATE_MAX_DELAY_MS * STATE_MAX_SAMPLE_RATE / 1000u + 2u)
+
+struct previous_waveguide_state {
+    int write_idx_p;
+    int write_idx_m;
+    int size;
+    float data_p[QUEUE_SIZE];
+    float data_m[QUEUE_SIZE];
+    float delay;
+};
+
+struct current_waveguide_state {
+    int write_idx_p;
+    int write_idx_m;
+    int size;
+    float delay;
+    float data_p[QUEUE_SIZE];
+    float data_m[QUEUE_SIZE];
+};
+
+struct padded_waveguide_state {
+    int write_idx_p;
+    int write_idx_m;
+    int size;
+    float delay;
+    char padding[64u - 3u * sizeof(int) - sizeof(float)];
+    float data_p[QUEUE_SIZE];
+    float data_m[QUEUE_SIZE];
+};
+
+//  Same code for every layout : only the field offsets change
+#define DEFINE_WAVEGUIDE_NODE(layout)                                                                   \
+    static void layout##_initialize(struct layout##_waveguide_state *state)                            \
+    {                                                                                                   \
+        const unsigned int size = (unsigned int)(0.001f * STATE_MAX_DELAY_MS * _sample_rate) + 2u;     \
+        state->write_idx_p = 0;                                                                         \
+        state->write_idx_m = 0;                                                                         \
+        state->size = size < QUEUE_SIZE ? size : QUEUE_SIZE;                                            \
+        state->delay = _sample_duration;                                                                \
+        for (int i = 0; i < state->size; ++i)                                                           \
+            state->data_p[i] = 0.f;                                                                     \
+        for (int i = 0; i < state->size; ++i)                                                           \
+            state->data_m[i] = 0.f;                                                                     \
+    }                                                                                                   \
+                                                                                                        \
+    static void layout##_push(struct layout##_waveguide_state *state, float in_m, float t, float g, float in_p) \
+    {                                                                                                   \
+        const float max_delay = (float)(state->size - 1) * _sample_duration;                           \
+        const float delay = fminf(t > _sample_duration ? t : _sample_duration, max_delay);             \
+        const float gain = powf(g, delay);                                                              \
+        state->delay = delay;                                                                           \
+        queue_write_sample(gain * in_p, &(state->write_idx_p), state->data_p, state->size);            \
+        queue_write_sample(gain * in_m, &(state->write_idx_m), state->data_m, state->size);            \
+    }                                                                                                   \
+                                                                                                        \
+    static void layout##_pull(struct layout##_waveguide_state *state, float *out_p, float *out_m)      \
+    {                                                                                                   \
+        const float fidx = state->delay * _sample_rate - 1.f;                                           \
+        const unsigned int idx = (unsigned int)fidx;                                                    \
+        const float factor = fidx - (float)idx;                                                         \
+        *out_p = (                                                                                      \
+            queue_read_sample(idx, state->write_idx_p, state->data_p, state->size) * (1.f - factor) +  \
+            queue_read_sample(idx + 1, state->write_idx_p, state->data_p, state->size) * factor);      \
+        *out_m = (                                                                                      \
+            queue_read_sample(idx, state->write_idx_m, state->data_m, state->size) * (1.f - factor) +  \
+            queue_read_sample(idx + 1, state->write_idx_m, state->data_m, state->size) * factor);      \
+    }                                                                                                   \
+                                                                                                        \
+    static double layout##_run(unsigned int voice_count, unsigned int sample_count, float *checksum)    \
+    {                                                                                                   \
+        struct layout##_waveguide_state *states = malloc(voice_count * sizeof(*states));               \
+        struct timespec start, end;                                                                     \
+        float sum = 0.f;                                                                                \
+        if (states == NULL)                                                                             \
+            return -1.;                                                                                 \
+        for (unsigned int v = 0u; v < voice_count; ++v)                                                 \
+            layout##_initialize(&states[v]);                                                            \
+        timespec_get(&start, TIME_UTC);                                                                 \
+        for (unsigned int s = 0u; s < sample_count; ++s) {                                              \
+            const float in = (s & 64u) ? 0.5f : -0.5f;                                                  \
+            for (unsigned int v = 0u; v < voice_count; ++v) {                                           \
+                float out_p, out_m;                                                                     \
+                const float t = 0.001f * (float)(1u + v % 100u);                                        \
+                layout##_push(&states[v], in, t, 0.9f, in);                                             \
+                layout##_pull(&states[v], &out_p, &out_m);                                              \
+                sum += out_p - out_m;                                                                   \
+            }                                                                                           \
+        }                                                                                               \
+        timespec_get(&end, TIME_UTC);                                                                   \
+        free(states);                                                                                   \
+        *checksum = sum;                                                                                \
+        return (double)(end.tv_sec - start.tv_sec) * 1e9 + (double)(end.tv_nsec - start.tv_nsec);      \
+    }
+
+DEFINE_WAVEGUIDE_NODE(previous)
+DEFINE_WAVEGUIDE_NODE(current)
+DEFINE_WAVEGUIDE_NODE(padded)
+
+int main(int argc, char **argv)
+{
+    const unsigned int voice_count = argc > 1 ? (unsigned int)atoi(argv[1]) : 64u;
+    const unsigned int sample_count = argc > 2 ? (unsigned int)atoi(argv[2]) : 48000u;
+    const unsigned int repetition_count = 5u;
+    double previous_best = 0., current_best = 0., padded_best = 0.;
+    float previous_checksum = 0.f, current_checksum = 0.f, padded_checksum = 0.f;
+
+    if (voice_count == 0u || sample_count == 0u) {
+        fprintf(stderr, "usage: %s [voice count] [sample count]\n", argv[0]);
+        return 1;
+    }
+
+    //  Interleave the runs so that both layouts see the same machine load, keep the best of each
+    for (unsigned int r = 0u; r < repetition_count; ++r) {
+        const double previous_duration = previous_run(voice_count, sample_count, &previous_checksum);
+        const double current_duration = current_run(voice_count, sample_count, &current_checksum);
+        const double padded_duration = padded_run(voice_count, sample_count, &padded_checksum);
+
+        if (previous_duration < 0. || current_duration < 0. || padded_duration < 0.) {
+            fprintf(stderr, "Unable to allocate the node states\n");
+            return 1;
+        }
+
+        if (r == 0u || previous_duration < previous_best)
+            previous_best = previous_duration;
+        if (r == 0u || current_duration < current_best)
+            current_best = current_duration;
+        if (r == 0u || padded_duration < padded_best)
+            padded_best = padded_duration;
+    }
+
+    const double node_sample_count = (double)voice_count * (double)sample_count;
+    printf("%u voices, %u samples, state size %zu bytes\n",
+        voice_count, sample_count, sizeof(struct current_waveguide_state));
+    printf("previous layout (delay after the queues) : %.2f ns per node sample\n", previous_best / node_sample_count);
+    printf("current layout (hot variables first)     : %.2f ns per node sample, speedup %.3f\n",
+        current_best / node_sample_count, previous_best / current_best);
+    printf("padded layout (hot cache line first)     : %.2f ns per node sample, speedup %.3f\n",
+        padded_best / node_sample_count, previous_best / padded_best);
+
+    //  Every layout must compute the same signal
+    if (previous_checksum != current_checksum || previous_checksum != padded_checksum) {
+        fprintf(stderr, "The layouts did not compute the same output\n");
+        return 1;
+    }
+
+    return 0;
+}